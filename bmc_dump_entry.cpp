@@ -26,6 +26,8 @@ void Entry::delete_()
         lg2::error("Failed to delete dump file, errormsg: {ERROR}", "ERROR", e);
     }
 
+    removeDumpCopy(file);
+
     // Remove Dump entry D-bus object
     phosphor::dump::Entry::delete_();
 }
@@ -0,0 +1,193 @@
+#include "config.h"
+
+#include "collector_class.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <phosphor-logging/lg2.hpp>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+
+namespace
+{
+
+/** @brief Build time settings of a collector class */
+struct ClassConfig
+{
+    /** @brief Name of the class cgroup */
+    const char* name;
+    int nice;
+    /** @brief Best-effort level, -1 for the idle class */
+    int ioprio;
+    const char* cpuMax;
+    const char* ioMax;
+    const char* memoryMax;
+};
+
+constexpr ClassConfig bulkConfig{
+    "bulk",
+    COLLECTOR_BULK_NICE,
+    COLLECTOR_BULK_IOPRIO,
+    COLLECTOR_BULK_CPU_MAX,
+    COLLECTOR_BULK_IO_MAX,
+    COLLECTOR_BULK_MEMORY_MAX,
+};
+
+constexpr ClassConfig probeConfig{
+    "probe",
+    COLLECTOR_PROBE_NICE,
+    COLLECTOR_PROBE_IOPRIO,
+    COLLECTOR_PROBE_CPU_MAX,
+    COLLECTOR_PROBE_IO_MAX,
+    COLLECTOR_PROBE_MEMORY_MAX,
+};
+
+// From linux/ioprio.h
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+constexpr int IOPRIO_CLASS_BE = 2;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+
+/** @brief Write a cgroup interface file
+ *  @returns false on failure
+ */
+bool writeCgroupFile(const std::filesystem::path& path,
+                     const std::string& value)
+{
+    std::ofstream file(path);
+    file << value << std::flush;
+    return static_cast<bool>(file);
+}
+
+/** @brief Move the processes of the root cgroup to a leaf and enable the
+ *         controllers of the class cgroups
+ *  @details cgroup v2 only enables controllers for the children of a cgroup
+ *           without processes, and a delegated root still holds the dump
+ *           manager.
+ *  @returns false on failure
+ */
+bool prepareRoot(const std::filesystem::path& root)
+{
+    auto leaf = root / "manager";
+    std::error_code ec;
+    std::filesystem::create_directories(leaf, ec);
+    if (ec)
+    {
+        lg2::error("Failed to create the dump manager cgroup, "
+                   "CGROUP: {CGROUP}, ERROR: {ERROR}",
+                   "CGROUP", leaf, "ERROR", ec.message());
+        return false;
+    }
+
+    std::ifstream procs(root / "cgroup.procs");
+    std::string pid;
+    while (procs >> pid)
+    {
+        if (!writeCgroupFile(leaf / "cgroup.procs", pid))
+        {
+            lg2::error("Failed to move a process out of the collector cgroup "
+                       "root, CGROUP: {CGROUP}, PID: {PID}",
+                       "CGROUP", root, "PID", pid);
+            return false;
+        }
+    }
+
+    // The limits of the class cgroups need the controllers of the root
+    if (!writeCgroupFile(root / "cgroup.subtree_control", "+cpu +io +memory"))
+    {
+        lg2::error("Failed to enable the cgroup controllers, CGROUP: {CGROUP}",
+                   "CGROUP", root);
+        return false;
+    }
+    return true;
+}
+
+/** @brief Create and configure the cgroup of a class
+ *  @returns the cgroup path, empty if cgroups are not used or failed
+ */
+std::string createCgroup(const ClassConfig& config)
+{
+    std::filesystem::path root(COLLECTOR_CGROUP_ROOT);
+    if (root.empty())
+    {
+        return {};
+    }
+
+    static const bool ready = prepareRoot(root);
+    if (!ready)
+    {
+        // Without controllers the limits would silently not apply
+        return {};
+    }
+
+    auto path = root / config.name;
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec)
+    {
+        lg2::warning("Failed to create the collector cgroup, CGROUP: {CGROUP}, "
+                     "ERROR: {ERROR}",
+                     "CGROUP", path, "ERROR", ec.message());
+        return {};
+    }
+
+    const std::pair<const char*, const char*> limits[] = {
+        {"cpu.max", config.cpuMax},
+        {"io.max", config.ioMax},
+        {"memory.max", config.memoryMax},
+    };
+    for (const auto& [file, value] : limits)
+    {
+        if (*value != '\0' && !writeCgroupFile(path / file, value))
+        {
+            lg2::warning("Failed to set a collector cgroup limit, "
+                         "CGROUP: {CGROUP}, FILE: {FILE}, VALUE: {VALUE}",
+                         "CGROUP", path, "FILE", file, "VALUE", value);
+        }
+    }
+
+    return path;
+}
+
+SpawnOptions makeOptions(const ClassConfig& config)
+{
+    SpawnOptions options;
+    options.cgroup = createCgroup(config);
+    options.nice = config.nice;
+    if (config.ioprio < 0)
+    {
+        options.ioprio = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+    }
+    else
+    {
+        options.ioprio = (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) |
+                         config.ioprio;
+    }
+    return options;
+}
+
+} // namespace
+
+const SpawnOptions& collectorOptions(CollectorClass collectorClass)
+{
+    switch (collectorClass)
+    {
+        case CollectorClass::Bulk:
+        {
+            static const SpawnOptions bulk = makeOptions(bulkConfig);
+            return bulk;
+        }
+        case CollectorClass::Probe:
+        default:
+        {
+            static const SpawnOptions probe = makeOptions(probeConfig);
+            return probe;
+        }
+    }
+}
+
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "dump_spawner.hpp"
+
+namespace phosphor
+{
+namespace dump
+{
+
+/** @brief Resource classes of the dump collectors */
+enum class CollectorClass
+{
+    /** Long collections compressing lots of data, dreport and alike */
+    Bulk,
+    /** Short collections reading a device or a file */
+    Probe,
+};
+
+/** @brief Spawn options isolating the collectors of a class
+ *  @details Each class has its nice value, I/O priority and, when
+ *           COLLECTOR_CGROUP_ROOT is set, a cgroup with its cpu.max, io.max
+ *           and memory.max, created on first use. If the cgroup can not be
+ *           set up the collectors only get the priorities.
+ *
+ *  @param[in] collectorClass - Class of the collector.
+ *
+ *  @returns options to spawn the collector with
+ */
+const SpawnOptions& collectorOptions(CollectorClass collectorClass);
+
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,533 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "core_ingest.hpp"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/procfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace core
+{
+namespace ingest
+{
+
+namespace
+{
+
+/** copy buffer size */
+constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+/** ELF core notes are 4 byte aligned */
+constexpr size_t NOTE_ALIGN = 4;
+
+/** index of the stack pointer in elf_gregset_t */
+#if defined(__x86_64__)
+constexpr std::ptrdiff_t SP_INDEX = 19;
+#elif defined(__i386__)
+constexpr std::ptrdiff_t SP_INDEX = 15;
+#elif defined(__aarch64__)
+constexpr std::ptrdiff_t SP_INDEX = 31;
+#elif defined(__arm__)
+constexpr std::ptrdiff_t SP_INDEX = 13;
+#elif defined(__riscv)
+constexpr std::ptrdiff_t SP_INDEX = 2;
+#else
+constexpr std::ptrdiff_t SP_INDEX = -1;
+#endif
+
+#if defined(__LP64__)
+constexpr unsigned char NATIVE_CLASS = ELFCLASS64;
+#else
+constexpr unsigned char NATIVE_CLASS = ELFCLASS32;
+#endif
+
+size_t noteAlign(size_t size)
+{
+    return (size + NOTE_ALIGN - 1) & ~(NOTE_ALIGN - 1);
+}
+
+void writeAll(int fd, const void* buf, size_t size)
+{
+    auto data = static_cast<const char*>(buf);
+    while (size > 0)
+    {
+        auto rc = ::write(fd, data, size);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(),
+                                    "write failed");
+        }
+        data += rc;
+        size -= rc;
+    }
+}
+
+const char* dispositionName(Disposition disposition)
+{
+    switch (disposition)
+    {
+        case Disposition::Stack:
+            return "stack";
+        case Disposition::Writable:
+            return "writable";
+        case Disposition::ReadOnly:
+            return "readonly";
+        case Disposition::Elided:
+            break;
+    }
+    return "elided";
+}
+
+} // namespace
+
+void Ingest::read(void* buf, size_t size)
+{
+    auto data = static_cast<char*>(buf);
+    while (size > 0)
+    {
+        auto rc = ::read(inFd, data, size);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(),
+                                    "read failed");
+        }
+        if (rc == 0)
+        {
+            throw UnsupportedCore("Unexpected end of core file");
+        }
+        data += rc;
+        size -= rc;
+        inOffset += rc;
+    }
+}
+
+void Ingest::skip(uint64_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    if (::lseek(inFd, static_cast<off_t>(size), SEEK_CUR) >= 0)
+    {
+        inOffset += size;
+        return;
+    }
+
+    // Not seekable, e.g. a pipe from the decompressor
+    std::array<char, BUFFER_SIZE> buf;
+    while (size > 0)
+    {
+        auto chunk = std::min<uint64_t>(size, buf.size());
+        read(buf.data(), chunk);
+        size -= chunk;
+    }
+}
+
+void Ingest::copy(int outFd, uint64_t size)
+{
+    std::array<char, BUFFER_SIZE> buf;
+    while (size > 0)
+    {
+        auto chunk = std::min<uint64_t>(size, buf.size());
+        read(buf.data(), chunk);
+        writeAll(outFd, buf.data(), chunk);
+        size -= chunk;
+    }
+}
+
+void Ingest::parseNotes(const std::vector<char>& notes)
+{
+    size_t offset = 0;
+    while (offset + sizeof(ElfW(Nhdr)) <= notes.size())
+    {
+        ElfW(Nhdr) nhdr;
+        std::memcpy(&nhdr, notes.data() + offset, sizeof(nhdr));
+        offset += sizeof(nhdr) + noteAlign(nhdr.n_namesz);
+        if (offset + nhdr.n_descsz > notes.size())
+        {
+            break;
+        }
+        const char* desc = notes.data() + offset;
+        offset += noteAlign(nhdr.n_descsz);
+
+        if (nhdr.n_type == NT_PRSTATUS &&
+            nhdr.n_descsz >= sizeof(struct elf_prstatus))
+        {
+            if constexpr (SP_INDEX >= 0)
+            {
+                elf_greg_t sp;
+                std::memcpy(&sp,
+                            desc + offsetof(struct elf_prstatus, pr_reg) +
+                                SP_INDEX * sizeof(elf_greg_t),
+                            sizeof(sp));
+                stackPointers.push_back(sp);
+            }
+        }
+        else if (nhdr.n_type == NT_FILE && nhdr.n_descsz >= 2 * sizeof(long))
+        {
+            // count, page size, count * (start, end, offset), names
+            std::vector<unsigned long> words(nhdr.n_descsz / sizeof(long));
+            std::memcpy(words.data(), desc, words.size() * sizeof(long));
+            auto count = words[0];
+            auto namesOffset = (2 + 3 * count) * sizeof(long);
+            if (namesOffset > nhdr.n_descsz)
+            {
+                continue;
+            }
+            const char* name = desc + namesOffset;
+            const char* end = desc + nhdr.n_descsz;
+            for (unsigned long i = 0; i < count && name < end; i++)
+            {
+                auto len = strnlen(name, end - name);
+                mappedFiles.emplace(words[2 + 3 * i], std::string(name, len));
+                name += len + 1;
+            }
+        }
+    }
+}
+
+void Ingest::select(uint64_t overhead)
+{
+    uint64_t remaining = budget > overhead ? budget - overhead : 0;
+    auto take = [&remaining](Segment& segment, uint64_t skip,
+                             Disposition disposition) {
+        auto size = segment.phdr.p_filesz - skip;
+        if (size > remaining)
+        {
+            return;
+        }
+        segment.skip = skip;
+        segment.keep = size;
+        segment.disposition = disposition;
+        remaining -= size;
+    };
+
+    // Thread stacks, in note order so the crashing thread comes first. Only
+    // the live part from the stack pointer up is of interest.
+    auto pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    for (auto sp : stackPointers)
+    {
+        for (auto& segment : segments)
+        {
+            const auto& phdr = segment.phdr;
+            if (segment.disposition != Disposition::Elided ||
+                sp < phdr.p_vaddr || sp >= phdr.p_vaddr + phdr.p_filesz)
+            {
+                continue;
+            }
+            auto from = sp > STACK_BELOW_SP ? sp - STACK_BELOW_SP : 0;
+            from = std::max<uint64_t>(from & ~(pageSize - 1), phdr.p_vaddr);
+            take(segment, from - phdr.p_vaddr, Disposition::Stack);
+            break;
+        }
+    }
+
+    // Then the rest of the mappings, writable ones first and smaller ones
+    // first within a class so as many mappings as possible fit.
+    std::vector<Segment*> order;
+    for (auto& segment : segments)
+    {
+        if (segment.disposition == Disposition::Elided &&
+            segment.phdr.p_filesz > 0)
+        {
+            order.push_back(&segment);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Segment* a, const Segment* b) {
+        bool aw = a->phdr.p_flags & PF_W;
+        bool bw = b->phdr.p_flags & PF_W;
+        if (aw != bw)
+        {
+            return aw;
+        }
+        return a->phdr.p_filesz < b->phdr.p_filesz;
+    });
+    for (auto segment : order)
+    {
+        take(*segment, 0,
+             (segment->phdr.p_flags & PF_W) ? Disposition::Writable
+                                            : Disposition::ReadOnly);
+    }
+}
+
+void Ingest::writeElided(const Summary& summary) const
+{
+    std::ofstream file(outDir / (name + ELIDED_SUFFIX));
+    file << "# vaddr-range flags elided-bytes kept-as mapping\n";
+    for (const auto& segment : segments)
+    {
+        auto elided = segment.phdr.p_filesz - segment.keep;
+        if (elided == 0)
+        {
+            continue;
+        }
+        const auto& phdr = segment.phdr;
+        char range[64];
+        std::snprintf(range, sizeof(range), "0x%jx-0x%jx",
+                      static_cast<uintmax_t>(phdr.p_vaddr),
+                      static_cast<uintmax_t>(phdr.p_vaddr + phdr.p_memsz));
+        file << range << ' ' << ((phdr.p_flags & PF_R) ? 'r' : '-')
+             << ((phdr.p_flags & PF_W) ? 'w' : '-')
+             << ((phdr.p_flags & PF_X) ? 'x' : '-') << ' ' << elided << ' '
+             << dispositionName(segment.disposition) << ' '
+             << (segment.file.empty() ? "[anon]" : segment.file) << '\n';
+    }
+    file << "# input " << summary.inputBytes << " output "
+         << summary.outputBytes << " kept " << summary.keptBytes << " elided "
+         << summary.elidedBytes << " budget " << budget << " threads "
+         << summary.threads << '\n';
+    if (!file)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to write elided segment list");
+    }
+}
+
+Summary Ingest::run()
+{
+    ElfW(Ehdr) ehdr;
+    read(&ehdr, sizeof(ehdr));
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0)
+    {
+        throw UnsupportedCore("Not an ELF file");
+    }
+    if (ehdr.e_ident[EI_CLASS] != NATIVE_CLASS || ehdr.e_type != ET_CORE ||
+        ehdr.e_phentsize != sizeof(ElfW(Phdr)) || ehdr.e_phnum == 0 ||
+        ehdr.e_phnum == PN_XNUM || ehdr.e_phoff < sizeof(ehdr))
+    {
+        throw UnsupportedCore("Not a native ELF core file");
+    }
+
+    skip(ehdr.e_phoff - inOffset);
+    std::vector<ElfW(Phdr)> phdrs(ehdr.e_phnum);
+    read(phdrs.data(), phdrs.size() * sizeof(ElfW(Phdr)));
+
+    // Notes have to be seen before any memory segment data, as they decide
+    // which stack segments are kept. Linux always writes them first.
+    std::vector<const ElfW(Phdr)*> notePhdrs;
+    uint64_t firstLoad = UINT64_MAX;
+    for (const auto& phdr : phdrs)
+    {
+        if (phdr.p_type == PT_NOTE)
+        {
+            notePhdrs.push_back(&phdr);
+        }
+        else if (phdr.p_type == PT_LOAD)
+        {
+            Segment segment;
+            segment.phdr = phdr;
+            segments.push_back(std::move(segment));
+            if (phdr.p_filesz > 0)
+            {
+                firstLoad = std::min<uint64_t>(firstLoad, phdr.p_offset);
+            }
+        }
+    }
+    std::sort(notePhdrs.begin(), notePhdrs.end(),
+              [](auto a, auto b) { return a->p_offset < b->p_offset; });
+
+    std::vector<char> notes;
+    for (auto phdr : notePhdrs)
+    {
+        if (phdr->p_offset < inOffset ||
+            phdr->p_offset + phdr->p_filesz > firstLoad)
+        {
+            throw UnsupportedCore("Unexpected note segment layout");
+        }
+        skip(phdr->p_offset - inOffset);
+        auto start = notes.size();
+        notes.resize(start + phdr->p_filesz);
+        read(notes.data() + start, phdr->p_filesz);
+    }
+    parseNotes(notes);
+
+    // Segment data is copied in file order and laid out in the same order
+    // in the output. Linux writes the segments sorted by address, which is
+    // also file order, so this keeps the program headers sorted as well.
+    std::stable_sort(segments.begin(), segments.end(),
+                     [](const Segment& a, const Segment& b) {
+        return a.phdr.p_offset < b.phdr.p_offset;
+    });
+    for (auto& segment : segments)
+    {
+        auto file = mappedFiles.find(segment.phdr.p_vaddr);
+        if (file != mappedFiles.end())
+        {
+            segment.file = file->second;
+        }
+    }
+    // The headers and notes are kept whatever the budget, a split stack
+    // segment adds a program header
+    select(sizeof(ehdr) +
+           (phdrs.size() + stackPointers.size()) * sizeof(ElfW(Phdr)) +
+           notes.size());
+
+    // Output layout: ELF header, program headers, notes, kept segment data.
+    // A stack segment kept from the stack pointer up is split in two, the
+    // part below the stack pointer having no file data.
+    std::vector<ElfW(Phdr)> outPhdrs;
+    outPhdrs.reserve(phdrs.size() + stackPointers.size());
+    for (const auto& phdr : phdrs)
+    {
+        if (phdr.p_type != PT_LOAD)
+        {
+            outPhdrs.push_back(phdr);
+        }
+    }
+    for (const auto& segment : segments)
+    {
+        auto phdr = segment.phdr;
+        if (segment.skip > 0 && segment.keep > 0)
+        {
+            auto lower = phdr;
+            lower.p_memsz = segment.skip;
+            lower.p_filesz = 0;
+            outPhdrs.push_back(lower);
+            phdr.p_vaddr += segment.skip;
+            phdr.p_paddr = 0;
+            phdr.p_memsz -= segment.skip;
+        }
+        phdr.p_filesz = segment.keep;
+        outPhdrs.push_back(phdr);
+    }
+
+    uint64_t offset = sizeof(ehdr) + outPhdrs.size() * sizeof(ElfW(Phdr));
+    for (auto& phdr : outPhdrs)
+    {
+        if (phdr.p_type == PT_NOTE)
+        {
+            phdr.p_offset = offset;
+            offset += phdr.p_filesz;
+        }
+    }
+    for (auto& phdr : outPhdrs)
+    {
+        if (phdr.p_type != PT_LOAD)
+        {
+            continue;
+        }
+        phdr.p_offset = offset;
+        offset += phdr.p_filesz;
+    }
+
+    auto outPath = outDir / name;
+    int outFd = ::open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                       0640);
+    if (outFd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to create " + outPath.string());
+    }
+
+    Summary summary;
+    try
+    {
+        auto outEhdr = ehdr;
+        outEhdr.e_phoff = sizeof(outEhdr);
+        outEhdr.e_phnum = outPhdrs.size();
+        outEhdr.e_shoff = 0;
+        outEhdr.e_shnum = 0;
+        outEhdr.e_shstrndx = SHN_UNDEF;
+        writeAll(outFd, &outEhdr, sizeof(outEhdr));
+        writeAll(outFd, outPhdrs.data(),
+                 outPhdrs.size() * sizeof(ElfW(Phdr)));
+        writeAll(outFd, notes.data(), notes.size());
+
+        // Stream the memory segments, keeping what was selected and
+        // discarding the rest.
+        for (auto& segment : segments)
+        {
+            const auto& phdr = segment.phdr;
+            if (phdr.p_filesz == 0)
+            {
+                continue;
+            }
+            if (phdr.p_offset < inOffset)
+            {
+                throw UnsupportedCore("Overlapping memory segments");
+            }
+            skip(phdr.p_offset - inOffset + segment.skip);
+            copy(outFd, segment.keep);
+            skip(phdr.p_filesz - segment.skip - segment.keep);
+            summary.keptBytes += segment.keep;
+            summary.elidedBytes += phdr.p_filesz - segment.keep;
+        }
+
+        // Drain the input so a decompressor feeding us exits cleanly
+        std::array<char, BUFFER_SIZE> buf;
+        ssize_t rc;
+        while ((rc = ::read(inFd, buf.data(), buf.size())) > 0 ||
+               (rc < 0 && errno == EINTR))
+        {
+            inOffset += std::max<ssize_t>(rc, 0);
+        }
+
+        if (::close(outFd) < 0)
+        {
+            outFd = -1;
+            throw std::system_error(errno, std::generic_category(),
+                                    "close failed");
+        }
+        outFd = -1;
+
+        summary.inputBytes = inOffset;
+        summary.outputBytes = offset;
+        summary.threads = stackPointers.size();
+        writeElided(summary);
+    }
+    catch (...)
+    {
+        if (outFd >= 0)
+        {
+            ::close(outFd);
+        }
+        std::error_code ec;
+        std::filesystem::remove(outPath, ec);
+        std::filesystem::remove(outDir / (name + ELIDED_SUFFIX), ec);
+        throw;
+    }
+
+    return summary;
+}
+
+} // namespace ingest
+} // namespace core
+} // namespace dump
+} // namespace phosphor
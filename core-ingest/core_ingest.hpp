@@ -0,0 +1,183 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <link.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace core
+{
+namespace ingest
+{
+
+/** default size of the minimized core */
+constexpr uint64_t DEFAULT_BUDGET = 8 * 1024 * 1024;
+
+/** bytes kept below the stack pointer of every thread (red zone, signal
+ *  frames that are not yet unwound) */
+constexpr uint64_t STACK_BELOW_SP = 4096;
+
+/** suffix of the file describing what was left out of the minimized core */
+constexpr auto ELIDED_SUFFIX = ".elided";
+
+/**
+ * @brief Thrown when the input is not a core file this tool can minimize,
+ *        the caller is expected to fall back to copying the core as is.
+ */
+class UnsupportedCore : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/** @brief Why a memory segment did (not) make it into the minimized core */
+enum class Disposition
+{
+    Stack,
+    Writable,
+    ReadOnly,
+    Elided,
+};
+
+/** @brief One PT_LOAD segment of the input core */
+struct Segment
+{
+    ElfW(Phdr) phdr;
+    /** bytes skipped at the start of the segment data */
+    uint64_t skip = 0;
+    /** bytes of segment data kept in the output */
+    uint64_t keep = 0;
+    Disposition disposition = Disposition::Elided;
+    /** backing file of the mapping, from the NT_FILE note */
+    std::string file;
+};
+
+/** @brief Summary of one ingest run */
+struct Summary
+{
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    uint64_t keptBytes = 0;
+    uint64_t elidedBytes = 0;
+    size_t threads = 0;
+};
+
+/**
+ * @class Ingest
+ * @brief Streams a core file once and writes a minimized core into the dump.
+ *
+ * @details The ELF headers and all notes (registers, signal info, auxv,
+ *  mapped files) are always kept. Memory segments are kept in priority
+ *  order - thread stacks from the stack pointer up, then writable mappings,
+ *  then read-only mappings - until the budget left by the headers and notes
+ *  is used. Elided segments keep
+ *  their program header with a zero file size, so debuggers still see the
+ *  address space layout, and are listed in a ".elided" file next to the
+ *  minimized core.
+ *
+ *  The input is read strictly forward, so it can be a pipe from a
+ *  decompressor.
+ */
+class Ingest
+{
+  public:
+    Ingest() = delete;
+    Ingest(const Ingest&) = delete;
+    Ingest& operator=(const Ingest&) = delete;
+    Ingest(Ingest&&) = delete;
+    Ingest& operator=(Ingest&&) = delete;
+    ~Ingest() = default;
+
+    /** @brief Constructor
+     *  @param[in] inFd - file descriptor of the core, read sequentially.
+     *  @param[in] outDir - directory the minimized core is written into.
+     *  @param[in] name - file name of the minimized core.
+     *  @param[in] budget - size of the minimized core in bytes, headers
+     *                      and notes included.
+     */
+    Ingest(int inFd, const std::filesystem::path& outDir,
+           const std::string& name, uint64_t budget) :
+        inFd(inFd), outDir(outDir), name(name), budget(budget)
+    {}
+
+    /** @brief Minimize the core.
+     *  @return summary of the run.
+     *  @throws UnsupportedCore if the input can not be minimized,
+     *          std::system_error on I/O failures.
+     */
+    Summary run();
+
+  private:
+    /** @brief Read exactly size bytes from the input */
+    void read(void* buf, size_t size);
+
+    /** @brief Discard size bytes of the input */
+    void skip(uint64_t size);
+
+    /** @brief Copy size bytes of the input to the output */
+    void copy(int outFd, uint64_t size);
+
+    /** @brief Extract stack pointers and mapped files from the notes */
+    void parseNotes(const std::vector<char>& notes);
+
+    /** @brief Decide what is kept of every memory segment
+     *  @param[in] overhead - bytes of headers and notes in the output.
+     */
+    void select(uint64_t overhead);
+
+    /** @brief Write the list of elided segments */
+    void writeElided(const Summary& summary) const;
+
+    /** @brief Input file descriptor */
+    int inFd;
+
+    /** @brief Current offset in the input */
+    uint64_t inOffset = 0;
+
+    /** @brief Output directory */
+    std::filesystem::path outDir;
+
+    /** @brief Output file name */
+    std::string name;
+
+    /** @brief Size of the minimized core */
+    uint64_t budget;
+
+    /** @brief Memory segments of the core */
+    std::vector<Segment> segments;
+
+    /** @brief Stack pointer of every thread */
+    std::vector<uint64_t> stackPointers;
+
+    /** @brief Mapped files from NT_FILE, by start address */
+    std::map<uint64_t, std::string> mappedFiles;
+};
+
+} // namespace ingest
+} // namespace core
+} // namespace dump
+} // namespace phosphor
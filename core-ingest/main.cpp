@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "core_ingest.hpp"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <phosphor-logging/lg2.hpp>
+
+using namespace phosphor::dump::core::ingest;
+
+/** exit code telling the caller to fall back to copying the core */
+constexpr int EXIT_UNSUPPORTED = 2;
+
+void help()
+{
+    std::cout << "core-ingest [options] <core file|-> <output dir> <name>"
+              << std::endl;
+    std::cout << "Writes a minimized copy of the core file to <output dir>/"
+                 "<name>, reads the core from stdin when '-' is given."
+              << std::endl;
+    std::cout << "--help, -h:             ";
+    std::cout << "prints argument list and exits" << std::endl;
+    std::cout << "--budget, -b:           ";
+    std::cout << "size of the minimized core in bytes, default: ";
+    std::cout << DEFAULT_BUDGET << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    struct option opts[] = {{"help", no_argument, NULL, 'h'},
+                            {"budget", required_argument, NULL, 'b'},
+                            {0, 0, 0, 0}};
+
+    int c, option_index = 0;
+    uint64_t budget = DEFAULT_BUDGET;
+    while ((c = getopt_long(argc, argv, "hb:", opts, &option_index)) != -1)
+    {
+        switch (c)
+        {
+            case 'h':
+                help();
+                exit(0);
+
+            case 'b':
+            {
+                // strtoull accepts a sign and wraps a negative budget
+                char* end = nullptr;
+                errno = 0;
+                budget = std::strtoull(optarg, &end, 0);
+                if (optarg[0] == '-' || *end != '\0' || end == optarg ||
+                    errno != 0)
+                {
+                    std::cerr << "Invalid budget: " << optarg << std::endl;
+                    help();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+
+            default:
+                help();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3)
+    {
+        help();
+        exit(EXIT_FAILURE);
+    }
+    std::string input = argv[optind];
+    std::string outDir = argv[optind + 1];
+    std::string name = argv[optind + 2];
+
+    int inFd = STDIN_FILENO;
+    if (input != "-")
+    {
+        inFd = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+        if (inFd < 0)
+        {
+            lg2::error("Failed to open core file, PATH: {PATH}, ERRNO: {ERRNO}",
+                       "PATH", input, "ERRNO", errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int rc = EXIT_SUCCESS;
+    try
+    {
+        Ingest ingest(inFd, outDir, name, budget);
+        auto summary = ingest.run();
+        lg2::info("Minimized core file, PATH: {PATH}, INPUT: {INPUT}, "
+                  "OUTPUT: {OUTPUT}, ELIDED: {ELIDED}, THREADS: {THREADS}",
+                  "PATH", input, "INPUT", summary.inputBytes, "OUTPUT",
+                  summary.outputBytes, "ELIDED", summary.elidedBytes,
+                  "THREADS", summary.threads);
+    }
+    catch (const UnsupportedCore& e)
+    {
+        lg2::info("Core file not minimized, PATH: {PATH}, REASON: {REASON}",
+                  "PATH", input, "REASON", e.what());
+        rc = EXIT_UNSUPPORTED;
+    }
+    catch (const std::exception& e)
+    {
+        lg2::error("Failed to minimize core file, PATH: {PATH}, "
+                   "ERROR: {ERROR}",
+                   "PATH", input, "ERROR", e.what());
+        rc = EXIT_FAILURE;
+    }
+
+    if (inFd != STDIN_FILENO)
+    {
+        close(inFd);
+    }
+    return rc;
+}
@@ -17,10 +17,15 @@
 #include "create_dump_dbus.hpp"
 
 #include "../config.h"
+#include "dump_server.hpp"
 
 #define FMT_HEADER_ONLY
 
+#include <fcntl.h>
 #include <fmt/core.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/un.h>
@@ -32,6 +37,7 @@
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/exception.hpp>
@@ -49,6 +55,12 @@ using namespace phosphor::logging;
 
 std::string CreateDumpDbus::bmcDumpPath(BMC_DUMP_PATH);
 std::string CreateDumpDbus::systemDumpPath(SYSTEM_DUMP_PATH);
+std::string CreateDumpDbus::outputDir(TMP_DIR_PATH);
+
+std::string CreateDumpDbus::dumpCopyDir()
+{
+    return BMC_DUMP_COPY_PATH;
+}
 
 CreateDumpDbus::~CreateDumpDbus()
 {
@@ -73,266 +85,17 @@ void CreateDumpDbus::dispose()
     }
 }
 
-void CreateDumpDbus::waitForDumpCreation(const std::string& entryPath)
+std::string CreateDumpDbus::getDumpDir(const std::string& dPath)
 {
-    constexpr auto MAPPER_BUSNAME = "xyz.openbmc_project.Dump.Manager";
-    constexpr auto MAPPER_INTERFACE = "xyz.openbmc_project.Common.Progress";
-    constexpr auto PROPERTY_NAME = "Status";
-    constexpr auto STATUS_IN_PROGRESS =
-        "xyz.openbmc_project.Common.Progress.OperationStatus.InProgress";
-    constexpr auto STATUS_COMPLETED =
-        "xyz.openbmc_project.Common.Progress.OperationStatus.Completed";
-
-    int fails = 0;
-    unsigned time_p = 0;
-
-    while (true)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-
-        // if dump collector will not change status after 30 minutes throws
-        // exception
-        if (time_p > 1000 * 60 * 30)
-        {
-            throw CreateDumpDbusException("Dump creation timed out.");
-        }
-
-        try
-        {
-            auto b = bus::new_default();
-            auto m = b.new_method_call(MAPPER_BUSNAME, entryPath.c_str(),
-                                       "org.freedesktop.DBus.Properties",
-                                       "Get");
-            m.append(MAPPER_INTERFACE, PROPERTY_NAME);
-            auto reply = b.call(m);
-
-            std::variant<std::monostate, std::string> entry;
-            reply.read(entry);
-
-            if (std::get<1>(entry) != STATUS_IN_PROGRESS)
-            {
-                if (std::get<1>(entry) == STATUS_COMPLETED)
-                {
-                    return;
-                }
-                else
-                {
-                    throw CreateDumpDbusException("Dump creation failed.");
-                }
-            }
-        }
-        catch (const exception::exception& e)
-        {
-            fails++;
-
-            if (fails >= 3)
-            {
-                throw CreateDumpDbusException("Failed to get progress.");
-            }
-        }
-
-        time_p += 50;
-    }
-}
-
-int CreateDumpDbus::copyDumpToTmpDir(const std::string& dPath,
-                                     std::string& response)
-{
-    const auto copyOptions = std::filesystem::copy_options::update_existing;
-    auto dName = std::filesystem::path(dPath).filename().string();
-    std::string sourcePath;
     if (dPath.find("/system/") != std::string::npos)
     {
-        sourcePath = CreateDumpDbus::systemDumpPath;
-    }
-    else if (dPath.find("/bmc/") != std::string::npos)
-    {
-        sourcePath = CreateDumpDbus::bmcDumpPath;
-    }
-    else
-    {
-        log<level::ERR>("Unknown dump file path");
-        response = "Unknown dump file path";
-        return -1;
-    }
-    auto fPath = sourcePath + "/" + dName;
-
-    try
-    {
-        // wait for collector create dump file
-        CreateDumpDbus::waitForDumpCreation(response);
-    }
-    catch (CreateDumpDbusException& e)
-    {
-        log<level::ERR>(e.what().c_str());
-        response = e.what();
-        return -1;
-    }
-
-    unsigned time_p = 0;
-    while (true)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-
-        if (std::filesystem::exists(fPath))
-        {
-            for (auto& entry : std::filesystem::directory_iterator(fPath))
-            {
-                if (std::filesystem::is_regular_file(entry))
-                {
-                    std::string filename = entry.path().filename();
-                    filename.insert(0, DUMP_COPY_PREFIX);
-
-                    response = fmt::format("Copying {} to {} directory.",
-                                           entry.path().string(), TMP_DIR_PATH);
-
-                    std::filesystem::path dest(TMP_DIR_PATH);
-                    dest.append(filename);
-
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(1000));
-                    try
-                    {
-                        std::filesystem::copy(entry, dest, copyOptions);
-                    }
-                    catch (std::filesystem::filesystem_error& e)
-                    {
-                        response = e.what();
-                        return -1;
-                    }
-
-                    return 0;
-                }
-            }
-        }
-
-        time_p += 50;
-        if (time_p > TIMEOUT)
-        {
-            response = "Copying dump to tmp dir failed: timeout.";
-            return -1;
-        }
-    }
-}
-
-int CreateDumpDbus::createDump(const std::string& type, std::string& response)
-{
-    constexpr auto MAPPER_BUSNAME = "xyz.openbmc_project.Dump.Manager";
-    constexpr auto MAPPER_PATH_PREFIX = "/xyz/openbmc_project/dump/";
-    constexpr auto MAPPER_INTERFACE = "xyz.openbmc_project.Dump.Create";
-    constexpr auto METHOD_NAME = "CreateDump";
-
-    std::string path;
-    std::map<std::string, std::variant<std::string, uint64_t>> params;
-    params["DumpType"] = type;
-    std::map<std::string, std::string> paramMap{};
-    if (type.empty() || type == "BMC")
-    {
-        path = std::string(MAPPER_PATH_PREFIX) + "bmc";
-    }
-    else
-    {
-        path = std::string(MAPPER_PATH_PREFIX) + "system";
-        params["DiagnosticType"] = type;
-    }
-
-    auto bus = bus::new_default();
-    auto method = bus.new_method_call(MAPPER_BUSNAME, path.c_str(),
-                                      MAPPER_INTERFACE, METHOD_NAME);
-
-    method.append(params);
-    message::details::string_path_wrapper entry;
-
-    int ret = 0;
-    try
-    {
-        auto reply = bus.call(method);
-        reply.read(entry);
-    }
-    catch (const exception::exception& e)
-    {
-        response = std::string("Failed to create dump: ");
-        response += std::string("path - '") + path + std::string("', ");
-        response += std::string("type - '") + type + std::string("', ");
-        response += std::string("error - '") + e.what() + std::string("'");
-        ret = -1;
-    }
-    if (ret == 0)
-    {
-        response = std::string(entry);
-    }
-    bus.close();
-
-    return ret;
-}
-
-void CreateDumpDbus::processSingleDump(int fd, const std::string& type)
-{
-    std::string response;
-    int cDumpResult = CreateDumpDbus::createDump(type, response);
-    if (cDumpResult == 0)
-    {
-        sendMsg(
-            fd,
-            fmt::format(
-                "CreateDump call successful for dump type '{}', received: {}",
-                type, response));
-        sendMsg(fd, "Waiting for dump creation to finish...");
-        std::string path = response;
-        CreateDumpDbus::copyDumpToTmpDir(path, response);
-        sendMsg(fd, response);
-    }
-    else
-    {
-        sendMsg(fd, response);
-    }
-}
-
-void CreateDumpDbus::processDumpRequest(int fd, const std::string& type)
-{
-    sendMsg(fd, "Deleting existing dump files...");
-    std::filesystem::path tmpDir(TMP_DIR_PATH);
-    if (std::filesystem::exists(tmpDir))
-    {
-        for (auto& entry : std::filesystem::directory_iterator(tmpDir))
-        {
-            if (std::filesystem::is_regular_file(entry))
-            {
-                std::string filename = entry.path().filename();
-                if (filename.rfind(DUMP_COPY_PREFIX, 0) == 0 &&
-                    filename.find("dump") != std::string::npos)
-                {
-                    {
-                        try
-                        {
-                            std::filesystem::remove(entry);
-                        }
-                        catch (const std::exception&)
-                        {
-                            std::string err = "Failed to delete dump file: " +
-                                              filename;
-                            sendMsg(fd, err);
-                            log<level::ERR>(err.c_str());
-                        }
-                    }
-                }
-            }
-        }
-    }
-    if (type == "all")
-    {
-        for (const auto& d : SUPPORTED_DUMP_TYPES)
-        {
-            if (d != "all")
-            {
-                CreateDumpDbus::processSingleDump(fd, d);
-            }
-        }
+        return CreateDumpDbus::systemDumpPath;
     }
-    else
+    if (dPath.find("/bmc/") != std::string::npos)
     {
-        CreateDumpDbus::processSingleDump(fd, type);
+        return CreateDumpDbus::bmcDumpPath;
     }
+    return {};
 }
 
 void CreateDumpDbus::launchServer()
@@ -340,6 +103,7 @@ void CreateDumpDbus::launchServer()
     sd_event* event = nullptr;
     struct sockaddr_un sock;
     mode_t target_mode = 0777;
+    std::unique_ptr<DumpServer> dumpServer;
 
     std::unique_ptr<sd_event, std::function<void(sd_event*)>> eventPtr(
         event, [](sd_event* event) {
@@ -421,76 +185,35 @@ void CreateDumpDbus::launchServer()
         goto finish;
     }
 
+    try
+    {
+        dumpServer = std::make_unique<DumpServer>(eventPtr.get());
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        log<level::ERR>(e.what());
+        r = -EIO;
+        goto finish;
+    }
+    catch (CreateDumpDbusException& e)
+    {
+        log<level::ERR>(e.what().c_str());
+        r = -EIO;
+        goto finish;
+    }
+
+    // Clients are served concurrently, each by its session
     r = sd_event_add_io(
         eventPtr.get(), nullptr, fd, EPOLLIN,
-        [](sd_event_source*, int fd, uint32_t, void*) -> int {
-        fd = accept(fd, NULL, NULL);
-
-        if (fd < 0)
+        [](sd_event_source*, int fd, uint32_t, void* userdata) -> int {
+        fd = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd >= 0)
         {
-            return 0;
+            static_cast<DumpServer*>(userdata)->addClient(fd);
         }
-
-        std::vector<unsigned char> buffer(BUFFER_SIZE);
-        int ret = read(fd, &buffer[0], BUFFER_SIZE);
-        if (ret < 0)
-        {
-            log<level::ERR>(fmt::format("read error: {}", ret).c_str());
-            close(fd);
-
-            return 0;
-        }
-
-        std::string command(buffer.begin(), buffer.end());
-        std::istringstream iss(command);
-        std::vector<std::string> tokens{std::istream_iterator<std::string>{iss},
-                                        std::istream_iterator<std::string>{}};
-        if (tokens.size() != 0 && tokens[0] == std::string(CREATE_DUMP_CMD))
-        {
-            std::string type;
-            if (tokens.size() > 1)
-            {
-                tokens[1].erase(std::remove_if(tokens[1].begin(),
-                                               tokens[1].end(),
-                                               [](auto const& c) -> bool {
-                    return !std::isalnum(c);
-                }),
-                                tokens[1].end());
-                for (const auto& d : SUPPORTED_DUMP_TYPES)
-                {
-                    if (d == tokens[1])
-                    {
-                        type = d;
-                        break;
-                    }
-                }
-                if (type.empty())
-                {
-                    sendMsg(fd, "Invalid dump type requested");
-                    log<level::ERR>(
-                        fmt::format("Invalid dump type requested: {}",
-                                    tokens[1])
-                            .c_str());
-                }
-            }
-            else
-            {
-                type = DEFAULT_DUMP_TYPE;
-            }
-            if (!type.empty())
-            {
-                log<level::INFO>(
-                    fmt::format("Processing dump request, type: {}", type)
-                        .c_str());
-                CreateDumpDbus::processDumpRequest(fd, type);
-            }
-        }
-        sendMsg(fd, std::string(END_CMD));
-        close(fd);
-
         return 0;
     },
-        nullptr);
+        dumpServer.get());
 
     if (r < 0)
     {
@@ -500,6 +223,7 @@ void CreateDumpDbus::launchServer()
     r = sd_event_loop(eventPtr.get());
 
 finish:
+    dumpServer.reset();
     dispose();
 
     if (r < 0)
@@ -547,14 +271,48 @@ void CreateDumpDbus::doCreateDumpCall(const std::string& type)
         buffer.clear();
         buffer.resize(BUFFER_SIZE);
 
-        ret = read(dataSocket, &buffer[0], BUFFER_SIZE);
+        // dump files come as descriptors along with the message
+        struct iovec iov = {&buffer[0], BUFFER_SIZE};
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ret = recvmsg(dataSocket, &msg, MSG_CMSG_CLOEXEC);
         if (ret == -1)
         {
             std::cerr << "read" << std::endl;
             exit(EXIT_FAILURE);
         }
 
-        std::string response(buffer.begin(), buffer.end());
+        int dumpFd = -1;
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET &&
+                cmsg->cmsg_type == SCM_RIGHTS)
+            {
+                memcpy(&dumpFd, CMSG_DATA(cmsg), sizeof(dumpFd));
+            }
+        }
+
+        std::string response(buffer.begin(), buffer.begin() + ret);
+
+        if (dumpFd >= 0)
+        {
+            if (response.rfind(DUMP_FILE_CMD, 0) == 0 &&
+                response.size() > DUMP_FILE_CMD.size() + 1)
+            {
+                std::cout << saveDumpFile(
+                                 dumpFd,
+                                 response.substr(DUMP_FILE_CMD.size() + 1))
+                          << std::endl;
+            }
+            close(dumpFd);
+            continue;
+        }
 
         if (response.rfind(END_CMD) != std::string::npos)
         {
@@ -567,28 +325,160 @@ void CreateDumpDbus::doCreateDumpCall(const std::string& type)
     close(dataSocket);
 }
 
-void CreateDumpDbus::sendMsg(int fd, const std::string& msg)
+bool CreateDumpDbus::sendFile(int fd, const std::string& path)
 {
-    if (fd != -1)
-    {
-        int ret;
-        std::vector<unsigned char> buffer(msg.begin(), msg.end());
+    int fileFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileFd < 0)
+    {
+        return sendMsg(fd, fmt::format("Failed to open {}: {}", path,
+                                       std::strerror(errno)));
+    }
+
+    auto text = fmt::format(
+        "{} {}", DUMP_FILE_CMD,
+        std::filesystem::path(path).filename().string());
+    struct iovec iov = {text.data(), text.size()};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fileFd, sizeof(int));
+
+    auto ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    close(fileFd);
+    if (ret == -1)
+    {
+        log<level::ERR>("Error while sending dump file.");
+        return false;
+    }
+    return true;
+}
 
-        ret = write(fd, buffer.data(), buffer.size());
-        if (ret == -1)
+std::string CreateDumpDbus::saveDumpFile(int dumpFd, const std::string& name)
+{
+    std::string filename(DUMP_COPY_PREFIX);
+    filename += std::filesystem::path(name).filename().string();
+    auto fdPath = fmt::format("/proc/self/fd/{}", dumpFd);
+    std::error_code ec;
+
+    // Saved to /tmp by default, a tmpfs: the dump is linked on its own
+    // filesystem instead and /tmp keeps a symbolic link to it, a dump on
+    // another filesystem is copied to /tmp as before
+    if (std::filesystem::path(outputDir) == TMP_DIR_PATH)
+    {
+        auto linked = (std::filesystem::path(dumpCopyDir()) / filename)
+                          .string();
+        auto tmp = (std::filesystem::path(TMP_DIR_PATH) / filename).string();
+        std::filesystem::create_directories(dumpCopyDir(), ec);
+        unlink(linked.c_str());
+        if (!ec && linkat(AT_FDCWD, fdPath.c_str(), AT_FDCWD, linked.c_str(),
+                          AT_SYMLINK_FOLLOW) == 0)
         {
-            log<level::ERR>("Error while writing response data.");
-            close(fd);
+            unlink(tmp.c_str());
+            if (symlink(linked.c_str(), tmp.c_str()) < 0)
+            {
+                return fmt::format("Dump linked to {}.", linked);
+            }
+            return fmt::format("Dump linked to {}, {} points to it.", linked,
+                               tmp);
+        }
+    }
+
+    std::filesystem::create_directories(outputDir, ec);
+    if (ec)
+    {
+        return fmt::format("Failed to create {}: {}", outputDir,
+                           ec.message());
+    }
+    auto dest = (std::filesystem::path(outputDir) / filename).string();
+    unlink(dest.c_str());
+
+    // Same filesystem, the dump gets a second name and nothing is written
+    if (linkat(AT_FDCWD, fdPath.c_str(), AT_FDCWD, dest.c_str(),
+               AT_SYMLINK_FOLLOW) == 0)
+    {
+        return fmt::format("Dump linked to {}.", dest);
+    }
+
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                   0644);
+    if (out < 0)
+    {
+        return fmt::format("Failed to create {}: {}", dest,
+                           std::strerror(errno));
+    }
+
+    // Filesystem sharing extents, the copy shares the dump blocks
+    if (ioctl(out, FICLONE, dumpFd) == 0)
+    {
+        close(out);
+        return fmt::format("Dump cloned to {}.", dest);
+    }
 
-            throw std::exception();
+    // Copy in kernel
+    constexpr size_t chunkSize = 1024 * 1024;
+    off_t offset = 0;
+    bool useSendfile = false;
+    ssize_t n;
+    while (true)
+    {
+        if (!useSendfile)
+        {
+            loff_t inOffset = offset;
+            n = copy_file_range(dumpFd, &inOffset, out, nullptr, chunkSize, 0);
+            if (n < 0 && (errno == EXDEV || errno == EINVAL ||
+                          errno == ENOSYS || errno == EOPNOTSUPP))
+            {
+                useSendfile = true;
+                continue;
+            }
+            if (n > 0)
+            {
+                offset += n;
+            }
+        }
+        else
+        {
+            n = sendfile(out, dumpFd, &offset, chunkSize);
+        }
+        if (n == 0 || (n < 0 && errno != EINTR))
+        {
+            break;
         }
     }
-    else
+
+    auto error = errno;
+    close(out);
+    if (n < 0)
+    {
+        unlink(dest.c_str());
+        return fmt::format("Failed to copy the dump to {}: {}", dest,
+                           std::strerror(error));
+    }
+    return fmt::format("Dump copied to {}.", dest);
+}
+
+bool CreateDumpDbus::sendMsg(int fd, const std::string& msg)
+{
+    if (fd == -1)
     {
         log<level::ERR>("socket closed");
+        return false;
+    }
 
-        throw std::exception();
+    // No SIGPIPE when the client is gone, the server serves the others
+    if (send(fd, msg.data(), msg.size(), MSG_NOSIGNAL) == -1)
+    {
+        log<level::ERR>("Error while writing response data.");
+        return false;
     }
+    return true;
 }
 
 } // namespace create
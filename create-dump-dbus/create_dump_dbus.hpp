@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <sdbusplus/bus.hpp>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -45,6 +46,10 @@ constexpr std::string_view DUMP_COPY_PREFIX = "copy_";
 /** command by which the client asks for a dump */
 constexpr std::string_view CREATE_DUMP_CMD = "CREATE_DUMP";
 
+/** command by which the server passes the descriptor of a dump file, along
+ *  with the file name */
+constexpr std::string_view DUMP_FILE_CMD = "DUMP_FILE";
+
 /** command responded by server ends communication */
 constexpr std::string_view END_CMD = "END";
 
@@ -98,6 +103,14 @@ class CreateDumpDbus
     /** @brief path to which debug collector saves system dump files */
     static std::string systemDumpPath;
 
+    /** @brief path to which the client saves the dump files it receives */
+    static std::string outputDir;
+
+    /** @brief directory the dump files are hard-linked to when saved to the
+     *         default output directory, on the dump filesystem
+     */
+    static std::string dumpCopyDir();
+
     /** @brief creates a comma-separated list of all supported dump types */
     static std::string printSupportedTypes()
     {
@@ -111,62 +124,50 @@ class CreateDumpDbus
         return oss.str();
     }
 
-  private:
-    /** @brief closes connection and free resources */
-    void dispose();
-
-    /** @brief after request to dbus is sent, function creates simple
-     *         file watcher that waits for dump file, then copies it to
-     *         tmp directory
+    /** @brief directory the collector writes the dumps of an entry to
      *  @param [in] dPath - path of created dump in dbus tree
-     *  @param [in] response - response message
      *
-     *  @return on success 0, on failure -1
+     *  @return dump directory, empty if unknown
      */
-    static int copyDumpToTmpDir(const std::string& dPath,
-                                std::string& response);
-
-    /** @brief creates domain socket to allow communication between server and
-     *         client
-     */
-    void createSocket();
+    static std::string getDumpDir(const std::string& dPath);
 
     /** @brief wrapper that sends message to interlocutor
      *
      *  @param [in] fd - socket descriptor
      *  @param [in] msg - message
      *
-     *  @throws std::exception on failure
+     *  @return false on failure
      **/
-    static void sendMsg(int fd, const std::string& msg);
+    static bool sendMsg(int fd, const std::string& msg);
 
-    /**
-     * @brief check dump creation status by checking dump entry progress
-     * interface. Method is blocking.
+    /** @brief passes an open descriptor of the dump file to interlocutor,
+     *         or an error message if the file cannot be opened
      *
-     * @param [in] entryPath - path of entry's dbus object
-     */
-    static void waitForDumpCreation(const std::string& entryPath);
-
-    /** @brief calls the CreateDump method on dbus
-     *  @param [in] response - response message from dbus (or error message)
-     *  @param [in] type - dump type
+     *  @param [in] fd - socket descriptor
+     *  @param [in] path - dump file path
      *
-     *  @return on success 0, on failure -1
-     */
-    static int createDump(const std::string& type, std::string& response);
+     *  @return false on failure to send
+     **/
+    static bool sendFile(int fd, const std::string& path);
 
-    /** @brief creates dump and copies it to target location
-     *  @param [in] fd - file descriptor of the socket
-     *  @param [in] type - dump type
-     */
-    static void processSingleDump(int fd, const std::string& type);
+  private:
+    /** @brief closes connection and free resources */
+    void dispose();
 
-    /** @brief clears previously created dumps and processes the requested ones
-     *  @param [in] fd - file descriptor of the socket
-     *  @param [in] type - dump type
+    /** @brief saves a dump file received from the server to the output
+     *         directory, linking or cloning it when the filesystem allows
+     *
+     *  @param [in] dumpFd - descriptor of the dump file
+     *  @param [in] name - dump file name
+     *
+     *  @return message for the user
+     **/
+    static std::string saveDumpFile(int dumpFd, const std::string& name);
+
+    /** @brief creates domain socket to allow communication between server and
+     *         client
      */
-    static void processDumpRequest(int fd, const std::string& type);
+    void createSocket();
 
     /** @brief socket descriptors */
     int fd = -1;
@@ -0,0 +1,312 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "dump_completion_watcher.hpp"
+
+#include "create_dump_dbus.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <filesystem>
+#include <map>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <variant>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace create
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+constexpr auto DUMP_MANAGER_BUSNAME = "xyz.openbmc_project.Dump.Manager";
+constexpr auto PROGRESS_INTERFACE = "xyz.openbmc_project.Common.Progress";
+constexpr auto STATUS_IN_PROGRESS =
+    "xyz.openbmc_project.Common.Progress.OperationStatus.InProgress";
+constexpr auto STATUS_COMPLETED =
+    "xyz.openbmc_project.Common.Progress.OperationStatus.Completed";
+
+/** number of failed Status reads before giving up */
+constexpr auto MAX_GET_FAILS = 3;
+
+} // namespace
+
+DumpCompletionWatcher::DumpCompletionWatcher(sdbusplus::bus_t& bus,
+                                             sd_event* event,
+                                             const std::string& entryPath,
+                                             const std::string& dumpDir,
+                                             Callback&& callback) :
+    bus(bus), event(event), entryPath(entryPath), dumpDir(dumpDir),
+    callback(std::move(callback))
+{
+    entryDir = dumpDir + "/" +
+               std::filesystem::path(entryPath).filename().string();
+
+    statusMatch.emplace(
+        bus,
+        sdbusplus::bus::match::rules::propertiesChanged(entryPath,
+                                                        PROGRESS_INTERFACE),
+        [this](sdbusplus::message_t& msg) {
+        std::string interface;
+        std::map<std::string, std::variant<std::string, uint64_t>> properties;
+        try
+        {
+            msg.read(interface, properties);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            log<level::ERR>(e.what());
+            return;
+        }
+        auto it = properties.find("Status");
+        if (it != properties.end() &&
+            std::holds_alternative<std::string>(it->second))
+        {
+            statusChanged(std::get<std::string>(it->second));
+        }
+    });
+
+    if (!watchDir())
+    {
+        // Reported from the event loop, the caller may not expect the
+        // callback before the constructor returns.
+        setTimeout(0, "Failed to watch the dump directory.");
+        return;
+    }
+    setTimeout(CREATION_TIMEOUT, "Dump creation timed out.");
+    getStatus();
+}
+
+DumpCompletionWatcher::~DumpCompletionWatcher()
+{
+    sd_event_source_unref(ioSource);
+    sd_event_source_unref(timerSource);
+    if (inotifyFd >= 0)
+    {
+        close(inotifyFd);
+    }
+}
+
+void DumpCompletionWatcher::getStatus()
+{
+    auto method = bus.new_method_call(DUMP_MANAGER_BUSNAME, entryPath.c_str(),
+                                      "org.freedesktop.DBus.Properties",
+                                      "Get");
+    method.append(PROGRESS_INTERFACE, "Status");
+    pendingGet.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        std::variant<std::string> status;
+        try
+        {
+            if (reply.is_method_error())
+            {
+                throw sdbusplus::exception::SdBusError(EIO,
+                                                       "Status read failed");
+            }
+            reply.read(status);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            if (++getFails >= MAX_GET_FAILS)
+            {
+                done(-1, "Failed to get progress.");
+            }
+            else
+            {
+                getStatus();
+            }
+            return;
+        }
+        statusChanged(std::get<std::string>(status));
+    }));
+}
+
+void DumpCompletionWatcher::statusChanged(const std::string& status)
+{
+    if (finished || completed || status == STATUS_IN_PROGRESS)
+    {
+        return;
+    }
+    if (status != STATUS_COMPLETED)
+    {
+        done(-1, "Dump creation failed.");
+        return;
+    }
+
+    completed = true;
+    if (dumpFile.empty())
+    {
+        scanDir();
+    }
+    if (!dumpFile.empty())
+    {
+        done(0, dumpFile);
+        return;
+    }
+    setTimeout(TIMEOUT, "Copying dump to tmp dir failed: timeout.");
+}
+
+bool DumpCompletionWatcher::watchDir()
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        return false;
+    }
+    auto r = sd_event_add_io(
+        event, &ioSource, inotifyFd, EPOLLIN,
+        [](sd_event_source*, int, uint32_t, void* userdata) -> int {
+        static_cast<DumpCompletionWatcher*>(userdata)->inotifyEvents();
+        return 0;
+    },
+        this);
+    if (r < 0)
+    {
+        return false;
+    }
+
+    watch = inotify_add_watch(inotifyFd, entryDir.c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (watch >= 0)
+    {
+        watchingEntryDir = true;
+        scanDir();
+        return true;
+    }
+
+    // Wait for the collector to create the entry directory
+    watch = inotify_add_watch(inotifyFd, dumpDir.c_str(),
+                              IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+    if (watch < 0)
+    {
+        return false;
+    }
+    auto entryWatch = inotify_add_watch(
+        inotifyFd, entryDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (entryWatch >= 0)
+    {
+        // Created meanwhile
+        inotify_rm_watch(inotifyFd, watch);
+        watch = entryWatch;
+        watchingEntryDir = true;
+        scanDir();
+    }
+    return true;
+}
+
+void DumpCompletionWatcher::inotifyEvents()
+{
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer.data(), buffer.size())) > 0)
+    {
+        for (ssize_t offset = 0; offset < length;)
+        {
+            auto ievent =
+                reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + ievent->len;
+            if (ievent->wd != watch || ievent->len == 0)
+            {
+                continue;
+            }
+
+            std::string name(ievent->name);
+            if (!watchingEntryDir)
+            {
+                if ((ievent->mask & IN_ISDIR) &&
+                    entryDir == dumpDir + "/" + name)
+                {
+                    inotify_rm_watch(inotifyFd, watch);
+                    watch = inotify_add_watch(inotifyFd, entryDir.c_str(),
+                                              IN_CLOSE_WRITE | IN_MOVED_TO |
+                                                  IN_ONLYDIR);
+                    watchingEntryDir = watch >= 0;
+                    scanDir();
+                }
+            }
+            else if (!(ievent->mask & IN_ISDIR))
+            {
+                dumpFile = entryDir + "/" + name;
+            }
+        }
+    }
+
+    if (completed && !dumpFile.empty())
+    {
+        done(0, dumpFile);
+    }
+}
+
+void DumpCompletionWatcher::scanDir()
+{
+    std::error_code ec;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(entryDir, ec))
+    {
+        if (entry.is_regular_file(ec))
+        {
+            dumpFile = entry.path().string();
+            return;
+        }
+    }
+}
+
+void DumpCompletionWatcher::setTimeout(uint64_t ms, const char* message)
+{
+    sd_event_source_unref(timerSource);
+    timerSource = nullptr;
+    timeoutMessage = message;
+
+    uint64_t now = 0;
+    sd_event_now(event, CLOCK_MONOTONIC, &now);
+    auto r = sd_event_add_time(
+        event, &timerSource, CLOCK_MONOTONIC, now + ms * 1000, 0,
+        [](sd_event_source*, uint64_t, void* userdata) -> int {
+        auto watcher = static_cast<DumpCompletionWatcher*>(userdata);
+        watcher->done(-1, watcher->timeoutMessage);
+        return 0;
+    },
+        this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to arm the dump completion timeout");
+    }
+}
+
+void DumpCompletionWatcher::done(int result, const std::string& response)
+{
+    if (finished)
+    {
+        return;
+    }
+    finished = true;
+    sd_event_source_set_enabled(ioSource, SD_EVENT_OFF);
+    sd_event_source_set_enabled(timerSource, SD_EVENT_OFF);
+    callback(result, response);
+}
+
+} // namespace create
+} // namespace dump
+} // namespace phosphor
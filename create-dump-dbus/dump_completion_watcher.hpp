@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <systemd/sd-event.h>
+
+#include <functional>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/slot.hpp>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace create
+{
+
+/** time allowed to the dump collector to complete a dump, in milliseconds */
+constexpr auto CREATION_TIMEOUT = 1000 * 60 * 30;
+
+/** @class DumpCompletionWatcher
+ *  @brief Waits for a dump entry to complete and for its file to be written.
+ *
+ *  @details The Progress Status of the entry is followed through a
+ *  PropertiesChanged match, read once when the watch starts. The dump file
+ *  is detected with an inotify watch on the entry directory, or on the dump
+ *  directory until the entry directory is created. Both are served by the
+ *  event loop the bus is attached to.
+ */
+class DumpCompletionWatcher
+{
+  public:
+    /** @brief Called once, with 0 and the dump file path on success, -1 and
+     *         an error message on failure. The watcher must not be destroyed
+     *         from it.
+     */
+    using Callback = std::function<void(int, const std::string&)>;
+
+    DumpCompletionWatcher() = delete;
+    DumpCompletionWatcher(const DumpCompletionWatcher&) = delete;
+    DumpCompletionWatcher& operator=(const DumpCompletionWatcher&) = delete;
+    DumpCompletionWatcher(DumpCompletionWatcher&&) = delete;
+    DumpCompletionWatcher& operator=(DumpCompletionWatcher&&) = delete;
+    ~DumpCompletionWatcher();
+
+    /** @brief Start watching
+     *  @param [in] bus - bus attached to event.
+     *  @param [in] event - event loop the watch runs on.
+     *  @param [in] entryPath - path of the dump entry dbus object.
+     *  @param [in] dumpDir - directory the collector writes the entry
+     *                        directory to.
+     *  @param [in] callback - called with the result.
+     */
+    DumpCompletionWatcher(sdbusplus::bus_t& bus, sd_event* event,
+                          const std::string& entryPath,
+                          const std::string& dumpDir, Callback&& callback);
+
+  private:
+    /** @brief Read the Status, in case it changed before the match */
+    void getStatus();
+
+    /** @brief Handle a Status value */
+    void statusChanged(const std::string& status);
+
+    /** @brief Watch the entry directory, or the dump directory until the
+     *         entry directory exists.
+     *  @return false on failure.
+     */
+    bool watchDir();
+
+    /** @brief Handle the inotify events */
+    void inotifyEvents();
+
+    /** @brief Look for a dump file already in the entry directory */
+    void scanDir();
+
+    /** @brief Arm the deadline of the current step */
+    void setTimeout(uint64_t ms, const char* message);
+
+    /** @brief Stop watching and report the result */
+    void done(int result, const std::string& response);
+
+    sdbusplus::bus_t& bus;
+    sd_event* event;
+    std::string entryPath;
+    std::string dumpDir;
+    std::string entryDir;
+    Callback callback;
+
+    std::optional<sdbusplus::bus::match_t> statusMatch;
+    std::optional<sdbusplus::slot_t> pendingGet;
+    int getFails = 0;
+
+    /** @brief Progress Status reported Completed */
+    bool completed = false;
+
+    /** @brief Dump file, once written */
+    std::string dumpFile;
+
+    int inotifyFd = -1;
+    int watch = -1;
+    bool watchingEntryDir = false;
+    sd_event_source* ioSource = nullptr;
+    sd_event_source* timerSource = nullptr;
+    const char* timeoutMessage = nullptr;
+    bool finished = false;
+};
+
+} // namespace create
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,511 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "dump_server.hpp"
+
+#include "create_dump_dbus.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/core.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sstream>
+#include <variant>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace create
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+constexpr auto DUMP_MANAGER_BUSNAME = "xyz.openbmc_project.Dump.Manager";
+constexpr auto DUMP_PATH_PREFIX = "/xyz/openbmc_project/dump/";
+constexpr auto DUMP_CREATE_INTERFACE = "xyz.openbmc_project.Dump.Create";
+
+/** time a client may block the server while it is sent a message, in
+ *  seconds */
+constexpr auto SEND_TIMEOUT = 5;
+
+} // namespace
+
+DumpJob::DumpJob(DumpServer& server, const std::string& type) :
+    server(server), type(type)
+{}
+
+void DumpJob::start()
+{
+    std::string path;
+    std::map<std::string, std::variant<std::string, uint64_t>> params;
+    params["DumpType"] = type;
+    if (type.empty() || type == "BMC")
+    {
+        path = std::string(DUMP_PATH_PREFIX) + "bmc";
+    }
+    else
+    {
+        path = std::string(DUMP_PATH_PREFIX) + "system";
+        params["DiagnosticType"] = type;
+    }
+
+    try
+    {
+        auto method = server.getBus().new_method_call(
+            DUMP_MANAGER_BUSNAME, path.c_str(), DUMP_CREATE_INTERFACE,
+            "CreateDump");
+        method.append(params);
+        pendingCall.emplace(server.getBus().call_async(
+            method,
+            [this](sdbusplus::message_t reply) { created(reply); }));
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        complete(-1, fmt::format("Failed to create dump: path - '{}', "
+                                 "type - '{}', error - '{}'",
+                                 path, type, e.what()));
+    }
+}
+
+void DumpJob::created(sdbusplus::message_t& reply)
+{
+    sdbusplus::message::details::string_path_wrapper entry;
+    std::string error;
+    try
+    {
+        if (reply.is_method_error())
+        {
+            auto e = reply.get_error();
+            error = e && e->message ? e->message
+                                    : std::strerror(reply.get_errno());
+        }
+        else
+        {
+            reply.read(entry);
+        }
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        error = e.what();
+    }
+    if (!error.empty())
+    {
+        complete(-1, fmt::format("Failed to create dump: type - '{}', "
+                                 "error - '{}'",
+                                 type, error));
+        return;
+    }
+
+    std::string entryPath(entry);
+    message(fmt::format(
+        "CreateDump call successful for dump type '{}', received: {}", type,
+        entryPath));
+
+    auto dumpDir = CreateDumpDbus::getDumpDir(entryPath);
+    if (dumpDir.empty())
+    {
+        complete(-1, "Unknown dump file path");
+        return;
+    }
+    message("Waiting for dump creation to finish...");
+    watcher = std::make_unique<DumpCompletionWatcher>(
+        server.getBus(), server.getEvent(), entryPath, dumpDir,
+        [this](int r, const std::string& response) { complete(r, response); });
+}
+
+uint64_t DumpJob::subscribe(Listener&& listener)
+{
+    auto id = nextListener++;
+    for (const auto& msg : messages)
+    {
+        listener.message(msg);
+    }
+    listeners.emplace(id, std::move(listener));
+
+    if (result)
+    {
+        // The listener may not expect its result before subscribe returns
+        server.defer([self = shared_from_this(), id]() {
+            auto it = self->listeners.find(id);
+            if (it != self->listeners.end())
+            {
+                auto done = std::move(it->second.done);
+                self->listeners.erase(it);
+                done(self->result->first, self->result->second);
+            }
+        });
+    }
+    return id;
+}
+
+void DumpJob::unsubscribe(uint64_t id)
+{
+    listeners.erase(id);
+}
+
+void DumpJob::message(const std::string& msg)
+{
+    messages.push_back(msg);
+    // Listeners may unsubscribe from their callback
+    auto current = listeners;
+    for (auto& [id, listener] : current)
+    {
+        listener.message(msg);
+    }
+}
+
+void DumpJob::complete(int r, const std::string& response)
+{
+    if (r < 0)
+    {
+        log<level::ERR>(response.c_str());
+    }
+    result.emplace(r, response);
+
+    // We may be in a callback of the watcher, it is destroyed from the
+    // event loop along with the job.
+    server.releaseJob(type, shared_from_this());
+
+    auto current = std::move(listeners);
+    listeners.clear();
+    for (auto& [id, listener] : current)
+    {
+        listener.done(r, response);
+    }
+}
+
+ClientSession::ClientSession(DumpServer& server, int fd) :
+    server(server), fd(fd)
+{
+    // A client not reading its messages must not stall the others
+    struct timeval timeout = {SEND_TIMEOUT, 0};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (sd_event_add_io(server.getEvent(), &ioSource, fd, EPOLLIN, onIo,
+                        this) < 0)
+    {
+        log<level::ERR>("Failed to watch the client socket.");
+        finished = true;
+        server.removeClient(fd);
+    }
+}
+
+ClientSession::~ClientSession()
+{
+    for (auto& [type, job] : jobs)
+    {
+        job.first->unsubscribe(job.second);
+    }
+    if (ioSource)
+    {
+        sd_event_source_unref(ioSource);
+    }
+    close(fd);
+}
+
+int ClientSession::onIo(sd_event_source*, int fd, uint32_t revents,
+                        void* userdata)
+{
+    auto session = static_cast<ClientSession*>(userdata);
+    if (session->finished)
+    {
+        return 0;
+    }
+
+    std::vector<unsigned char> buffer(BUFFER_SIZE);
+    int ret = 0;
+    if (revents & EPOLLIN)
+    {
+        ret = read(fd, &buffer[0], BUFFER_SIZE);
+    }
+    if (ret <= 0 || session->commandRead)
+    {
+        // Hang up, or nothing expected after the command: the client is
+        // gone, the dumps it waits for go on for the other clients.
+        if (ret < 0)
+        {
+            log<level::ERR>(fmt::format("read error: {}", ret).c_str());
+        }
+        session->finished = true;
+        session->server.removeClient(fd);
+        return 0;
+    }
+
+    session->commandRead = true;
+    session->handleCommand(std::string(buffer.begin(), buffer.begin() + ret));
+    return 0;
+}
+
+void ClientSession::handleCommand(const std::string& command)
+{
+    std::istringstream iss(command);
+    std::vector<std::string> tokens{std::istream_iterator<std::string>{iss},
+                                    std::istream_iterator<std::string>{}};
+    if (tokens.size() == 0 || tokens[0] != std::string(CREATE_DUMP_CMD))
+    {
+        finish();
+        return;
+    }
+
+    std::string type;
+    if (tokens.size() > 1)
+    {
+        tokens[1].erase(std::remove_if(tokens[1].begin(), tokens[1].end(),
+                                       [](auto const& c) -> bool {
+            return !std::isalnum(c);
+        }),
+                        tokens[1].end());
+        for (const auto& d : SUPPORTED_DUMP_TYPES)
+        {
+            if (d == tokens[1])
+            {
+                type = d;
+                break;
+            }
+        }
+        if (type.empty())
+        {
+            log<level::ERR>(
+                fmt::format("Invalid dump type requested: {}", tokens[1])
+                    .c_str());
+            send("Invalid dump type requested");
+            finish();
+            return;
+        }
+    }
+    else
+    {
+        type = DEFAULT_DUMP_TYPE;
+    }
+
+    log<level::INFO>(
+        fmt::format("Processing dump request, type: {}", type).c_str());
+    deleteDumpCopies();
+
+    std::vector<std::string> types;
+    if (type == "all")
+    {
+        std::copy_if(SUPPORTED_DUMP_TYPES.begin(), SUPPORTED_DUMP_TYPES.end(),
+                     std::back_inserter(types),
+                     [](const auto& d) { return d != "all"; });
+    }
+    else
+    {
+        types.push_back(type);
+    }
+
+    // Requests of a type in flight share its dump. Results are sent as the
+    // dumps complete, in any order.
+    for (const auto& d : types)
+    {
+        auto job = server.getJob(d);
+        auto& entry = jobs[d];
+        entry.first = job;
+        entry.second = job->subscribe(
+            {[this](const std::string& msg) { send(msg); },
+             [this, d](int r, const std::string& response) {
+            jobDone(d, r, response);
+        }});
+    }
+}
+
+void ClientSession::deleteDumpCopies()
+{
+    // The copies of the other clients are theirs until they are done
+    if (server.busy(fd))
+    {
+        log<level::INFO>("Dump requests in flight, keeping the dump copies");
+        return;
+    }
+
+    send("Deleting existing dump files...");
+    // Copies linked on the dump filesystem hold the space of deleted dumps
+    for (const std::filesystem::path dir :
+         {std::string(TMP_DIR_PATH), CreateDumpDbus::dumpCopyDir()})
+    {
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(dir, ec))
+        {
+            std::string filename = entry.path().filename();
+            if ((entry.is_regular_file(ec) || entry.is_symlink(ec)) &&
+                filename.rfind(DUMP_COPY_PREFIX, 0) == 0 &&
+                filename.find("dump") != std::string::npos &&
+                !std::filesystem::remove(entry, ec) && ec)
+            {
+                std::string err = "Failed to delete dump file: " + filename;
+                send(err);
+                log<level::ERR>(err.c_str());
+            }
+        }
+    }
+}
+
+void ClientSession::jobDone(const std::string& type, int result,
+                            const std::string& response)
+{
+    jobs.erase(type);
+    if (finished)
+    {
+        return;
+    }
+
+    if (result == 0)
+    {
+        if (send(fmt::format("Sending {} for dump type '{}'.", response,
+                             type)) &&
+            !CreateDumpDbus::sendFile(fd, response))
+        {
+            finished = true;
+            server.removeClient(fd);
+            return;
+        }
+    }
+    else
+    {
+        send(fmt::format("Dump type '{}': {}", type, response));
+    }
+
+    if (jobs.empty())
+    {
+        finish();
+    }
+}
+
+bool ClientSession::send(const std::string& msg)
+{
+    if (finished)
+    {
+        return false;
+    }
+    if (!CreateDumpDbus::sendMsg(fd, msg))
+    {
+        finished = true;
+        server.removeClient(fd);
+        return false;
+    }
+    return true;
+}
+
+void ClientSession::finish()
+{
+    send(std::string(END_CMD));
+    finished = true;
+    server.removeClient(fd);
+}
+
+DumpServer::DumpServer(sd_event* event) :
+    event(event), bus(sdbusplus::bus::new_default())
+{
+    bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+    if (sd_event_add_defer(event, &deferSource, onDefer, this) < 0 ||
+        sd_event_source_set_enabled(deferSource, SD_EVENT_OFF) < 0)
+    {
+        bus.detach_event();
+        throw CreateDumpDbusException("Failed to add the deferred event.");
+    }
+}
+
+DumpServer::~DumpServer()
+{
+    deferred.clear();
+    sessions.clear();
+    jobs.clear();
+    sd_event_source_unref(deferSource);
+    bus.detach_event();
+}
+
+void DumpServer::addClient(int fd)
+{
+    sessions[fd] = std::make_unique<ClientSession>(*this, fd);
+}
+
+void DumpServer::removeClient(int fd)
+{
+    defer([this, fd]() { sessions.erase(fd); });
+}
+
+bool DumpServer::busy(int fd) const
+{
+    return !jobs.empty() ||
+           std::any_of(sessions.begin(), sessions.end(),
+                       [fd](const auto& session) {
+        return session.first != fd && !session.second->isFinished();
+    });
+}
+
+std::shared_ptr<DumpJob> DumpServer::getJob(const std::string& type)
+{
+    auto it = jobs.find(type);
+    if (it != jobs.end())
+    {
+        log<level::INFO>(
+            fmt::format("Dump type {} in progress, joining it", type).c_str());
+        return it->second;
+    }
+    auto job = std::make_shared<DumpJob>(*this, type);
+    jobs.emplace(type, job);
+    job->start();
+    return job;
+}
+
+void DumpServer::releaseJob(const std::string& type,
+                            std::shared_ptr<DumpJob> job)
+{
+    defer([this, type, job = std::move(job)]() {
+        auto it = jobs.find(type);
+        if (it != jobs.end() && it->second == job)
+        {
+            jobs.erase(it);
+        }
+    });
+}
+
+void DumpServer::defer(std::function<void()>&& function)
+{
+    deferred.emplace_back(std::move(function));
+    sd_event_source_set_enabled(deferSource, SD_EVENT_ONESHOT);
+}
+
+int DumpServer::onDefer(sd_event_source*, void* userdata)
+{
+    auto server = static_cast<DumpServer*>(userdata);
+    // Functions may defer others, they run from the next iteration
+    auto functions = std::move(server->deferred);
+    server->deferred.clear();
+    for (auto& function : functions)
+    {
+        function();
+    }
+    return 0;
+}
+
+} // namespace create
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,265 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "dump_completion_watcher.hpp"
+
+#include <systemd/sd-event.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/slot.hpp>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace create
+{
+
+class DumpServer;
+
+/** @class DumpJob
+ *  @brief One dump being created, shared by all the clients requesting its
+ *         type while it is in flight.
+ *
+ *  @details CreateDump is called asynchronously, then the entry is followed
+ *  by a DumpCompletionWatcher. Listeners get the progress messages, replayed
+ *  to the ones subscribing late, and the result.
+ */
+class DumpJob : public std::enable_shared_from_this<DumpJob>
+{
+  public:
+    /** @brief Listener of a job
+     *  @details message is called with each progress message, done once with
+     *  0 and the dump file path on success, -1 and an error message on
+     *  failure.
+     */
+    struct Listener
+    {
+        std::function<void(const std::string&)> message;
+        std::function<void(int, const std::string&)> done;
+    };
+
+    DumpJob() = delete;
+    DumpJob(const DumpJob&) = delete;
+    DumpJob& operator=(const DumpJob&) = delete;
+    DumpJob(DumpJob&&) = delete;
+    DumpJob& operator=(DumpJob&&) = delete;
+    ~DumpJob() = default;
+
+    /** @brief Constructor
+     *  @param [in] server - server running the job.
+     *  @param [in] type - dump type.
+     */
+    DumpJob(DumpServer& server, const std::string& type);
+
+    /** @brief Call CreateDump */
+    void start();
+
+    /** @brief Add a listener, called back from the event loop only
+     *  @param [in] listener - listener to add.
+     *
+     *  @return id to unsubscribe with
+     */
+    uint64_t subscribe(Listener&& listener);
+
+    /** @brief Remove a listener
+     *  @param [in] id - id returned by subscribe.
+     */
+    void unsubscribe(uint64_t id);
+
+  private:
+    /** @brief Handle the CreateDump reply */
+    void created(sdbusplus::message_t& reply);
+
+    /** @brief Send a progress message to the listeners */
+    void message(const std::string& msg);
+
+    /** @brief Report the result to the listeners and release the job */
+    void complete(int result, const std::string& response);
+
+    DumpServer& server;
+    std::string type;
+
+    std::optional<sdbusplus::slot_t> pendingCall;
+    std::unique_ptr<DumpCompletionWatcher> watcher;
+
+    /** @brief Progress messages so far, for late listeners */
+    std::vector<std::string> messages;
+
+    /** @brief Result, once complete */
+    std::optional<std::pair<int, std::string>> result;
+
+    std::map<uint64_t, Listener> listeners;
+    uint64_t nextListener = 0;
+};
+
+/** @class ClientSession
+ *  @brief State of one connected client: reading its command, then waiting
+ *         for the dumps it requested and sending them as they complete.
+ */
+class ClientSession
+{
+  public:
+    ClientSession() = delete;
+    ClientSession(const ClientSession&) = delete;
+    ClientSession& operator=(const ClientSession&) = delete;
+    ClientSession(ClientSession&&) = delete;
+    ClientSession& operator=(ClientSession&&) = delete;
+    ~ClientSession();
+
+    /** @brief Constructor, starts reading the client command
+     *  @param [in] server - server the client connected to.
+     *  @param [in] fd - connected socket, owned by the session.
+     */
+    ClientSession(DumpServer& server, int fd);
+
+    /** @brief Connected socket, identifies the session */
+    int getFd() const
+    {
+        return fd;
+    }
+
+    /** @brief Whether the client is done with, its dumps sent or gone */
+    bool isFinished() const
+    {
+        return finished;
+    }
+
+  private:
+    /** @brief Handle the socket events */
+    static int onIo(sd_event_source* source, int fd, uint32_t revents,
+                    void* userdata);
+
+    /** @brief Handle the client command */
+    void handleCommand(const std::string& command);
+
+    /** @brief Delete the dump copies left by the previous requests, unless
+     *         another client may still be sent or saving one
+     */
+    void deleteDumpCopies();
+
+    /** @brief Handle the result of one of the requested dumps */
+    void jobDone(const std::string& type, int result,
+                 const std::string& response);
+
+    /** @brief Send a message to the client
+     *  @return false if the client is gone.
+     */
+    bool send(const std::string& msg);
+
+    /** @brief End the communication and remove the session */
+    void finish();
+
+    DumpServer& server;
+    int fd;
+    sd_event_source* ioSource = nullptr;
+    bool commandRead = false;
+    bool finished = false;
+
+    /** @brief Jobs still running for this client, with the listener ids */
+    std::map<std::string, std::pair<std::shared_ptr<DumpJob>, uint64_t>> jobs;
+};
+
+/** @class DumpServer
+ *  @brief Serves the clients of the socket concurrently on one event loop.
+ *
+ *  @details Each client has a ClientSession. Requests of a dump type being
+ *  created already join its DumpJob instead of creating another dump.
+ *  Sessions and jobs are released from a deferred event, never from within
+ *  their own callbacks.
+ */
+class DumpServer
+{
+  public:
+    DumpServer() = delete;
+    DumpServer(const DumpServer&) = delete;
+    DumpServer& operator=(const DumpServer&) = delete;
+    DumpServer(DumpServer&&) = delete;
+    DumpServer& operator=(DumpServer&&) = delete;
+    ~DumpServer();
+
+    /** @brief Constructor, attaches a bus connection to the event loop
+     *  @param [in] event - event loop of the server.
+     */
+    explicit DumpServer(sd_event* event);
+
+    /** @brief Start serving a connected client
+     *  @param [in] fd - accepted socket.
+     */
+    void addClient(int fd);
+
+    /** @brief Release a session, from the next loop iteration
+     *  @param [in] fd - socket of the session.
+     */
+    void removeClient(int fd);
+
+    /** @brief In-flight job of a dump type, started if there is none
+     *  @param [in] type - dump type.
+     */
+    std::shared_ptr<DumpJob> getJob(const std::string& type);
+
+    /** @brief Forget a completed job, from the next loop iteration
+     *  @param [in] type - dump type of the job.
+     *  @param [in] job - the job, kept alive until then.
+     */
+    void releaseJob(const std::string& type, std::shared_ptr<DumpJob> job);
+
+    /** @brief Whether a dump is being created or a client other than one
+     *         is still served
+     *  @param [in] fd - socket of the session asking.
+     */
+    bool busy(int fd) const;
+
+    /** @brief Run a function from the next loop iteration */
+    void defer(std::function<void()>&& function);
+
+    sdbusplus::bus_t& getBus()
+    {
+        return bus;
+    }
+
+    sd_event* getEvent() const
+    {
+        return event;
+    }
+
+  private:
+    /** @brief Run the deferred functions */
+    static int onDefer(sd_event_source* source, void* userdata);
+
+    sd_event* event;
+    sdbusplus::bus_t bus;
+
+    /** @brief Functions to run from the next loop iteration */
+    std::vector<std::function<void()>> deferred;
+    sd_event_source* deferSource = nullptr;
+
+    std::map<int, std::unique_ptr<ClientSession>> sessions;
+    std::map<std::string, std::shared_ptr<DumpJob>> jobs;
+};
+
+} // namespace create
+} // namespace dump
+} // namespace phosphor
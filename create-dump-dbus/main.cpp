@@ -58,6 +58,11 @@ void help()
     std::cout << "client mode only; sets dump type, supported types: ";
     std::cout << CreateDumpDbus::printSupportedTypes();
     std::cout << "." << std::endl;
+    std::cout << "--output-dir, -o:       ";
+    std::cout << "client mode only; sets the directory the received dump "
+                 "files are saved to, they are hard-linked when it is on "
+                 "the dump filesystem, default: ";
+    std::cout << CreateDumpDbus::outputDir << std::endl;
 }
 
 int main(int argc, char** argv)
@@ -67,12 +72,14 @@ int main(int argc, char** argv)
                             {"bmc-dump-path", required_argument, NULL, 'p'},
                             {"system-dump-path", required_argument, NULL, 'q'},
                             {"type", required_argument, NULL, 't'},
+                            {"output-dir", required_argument, NULL, 'o'},
                             {0, 0, 0, 0}};
 
     int c, option_index = 0;
     bool serverMode = false;
-    std::string bmcPath, systemPath, type;
-    while ((c = getopt_long(argc, argv, "hsp:q:t:", opts, &option_index)) != -1)
+    std::string bmcPath, systemPath, type, outputDir;
+    while ((c = getopt_long(argc, argv, "hsp:q:t:o:", opts, &option_index)) !=
+           -1)
     {
         switch (c)
         {
@@ -96,6 +103,10 @@ int main(int argc, char** argv)
                 type = std::string(optarg);
                 break;
 
+            case 'o':
+                outputDir = std::string(optarg);
+                break;
+
             default:
                 std::cerr << "Unknown argument: -" << static_cast<char>(c)
                           << std::endl;
@@ -110,6 +121,11 @@ int main(int argc, char** argv)
             std::cerr << "Server mode, dump type argument is ignored"
                       << std::endl;
         }
+        if (!outputDir.empty())
+        {
+            std::cerr << "Server mode, output directory argument is ignored"
+                      << std::endl;
+        }
         if (!bmcPath.empty())
         {
             CreateDumpDbus::bmcDumpPath = bmcPath;
@@ -186,6 +202,10 @@ int main(int argc, char** argv)
                       << std::endl;
             type = "BMC";
         }
+        if (!outputDir.empty())
+        {
+            CreateDumpDbus::outputDir = outputDir;
+        }
         CreateDumpDbus client;
         client.doCreateDumpCall(type);
     }
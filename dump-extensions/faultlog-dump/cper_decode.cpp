@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cper_decode.hpp"
+
+#include <fmt/core.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+namespace
+{
+
+using json = nlohmann::json;
+
+/** @brief Layout of the record, UEFI specification appendix N */
+constexpr size_t headerSize = 128;
+constexpr size_t descriptorSize = 72;
+constexpr size_t nvidiaHeaderSize = 32;
+constexpr size_t nvidiaRegisterSize = 16;
+constexpr size_t pcieDeviceIdOffset = 24;
+constexpr size_t pcieDeviceIdSize = 16;
+
+constexpr std::array<std::pair<std::string_view, std::string_view>, 11>
+    notificationTypes{{
+        {"2dce8bb1-bdd7-450e-b9ad-9cf4ebd4f890", "CMC"},
+        {"4e292f96-d843-4a55-a8c2-d481f27ebeee", "CPE"},
+        {"e8f56ffe-919c-4cc5-ba88-65abe14913bb", "MCE"},
+        {"cf93c01f-1a16-4dfc-b8bc-9c4daf67c104", "PCIe"},
+        {"cc5263e8-9308-454a-89d0-340bd39bc98e", "INIT"},
+        {"5bad89ff-b7e6-42c9-814a-cf2485d6e98a", "NMI"},
+        {"3d61a466-ab40-409a-a698-f362d464b38f", "Boot"},
+        {"667dd791-c6b3-4c27-8a6b-0f8e722deb41", "DMAr"},
+        {"9a78788a-bbe8-11e4-809e-67611e5d46b0", "SEA"},
+        {"5c284c81-b0ae-4e87-a322-b04c85624323", "SEI"},
+        {"09a9d5ac-5204-4214-96e5-94992e752bcd", "PEI"},
+    }};
+
+constexpr auto nvidiaSection = "6d5244f2-2712-11ec-bea7-cb3fdb95c786";
+constexpr auto pcieSection = "d995e954-bbc1-430f-ad91-b44dcb3c6f35";
+
+constexpr std::array<std::pair<std::string_view, std::string_view>, 10>
+    sectionTypes{{
+        {nvidiaSection, "NVIDIA"},
+        {pcieSection, "PCIe"},
+        {"9876ccad-47b4-4bdb-b65e-16f193c4f3db", "Processor Generic"},
+        {"dc3ea0b0-a144-4797-b95b-53fa242b6e1d", "IA32/X64"},
+        {"e19e3d16-bc11-11e4-9caa-c2051d5d46b0", "ARM"},
+        {"a5bc1114-6f64-4ede-b863-3e83ed7c83b1", "Platform Memory"},
+        {"81212a96-09ed-4996-9471-8d729c8e69ed", "Firmware Error Record"},
+        {"c5753963-3b84-4095-bf78-eddad3f9c9dd", "PCI/PCI-X Bus"},
+        {"eb5e4685-ca66-4769-b6a2-26068b001326", "PCI Component/Device"},
+        {"5b51fef7-c79d-4434-8f1b-aa62de3e2c64", "DMAr Generic"},
+    }};
+
+constexpr std::array<std::string_view, 4> severities{
+    "Recoverable", "Fatal", "Corrected", "Informational"};
+
+template <typename T>
+T read(std::span<const uint8_t> data, size_t offset)
+{
+    // CPER fields are little endian, as the BMC
+    T value{};
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        value |= static_cast<T>(data[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+std::string guid(std::span<const uint8_t> data, size_t offset)
+{
+    auto d = data.subspan(offset + 8, 8);
+    return fmt::format(
+        "{:08x}-{:04x}-{:04x}-{:02x}{:02x}-{:02x}{:02x}{:02x}{:02x}{:02x}{:02x}",
+        read<uint32_t>(data, offset), read<uint16_t>(data, offset + 4),
+        read<uint16_t>(data, offset + 6), d[0], d[1], d[2], d[3], d[4], d[5],
+        d[6], d[7]);
+}
+
+/** @brief Name of a GUID in a table, the GUID itself if it is not there */
+template <size_t N>
+std::string name(
+    const std::array<std::pair<std::string_view, std::string_view>, N>& table,
+    const std::string& id)
+{
+    for (const auto& [key, value] : table)
+    {
+        if (key == id)
+        {
+            return std::string(value);
+        }
+    }
+    return id;
+}
+
+std::string severity(uint32_t code)
+{
+    return code < severities.size() ? std::string(severities[code])
+                                     : "Unknown";
+}
+
+/** @brief NUL terminated string of a fixed size field, printable ASCII only
+ *         so that the JSON output is valid UTF-8
+ */
+std::string text(std::span<const uint8_t> data, size_t offset, size_t size)
+{
+    std::string value;
+    for (auto c : data.subspan(offset, size))
+    {
+        if (c == '\0')
+        {
+            break;
+        }
+        if (c >= 0x20 && c < 0x7f)
+        {
+            value.push_back(static_cast<char>(c));
+        }
+    }
+    return value;
+}
+
+std::string timestamp(std::span<const uint8_t> data, size_t offset)
+{
+    // BCD seconds, minutes, hours, flags, day, month, year, century
+    auto t = data.subspan(offset, 8);
+    return fmt::format("{:02x}{:02x}-{:02x}-{:02x}T{:02x}:{:02x}:{:02x}+00:00",
+                       t[7], t[6], t[5], t[4], t[2], t[1], t[0]);
+}
+
+json nvidia(std::span<const uint8_t> body)
+{
+    if (body.size() < nvidiaHeaderSize)
+    {
+        return json::object();
+    }
+
+    json section;
+    section["IPSignature"] = text(body, 0, 16);
+    section["ErrorType"] = read<uint16_t>(body, 16);
+    section["ErrorInstance"] = read<uint16_t>(body, 18);
+    section["Severity"] = severity(body[20]);
+    section["SocketNumber"] = body[21];
+    section["NumberRegs"] = body[22];
+    section["InstanceBase"] = read<uint64_t>(body, 24);
+
+    auto registers = json::array();
+    for (size_t i = 0, offset = nvidiaHeaderSize;
+         i < body[22] && offset + nvidiaRegisterSize <= body.size();
+         ++i, offset += nvidiaRegisterSize)
+    {
+        registers.push_back({{"Address", read<uint64_t>(body, offset)},
+                             {"Value", read<uint64_t>(body, offset + 8)}});
+    }
+    section["Registers"] = std::move(registers);
+    return section;
+}
+
+json pcie(std::span<const uint8_t> body)
+{
+    if (body.size() < pcieDeviceIdOffset + pcieDeviceIdSize)
+    {
+        return json::object();
+    }
+
+    auto id = body.subspan(pcieDeviceIdOffset, pcieDeviceIdSize);
+    auto hex = [](uint64_t value) { return fmt::format("{:#x}", value); };
+    uint32_t classCode = id[4] | (id[5] << 8) | (id[6] << 16);
+
+    json section;
+    section["ValidationBits"] = read<uint64_t>(body, 0);
+    section["PortType"] = read<uint32_t>(body, 8);
+    section["DeviceID"] = {
+        {"VendorID", hex(read<uint16_t>(id, 0))},
+        {"DeviceID", hex(read<uint16_t>(id, 2))},
+        {"ClassCode", hex(classCode)},
+        {"FunctionNumber", hex(id[7])},
+        {"DeviceNumber", hex(id[8])},
+        {"SegmentNumber", hex(read<uint16_t>(id, 9))},
+        {"DeviceBusNumber", hex(id[11])},
+        {"SecondaryBusNumber", hex(id[12])},
+        {"SlotNumber", read<uint16_t>(id, 13) >> 3},
+    };
+    return section;
+}
+
+} // namespace
+
+std::optional<json> decodeCper(std::span<const uint8_t> record)
+{
+    if (record.size() < headerSize || text(record, 0, 4) != "CPER")
+    {
+        return std::nullopt;
+    }
+
+    auto sectionCount = read<uint16_t>(record, 10);
+    if (headerSize + sectionCount * descriptorSize > record.size())
+    {
+        return std::nullopt;
+    }
+
+    json decoded;
+    auto& header = decoded["Header"];
+    header["Revision"] = {{"Major", record[5]}, {"Minor", record[4]}};
+    header["SectionCount"] = sectionCount;
+    auto code = read<uint32_t>(record, 12);
+    header["Severity"] = {{"Name", severity(code)}, {"Code", code}};
+    header["RecordLength"] = read<uint32_t>(record, 20);
+    header["Timestamp"] = timestamp(record, 24);
+    header["TimestampIsPrecise"] = (record[27] & 0x1) != 0;
+    header["PlatformID"] = guid(record, 32);
+    header["CreatorID"] = guid(record, 64);
+    header["NotificationType"] = name(notificationTypes, guid(record, 80));
+    header["RecordID"] = read<uint64_t>(record, 96);
+    header["PersistenceInfo"] = read<uint64_t>(record, 108);
+
+    auto sections = json::array();
+    for (size_t i = 0; i < sectionCount; ++i)
+    {
+        auto offset = headerSize + i * descriptorSize;
+        auto sectionOffset = read<uint32_t>(record, offset);
+        auto sectionLength = read<uint32_t>(record, offset + 4);
+        if (sectionOffset > record.size() ||
+            sectionLength > record.size() - sectionOffset)
+        {
+            return std::nullopt;
+        }
+
+        auto type = guid(record, offset + 16);
+        json descriptor;
+        descriptor["SectionOffset"] = sectionOffset;
+        descriptor["SectionLength"] = sectionLength;
+        descriptor["Revision"] = {{"Major", record[offset + 9]},
+                                  {"Minor", record[offset + 8]}};
+        descriptor["SectionType"] = name(sectionTypes, type);
+        descriptor["FRUId"] = guid(record, offset + 32);
+        descriptor["SectionSeverity"] =
+            severity(read<uint32_t>(record, offset + 48));
+        descriptor["FRUText"] = text(record, offset + 52, 20);
+
+        json section{{"SectionDescriptor", std::move(descriptor)}};
+        auto body = record.subspan(sectionOffset, sectionLength);
+        if (type == nvidiaSection)
+        {
+            section["Section"] = nvidia(body);
+        }
+        else if (type == pcieSection)
+        {
+            section["Section"] = pcie(body);
+        }
+        sections.push_back(std::move(section));
+    }
+    decoded["Sections"] = std::move(sections);
+    return decoded;
+}
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <span>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+/** @brief Decode a CPER record into the decoded.json document
+ *  @details The record header and the section descriptors are decoded, the
+ *           section bodies only for the NVIDIA and PCIe sections, the others
+ *           are left out of the document.
+ *
+ *  @param[in] record - UEFI Common Platform Error Record.
+ *
+ *  @returns the document, std::nullopt if the record is not a CPER or its
+ *           sections are outside of it
+ */
+std::optional<nlohmann::json> decodeCper(std::span<const uint8_t> record);
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,328 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cper_ingest.hpp"
+
+#include "cper_decode.hpp"
+#include "xyz/openbmc_project/Common/error.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+using namespace phosphor::logging;
+using InternalFailure =
+    sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+/** @brief Records ingested between two summaries in the journal */
+constexpr size_t summaryInterval = 64;
+
+/** @brief Staging directory of a dump directory, next to it so that it is
+ *         on the same filesystem for the rename and out of its watch.
+ */
+fs::path stagingPath(const fs::path& dumpDir)
+{
+    auto dir = dumpDir.has_filename() ? dumpDir : dumpDir.parent_path();
+    return dir.string() + ".ingest";
+}
+
+} // namespace
+
+CperIngest::CperIngest(sd_event* event, const fs::path& dumpDir,
+                       size_t workers, size_t depth, Done&& done) :
+    dumpDir(dumpDir),
+    stagingDir(stagingPath(dumpDir)), depth(depth), done(std::move(done))
+{
+    // Dumps left half written by a previous run are dropped
+    std::error_code ec;
+    fs::remove_all(stagingDir, ec);
+    fs::create_directories(stagingDir, ec);
+    if (ec)
+    {
+        log<level::ERR>("Unable to create the CPER staging directory",
+                        entry("DIR=%s", stagingDir.c_str()),
+                        entry("ERROR=%s", ec.message().c_str()));
+        elog<InternalFailure>();
+    }
+
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd < 0)
+    {
+        log<level::ERR>("eventfd failed", entry("ERRNO=%d", errno));
+        elog<InternalFailure>();
+    }
+
+    auto rc = sd_event_add_io(event, &source, eventFd, EPOLLIN, onDone, this);
+    if (rc < 0)
+    {
+        close(eventFd);
+        log<level::ERR>("Error occurred during the sd_event_add_io call",
+                        entry("RC=%d", rc));
+        elog<InternalFailure>();
+    }
+
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+    {
+        threads.emplace_back(&CperIngest::work, this);
+    }
+}
+
+CperIngest::~CperIngest()
+{
+    {
+        std::lock_guard guard(lock);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (source != nullptr)
+    {
+        sd_event_source_disable_unref(source);
+    }
+    if (eventFd >= 0)
+    {
+        close(eventFd);
+    }
+}
+
+bool CperIngest::submit(uint32_t id, const fs::path& cperPath)
+{
+    size_t waiting = 0;
+    {
+        std::lock_guard guard(lock);
+        if (queue.size() >= depth)
+        {
+            waiting = queue.size();
+        }
+        else
+        {
+            queue.push_back({id, cperPath, Clock::now()});
+            waiting = queue.size();
+            available.notify_one();
+            stats.maxDepth = std::max(stats.maxDepth, waiting);
+            return true;
+        }
+    }
+
+    ++stats.rejected;
+    log<level::ERR>("CPER ingestion queue full, record rejected",
+                    entry("ID=%d", id), entry("DEPTH=%zu", waiting));
+    return false;
+}
+
+void CperIngest::work()
+{
+    while (true)
+    {
+        Record record;
+        {
+            std::unique_lock guard(lock);
+            available.wait(guard,
+                           [this] { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            record = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        auto file = ingest(record);
+
+        {
+            std::lock_guard guard(lock);
+            outcomes.push_back(
+                {record.id, std::move(file), Clock::now() - record.submitted});
+        }
+        uint64_t one = 1;
+        if (write(eventFd, &one, sizeof(one)) < 0)
+        {
+            log<level::ERR>("Unable to signal the CPER ingestion outcome",
+                            entry("ERRNO=%d", errno));
+        }
+    }
+}
+
+std::optional<fs::path> CperIngest::ingest(const Record& record)
+{
+    try
+    {
+        return writeDump(record);
+    }
+    catch (const std::exception& e)
+    {
+        // Nothing may escape the worker thread
+        log<level::ERR>("Unable to ingest the CPER",
+                        entry("ID=%d", record.id),
+                        entry("ERROR=%s", e.what()));
+        return std::nullopt;
+    }
+}
+
+std::optional<fs::path> CperIngest::writeDump(const Record& record)
+{
+    auto id = std::to_string(record.id);
+
+    std::ifstream cper(record.cperPath, std::ios::binary);
+    if (!cper.is_open())
+    {
+        log<level::ERR>("Unable to open the CPER",
+                        entry("PATH=%s", record.cperPath.c_str()));
+        return std::nullopt;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(cper)),
+                              std::istreambuf_iterator<char>());
+
+    auto decoded = decodeCper(data);
+    if (!decoded)
+    {
+        log<level::ERR>("Invalid CPER record",
+                        entry("PATH=%s", record.cperPath.c_str()),
+                        entry("ID=%s", id.c_str()));
+        return std::nullopt;
+    }
+
+    // decoded.json is written first, the entry reads it once the dump file
+    // is there
+    auto staging = stagingDir / id;
+    auto name = "obmcdump_" + id + "_" + std::to_string(std::time(nullptr)) +
+                ".cper";
+    std::error_code ec;
+    fs::remove_all(staging, ec);
+    fs::create_directories(staging / "Decoded", ec);
+    if (!ec)
+    {
+        std::ofstream json(staging / "Decoded" / "decoded.json");
+        json << decoded->dump(4, ' ', false,
+                              nlohmann::json::error_handler_t::replace);
+        std::ofstream dump(staging / name, std::ios::binary);
+        dump.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!json.flush() || !dump.flush())
+        {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+    }
+
+    // Publish the complete directory at once
+    auto target = dumpDir / id;
+    if (!ec)
+    {
+        fs::remove_all(target, ec);
+        fs::rename(staging, target, ec);
+    }
+    if (ec)
+    {
+        log<level::ERR>("Unable to write the CPER dump",
+                        entry("ID=%s", id.c_str()),
+                        entry("ERROR=%s", ec.message().c_str()));
+        fs::remove_all(staging, ec);
+        return std::nullopt;
+    }
+    return target / name;
+}
+
+int CperIngest::onDone(sd_event_source*, int fd, uint32_t, void* userdata)
+{
+    auto ingest = static_cast<CperIngest*>(userdata);
+
+    uint64_t count = 0;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        log<level::ERR>("Unable to read the CPER ingestion outcomes",
+                        entry("ERRNO=%d", errno));
+    }
+
+    std::vector<Outcome> outcomes;
+    {
+        std::lock_guard guard(ingest->lock);
+        outcomes.swap(ingest->outcomes);
+    }
+    for (const auto& outcome : outcomes)
+    {
+        ingest->account(outcome);
+        ingest->done(outcome.id, outcome.file);
+    }
+    return 0;
+}
+
+void CperIngest::account(const Outcome& outcome)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    auto latency = static_cast<long long>(
+        duration_cast<microseconds>(outcome.latency).count());
+    log<level::DEBUG>("CPER ingested", entry("ID=%u", outcome.id),
+                      entry("SUCCESS=%d", outcome.file.has_value()),
+                      entry("LATENCY_US=%lld", latency));
+
+    ++(outcome.file ? stats.ingested : stats.failed);
+    stats.totalLatency += outcome.latency;
+    stats.maxLatency = std::max(stats.maxLatency, outcome.latency);
+
+    auto count = stats.ingested + stats.failed;
+    if (count < summaryInterval)
+    {
+        return;
+    }
+    size_t waiting = 0;
+    {
+        std::lock_guard guard(lock);
+        waiting = queue.size();
+    }
+    log<level::INFO>(
+        "CPER ingestion summary", entry("INGESTED=%zu", stats.ingested),
+        entry("FAILED=%zu", stats.failed),
+        entry("REJECTED=%zu", stats.rejected),
+        entry("AVG_LATENCY_US=%lld",
+              static_cast<long long>(
+                  duration_cast<microseconds>(stats.totalLatency).count() /
+                  static_cast<long long>(count))),
+        entry("MAX_LATENCY_US=%lld",
+              static_cast<long long>(
+                  duration_cast<microseconds>(stats.maxLatency).count())),
+        entry("QUEUE_DEPTH=%zu", waiting),
+        entry("MAX_QUEUE_DEPTH=%zu", stats.maxDepth));
+    stats = Stats{};
+}
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
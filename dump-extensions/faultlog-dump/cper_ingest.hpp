@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <systemd/sd-event.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+/** @class CperIngest
+ *
+ *  @brief Turns the CPERs into faultlog dumps in the manager's process.
+ *
+ *  Records are queued, up to a bounded depth, to a pool of worker threads
+ *  which copy the CPER, decode it into Decoded/decoded.json and publish the
+ *  dump directory <dumpDir>/<id> with a rename, once it is complete. The
+ *  outcome is reported back in the event loop.
+ */
+class CperIngest
+{
+  public:
+    /** @brief Called in the event loop once a record was ingested
+     *  @details Given the dump file, std::nullopt if the record failed.
+     */
+    using Done = std::function<void(uint32_t id,
+                                    const std::optional<std::filesystem::path>&
+                                        file)>;
+
+    CperIngest() = delete;
+    CperIngest(const CperIngest&) = delete;
+    CperIngest& operator=(const CperIngest&) = delete;
+    CperIngest(CperIngest&&) = delete;
+    CperIngest& operator=(CperIngest&&) = delete;
+
+    /** @brief Constructor, starts the workers
+     *  @param[in] event - Event loop the outcomes are reported from.
+     *  @param[in] dumpDir - Directory of the faultlog dumps.
+     *  @param[in] workers - Number of worker threads.
+     *  @param[in] depth - Records waiting at most for a worker.
+     *  @param[in] done - Called with the outcome of each record.
+     */
+    CperIngest(sd_event* event, const std::filesystem::path& dumpDir,
+               size_t workers, size_t depth, Done&& done);
+
+    /** @brief Destructor, drops the waiting records and joins the workers */
+    ~CperIngest();
+
+    /** @brief Queue a record
+     *  @param[in] id - Dump entry id.
+     *  @param[in] cperPath - CPER file received.
+     *
+     *  @returns false if the queue is full, the record is not ingested
+     */
+    bool submit(uint32_t id, const std::filesystem::path& cperPath);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Record
+    {
+        uint32_t id;
+        std::filesystem::path cperPath;
+        Clock::time_point submitted;
+    };
+
+    struct Outcome
+    {
+        uint32_t id;
+        std::optional<std::filesystem::path> file;
+        Clock::duration latency;
+    };
+
+    /** @brief Worker thread loop */
+    void work();
+
+    /** @brief Write the dump directory of a record, worker side
+     *  @details Errors are logged, a record which throws counts as failed.
+     *
+     *  @returns the dump file, std::nullopt on failure
+     */
+    std::optional<std::filesystem::path> ingest(const Record& record);
+
+    /** @brief Decode a record and publish its dump directory
+     *  @returns the dump file, std::nullopt on failure
+     */
+    std::optional<std::filesystem::path> writeDump(const Record& record);
+
+    /** @brief sd-event callback of the completion eventfd
+     *
+     *  @param[in] s - io event source
+     *  @param[in] fd - completion eventfd
+     *  @param[in] revents - events
+     *  @param[in] userdata - pointer to the CperIngest
+     *
+     *  @returns 0
+     */
+    static int onDone(sd_event_source* s, int fd, uint32_t revents,
+                      void* userdata);
+
+    /** @brief Account a reported outcome, logs a summary periodically */
+    void account(const Outcome& outcome);
+
+    /** @brief Directory of the faultlog dumps */
+    std::filesystem::path dumpDir;
+
+    /** @brief Directory the dumps are written to before being published */
+    std::filesystem::path stagingDir;
+
+    size_t depth;
+    Done done;
+
+    /** @brief Signals the event loop that outcomes are pending */
+    int eventFd = -1;
+    sd_event_source* source = nullptr;
+
+    std::mutex lock;
+    std::condition_variable available;
+    std::deque<Record> queue;
+    std::vector<Outcome> outcomes;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    /** @brief Statistics since the last summary, event loop only */
+    struct Stats
+    {
+        size_t ingested = 0;
+        size_t failed = 0;
+        size_t rejected = 0;
+        size_t maxDepth = 0;
+        Clock::duration totalLatency{};
+        Clock::duration maxLatency{};
+    } stats;
+};
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,375 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cper_metadata.hpp"
+
+#include <array>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+namespace
+{
+
+using json = nlohmann::json;
+
+/** @brief Field of the metadata and where it is in decoded.json */
+struct Field
+{
+    std::string_view path;
+    std::string CperMetadata::*member;
+    /** @brief Whether the JSON value is kept serialized, else a string */
+    bool serialized;
+};
+
+constexpr std::array<Field, 16> fields{{
+    {"Header/NotificationType", &CperMetadata::notificationType, false},
+    {"Sections/0/SectionDescriptor/SectionType", &CperMetadata::sectionType,
+     false},
+    {"Sections/0/SectionDescriptor/FRUId", &CperMetadata::fruid, false},
+    {"Sections/0/SectionDescriptor/SectionSeverity", &CperMetadata::severity,
+     false},
+    {"Sections/0/Section/IPSignature", &CperMetadata::nvipSignature, false},
+    {"Sections/0/Section/Severity", &CperMetadata::nvSeverity, false},
+    {"Sections/0/Section/SocketNumber", &CperMetadata::nvSocketNumber, true},
+    {"Sections/0/Section/DeviceID/VendorID", &CperMetadata::pcieVendorID,
+     false},
+    {"Sections/0/Section/DeviceID/DeviceID", &CperMetadata::pcieDeviceID,
+     false},
+    {"Sections/0/Section/DeviceID/ClassCode", &CperMetadata::pcieClassCode,
+     false},
+    {"Sections/0/Section/DeviceID/FunctionNumber",
+     &CperMetadata::pcieFunctionNumber, false},
+    {"Sections/0/Section/DeviceID/DeviceNumber",
+     &CperMetadata::pcieDeviceNumber, false},
+    {"Sections/0/Section/DeviceID/SegmentNumber",
+     &CperMetadata::pcieSegmentNumber, false},
+    {"Sections/0/Section/DeviceID/DeviceBusNumber",
+     &CperMetadata::pcieDeviceBusNumber, false},
+    {"Sections/0/Section/DeviceID/SecondaryBusNumber",
+     &CperMetadata::pcieSecondaryBusNumber, false},
+    {"Sections/0/Section/DeviceID/SlotNumber", &CperMetadata::pcieSlotNumber,
+     true},
+}};
+
+/** @brief Containers holding the fields, the others are skipped */
+constexpr std::array<std::string_view, 6> containers{
+    "Header/",
+    "Sections/",
+    "Sections/0/",
+    "Sections/0/SectionDescriptor/",
+    "Sections/0/Section/",
+    "Sections/0/Section/DeviceID/",
+};
+
+/** @class MetadataSax
+ *
+ *  @brief SAX handler picking the metadata fields while decoded.json is
+ *  parsed, stopping the parser once the header and the first section ended.
+ */
+class MetadataSax : public nlohmann::json_sax<json>
+{
+  public:
+    explicit MetadataSax(CperMetadata& metadata) : metadata(metadata) {}
+
+    bool null() override
+    {
+        return scalar(json());
+    }
+
+    bool boolean(bool value) override
+    {
+        return scalar(json(value));
+    }
+
+    bool number_integer(number_integer_t value) override
+    {
+        return scalar(json(value));
+    }
+
+    bool number_unsigned(number_unsigned_t value) override
+    {
+        return scalar(json(value));
+    }
+
+    bool number_float(number_float_t value, const string_t&) override
+    {
+        return scalar(json(value));
+    }
+
+    bool string(string_t& value) override
+    {
+        if (skipped != 0)
+        {
+            return true;
+        }
+        if (auto field = find(position()); field != nullptr)
+        {
+            metadata.*field->member = field->serialized ? json(value).dump()
+                                                        : value;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override
+    {
+        return true;
+    }
+
+    bool start_object(std::size_t) override
+    {
+        return enter(false);
+    }
+
+    bool key(string_t& value) override
+    {
+        if (skipped == 0)
+        {
+            levels.back().key = value;
+            if (prefix == "Header/" && value == "SectionCount")
+            {
+                sectionCount = true;
+            }
+            else if (prefix == "Sections/0/" && value == "SectionDescriptor")
+            {
+                sectionDescriptor = true;
+            }
+        }
+        return true;
+    }
+
+    bool end_object() override
+    {
+        return leave();
+    }
+
+    bool start_array(std::size_t) override
+    {
+        return enter(true);
+    }
+
+    bool end_array() override
+    {
+        return leave();
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception&) override
+    {
+        return false;
+    }
+
+    /** @brief The parser was stopped once the fields were read */
+    bool stopped = false;
+
+    /** @brief Header.SectionCount is present */
+    bool sectionCount = false;
+
+    /** @brief Sections[0].SectionDescriptor is present */
+    bool sectionDescriptor = false;
+
+  private:
+    /** @brief Object or array being parsed */
+    struct Level
+    {
+        bool array;
+        /** @brief Length of the prefix of the enclosing container */
+        size_t prefixLength;
+        /** @brief Current key of an object */
+        std::string key;
+        /** @brief Index of the current element of an array */
+        size_t index = 0;
+        bool first = true;
+    };
+
+    /** @brief Path of the value being parsed, from the root */
+    std::string position()
+    {
+        if (levels.empty())
+        {
+            return {};
+        }
+        auto& level = levels.back();
+        if (!level.array)
+        {
+            return prefix + level.key;
+        }
+        if (!level.first)
+        {
+            ++level.index;
+        }
+        level.first = false;
+        return prefix + std::to_string(level.index);
+    }
+
+    static const Field* find(const std::string& path)
+    {
+        for (const auto& field : fields)
+        {
+            if (field.path == path)
+            {
+                return &field;
+            }
+        }
+        return nullptr;
+    }
+
+    bool scalar(const json& value)
+    {
+        if (skipped != 0)
+        {
+            return true;
+        }
+        auto field = find(position());
+        if (field != nullptr && field->serialized)
+        {
+            metadata.*field->member = value.dump();
+        }
+        return true;
+    }
+
+    bool enter(bool array)
+    {
+        if (skipped != 0)
+        {
+            ++skipped;
+            return true;
+        }
+
+        if (levels.empty())
+        {
+            levels.push_back({array, 0, {}});
+            return true;
+        }
+
+        auto path = position() + '/';
+        if (path == "Sections/1/" && headerDone)
+        {
+            // Only the first section is described
+            stopped = true;
+            return false;
+        }
+        bool wanted = false;
+        for (auto container : containers)
+        {
+            wanted = wanted || (container == path);
+        }
+        if (!wanted)
+        {
+            skipped = 1;
+            return true;
+        }
+
+        levels.push_back({array, prefix.size(), {}});
+        prefix = path;
+        return true;
+    }
+
+    bool leave()
+    {
+        if (skipped != 0)
+        {
+            --skipped;
+            return true;
+        }
+
+        auto ended = prefix;
+        prefix.resize(levels.back().prefixLength);
+        levels.pop_back();
+
+        headerDone = headerDone || (ended == "Header/");
+        sectionDone = sectionDone || (ended == "Sections/0/") ||
+                      (ended == "Sections/");
+        if (headerDone && sectionDone)
+        {
+            stopped = true;
+            return false;
+        }
+        return true;
+    }
+
+    CperMetadata& metadata;
+    std::vector<Level> levels;
+    /** @brief Path of the current container, '/' terminated */
+    std::string prefix;
+    /** @brief Depth inside a skipped container, 0 if none */
+    size_t skipped = 0;
+    bool headerDone = false;
+    bool sectionDone = false;
+};
+
+} // namespace
+
+CperMetadata parseCperMetadata(std::istream& decoded)
+{
+    CperMetadata metadata;
+    MetadataSax sax(metadata);
+    if (!json::sax_parse(decoded, &sax) && !sax.stopped)
+    {
+        return {};
+    }
+
+    // The section fields only count with a section count in the header, and
+    // those of the section body with a section descriptor
+    CperMetadata result;
+    result.notificationType = std::move(metadata.notificationType);
+    if (!sax.sectionCount)
+    {
+        return result;
+    }
+    result.sectionType = std::move(metadata.sectionType);
+    result.fruid = std::move(metadata.fruid);
+    result.severity = std::move(metadata.severity);
+    if (!sax.sectionDescriptor)
+    {
+        return result;
+    }
+    result.nvipSignature = std::move(metadata.nvipSignature);
+    result.nvSeverity = std::move(metadata.nvSeverity);
+    result.nvSocketNumber = std::move(metadata.nvSocketNumber);
+    result.pcieVendorID = std::move(metadata.pcieVendorID);
+    result.pcieDeviceID = std::move(metadata.pcieDeviceID);
+    result.pcieClassCode = std::move(metadata.pcieClassCode);
+    result.pcieFunctionNumber = std::move(metadata.pcieFunctionNumber);
+    result.pcieDeviceNumber = std::move(metadata.pcieDeviceNumber);
+    result.pcieSegmentNumber = std::move(metadata.pcieSegmentNumber);
+    result.pcieDeviceBusNumber = std::move(metadata.pcieDeviceBusNumber);
+    result.pcieSecondaryBusNumber = std::move(metadata.pcieSecondaryBusNumber);
+    result.pcieSlotNumber = std::move(metadata.pcieSlotNumber);
+    return result;
+}
+
+std::optional<CperMetadata> readCperMetadata(const std::filesystem::path& path)
+{
+    std::ifstream decoded(path);
+    if (!decoded.is_open())
+    {
+        return std::nullopt;
+    }
+    return parseCperMetadata(decoded);
+}
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
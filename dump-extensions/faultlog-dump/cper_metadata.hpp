@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+/** @struct CperMetadata
+ *
+ *  Fields of a decoded CPER published on the faultlog entry, "NA" when the
+ *  CPER does not have them. Only the first section is described.
+ */
+struct CperMetadata
+{
+    /** @brief Header.NotificationType */
+    std::string notificationType = "NA";
+
+    /** @brief Sections[0].SectionDescriptor fields */
+    std::string sectionType = "NA";
+    std::string fruid = "NA";
+    std::string severity = "NA";
+
+    /** @brief Sections[0].Section fields of the NVIDIA section */
+    std::string nvipSignature = "NA";
+    std::string nvSeverity = "NA";
+    std::string nvSocketNumber = "NA";
+
+    /** @brief Sections[0].Section.DeviceID fields of the PCIe section */
+    std::string pcieVendorID = "NA";
+    std::string pcieDeviceID = "NA";
+    std::string pcieClassCode = "NA";
+    std::string pcieFunctionNumber = "NA";
+    std::string pcieDeviceNumber = "NA";
+    std::string pcieSegmentNumber = "NA";
+    std::string pcieDeviceBusNumber = "NA";
+    std::string pcieSecondaryBusNumber = "NA";
+    std::string pcieSlotNumber = "NA";
+};
+
+/** @brief Extract the metadata of a decoded CPER
+ *  @details The JSON is parsed as a stream and the parsing stops once the
+ *           header and the first section were read, without building the
+ *           document. An invalid document before that point gives the
+ *           default metadata.
+ *
+ *  @param[in] decoded - decoded.json content.
+ *
+ *  @returns the metadata
+ */
+CperMetadata parseCperMetadata(std::istream& decoded);
+
+/** @brief Extract the metadata of a decoded CPER file
+ *  @param[in] path - Path of decoded.json.
+ *
+ *  @returns the metadata, std::nullopt if the file can not be opened
+ */
+std::optional<CperMetadata> readCperMetadata(const std::filesystem::path& path);
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cper_metadata_cache.hpp"
+
+#include <sys/stat.h>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/map.hpp>
+#include <cereal/types/string.hpp>
+#include <chrono>
+#include <fstream>
+#include <phosphor-logging/log.hpp>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+using namespace phosphor::logging;
+
+namespace fs = std::filesystem;
+
+/** @brief Format of the cache file, older files are dropped */
+constexpr uint32_t cacheVersion = 1;
+
+/** @brief Delay between the first change and the write of the cache file */
+constexpr auto flushDelay = std::chrono::seconds(5);
+
+template <class Archive>
+void serialize(Archive& archive, CperMetadata& metadata)
+{
+    archive(metadata.notificationType, metadata.sectionType, metadata.fruid,
+            metadata.severity, metadata.nvipSignature, metadata.nvSeverity,
+            metadata.nvSocketNumber, metadata.pcieVendorID,
+            metadata.pcieDeviceID, metadata.pcieClassCode,
+            metadata.pcieFunctionNumber, metadata.pcieDeviceNumber,
+            metadata.pcieSegmentNumber, metadata.pcieDeviceBusNumber,
+            metadata.pcieSecondaryBusNumber, metadata.pcieSlotNumber);
+}
+
+template <class Archive>
+void serialize(Archive& archive, CperMetadataCache::Record& record)
+{
+    archive(record.mtime, record.size, record.parsed, record.metadata,
+            record.primaryLogId);
+}
+
+CperMetadataCache::CperMetadataCache(sd_event* event, const fs::path& file) :
+    file(file), flushTimer(sdeventplus::Event(event), [this](Timer&) {
+        flush();
+    })
+{
+    try
+    {
+        if (!fs::exists(file))
+        {
+            return;
+        }
+        std::ifstream is(file, std::ios::in | std::ios::binary);
+        cereal::BinaryInputArchive iarchive(is);
+        uint32_t version = 0;
+        iarchive(version);
+        if (version == cacheVersion)
+        {
+            iarchive(records);
+            return;
+        }
+        log<level::INFO>("Dropping an outdated faultlog metadata cache",
+                         entry("VERSION=%u", version));
+    }
+    catch (const std::exception& e)
+    {
+        // A corrupt file may also fail on a huge length or on the
+        // filesystem, the metadata is parsed again from decoded.json
+        log<level::ERR>("Failed to load the faultlog metadata cache",
+                        entry("ERROR=%s", e.what()));
+        records.clear();
+    }
+    std::error_code ec;
+    fs::remove(file, ec);
+}
+
+CperMetadataCache::~CperMetadataCache()
+{
+    flush();
+}
+
+std::optional<CperMetadata> CperMetadataCache::read(uint32_t id,
+                                                    const fs::path& decoded)
+{
+    struct stat st;
+    if (stat(decoded.c_str(), &st) != 0)
+    {
+        return std::nullopt;
+    }
+    int64_t mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    uint64_t size = st.st_size;
+
+    auto it = records.find(id);
+    if (it != records.end() && it->second.parsed &&
+        it->second.mtime == mtime && it->second.size == size)
+    {
+        return it->second.metadata;
+    }
+
+    auto metadata = readCperMetadata(decoded);
+    if (!metadata)
+    {
+        return std::nullopt;
+    }
+    auto& record = records[id];
+    record.mtime = mtime;
+    record.size = size;
+    record.parsed = true;
+    record.metadata = *metadata;
+    changed();
+    return metadata;
+}
+
+std::string CperMetadataCache::primaryLogId(uint32_t id) const
+{
+    auto it = records.find(id);
+    if (it == records.end() || it->second.primaryLogId.empty())
+    {
+        return "0";
+    }
+    return it->second.primaryLogId;
+}
+
+void CperMetadataCache::primaryLogId(uint32_t id, const std::string& logId)
+{
+    records[id].primaryLogId = logId;
+    changed();
+}
+
+void CperMetadataCache::erase(uint32_t id)
+{
+    if (records.erase(id) != 0)
+    {
+        changed();
+    }
+}
+
+void CperMetadataCache::retain(const std::set<uint32_t>& ids)
+{
+    for (auto it = records.begin(); it != records.end();)
+    {
+        if (ids.contains(it->first))
+        {
+            ++it;
+            continue;
+        }
+        it = records.erase(it);
+        dirty = true;
+    }
+    if (dirty)
+    {
+        changed();
+    }
+}
+
+void CperMetadataCache::flush()
+{
+    if (!dirty)
+    {
+        return;
+    }
+    flushTimer.setEnabled(false);
+
+    // Written aside and renamed, a crash leaves the previous cache
+    auto temporary = file;
+    temporary += ".tmp";
+    try
+    {
+        {
+            std::ofstream os(temporary, std::ios::binary | std::ios::trunc);
+            cereal::BinaryOutputArchive oarchive(os);
+            oarchive(cacheVersion, records);
+            if (!os.flush())
+            {
+                throw std::runtime_error("write failed");
+            }
+        }
+        fs::rename(temporary, file);
+        dirty = false;
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to write the faultlog metadata cache",
+                        entry("FILE=%s", file.c_str()),
+                        entry("ERROR=%s", e.what()));
+        std::error_code ec;
+        fs::remove(temporary, ec);
+    }
+}
+
+void CperMetadataCache::changed()
+{
+    dirty = true;
+    if (!flushTimer.isEnabled())
+    {
+        flushTimer.restartOnce(flushDelay);
+    }
+}
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "cper_metadata.hpp"
+
+#include <systemd/sd-event.h>
+
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/utility/timer.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+/** @class CperMetadataCache
+ *
+ *  @brief Metadata of the faultlog entries persisted across restarts, so
+ *  that restoring the entries only parses the decoded.json files which
+ *  changed.
+ *
+ *  A cached metadata is used while its decoded.json keeps the modification
+ *  time and size it had when it was parsed. Changes are written to the
+ *  cache file a few seconds after the first of them, at once.
+ */
+class CperMetadataCache
+{
+  public:
+    CperMetadataCache() = delete;
+    CperMetadataCache(const CperMetadataCache&) = delete;
+    CperMetadataCache& operator=(const CperMetadataCache&) = delete;
+    CperMetadataCache(CperMetadataCache&&) = delete;
+    CperMetadataCache& operator=(CperMetadataCache&&) = delete;
+
+    /** @brief Constructor, loads the cache file
+     *  @details An unreadable or outdated cache file is dropped.
+     *
+     *  @param[in] event - Event loop the cache is written from.
+     *  @param[in] file - Cache file.
+     */
+    CperMetadataCache(sd_event* event, const std::filesystem::path& file);
+
+    /** @brief Destructor, writes the pending changes */
+    ~CperMetadataCache();
+
+    /** @brief Metadata of an entry, parsed only if decoded.json changed
+     *  @param[in] id - Entry id.
+     *  @param[in] decoded - Path of decoded.json.
+     *
+     *  @returns the metadata, std::nullopt if decoded.json can not be read
+     */
+    std::optional<CperMetadata> read(uint32_t id,
+                                     const std::filesystem::path& decoded);
+
+    /** @brief Primary log id of an entry, "0" if unknown */
+    std::string primaryLogId(uint32_t id) const;
+
+    /** @brief Record the primary log id of an entry */
+    void primaryLogId(uint32_t id, const std::string& logId);
+
+    /** @brief Forget an entry */
+    void erase(uint32_t id);
+
+    /** @brief Forget the entries which are not in ids */
+    void retain(const std::set<uint32_t>& ids);
+
+    /** @brief Write the cache file now, if it changed */
+    void flush();
+
+    /** @struct Record
+     *
+     *  Cached entry, the metadata is valid for the decoded.json with the
+     *  modification time and size given.
+     */
+    struct Record
+    {
+        int64_t mtime = 0;
+        uint64_t size = 0;
+        bool parsed = false;
+        CperMetadata metadata;
+        std::string primaryLogId;
+    };
+
+  private:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    /** @brief A record changed, write the cache file soon */
+    void changed();
+
+    std::filesystem::path file;
+
+    std::map<uint32_t, Record> records;
+
+    /** @brief Changes not written yet */
+    bool dirty = false;
+
+    Timer flushTimer;
+};
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -27,20 +27,16 @@
 #include <unistd.h>
 
 #include <chrono>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
-#include <nlohmann/json.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <regex>
-#include <sdeventplus/exception.hpp>
-#include <sdeventplus/source/base.hpp>
+#include <set>
 #include <string>
 
 #include "dump-extensions/faultlog-dump/faultlog_dump_config.h"
 
-using json = nlohmann::json;
-
 namespace phosphor
 {
 namespace dump
@@ -93,18 +89,30 @@ void Manager::limitTotalDumpSize()
 #ifdef FAULTLOG_DUMP_ROTATION
     log<level::ERR>("Not enough space: Deleting oldest dumps");
 
-    // Delete the oldest dumps till free size is enough
-    auto d = entries.begin();
-    while (d != entries.end())
+    // Pick the oldest dumps freeing enough space from the entry sizes and
+    // delete them at once, the dump directory is walked again only to check
+    // the result. Another round is only needed when entries reported a size
+    // smaller than their files.
+    auto needed = storage.shortfall(FAULTLOG_DUMP_MIN_SPACE_REQD);
+    while (needed > 0 && !entries.empty())
     {
-        auto& entry = d->second;
-        d++;
-        entry->delete_();
-        size = getAllowedSize();
-        if (size >= FAULTLOG_DUMP_MIN_SPACE_REQD)
+        std::vector<std::pair<uint32_t, size_t>> sizes;
+        sizes.reserve(entries.size());
+        for (const auto& [id, entry] : entries)
+        {
+            sizes.emplace_back(id, (entry->size() + 1023) / 1024);
+        }
+
+        auto victims = selectEvictions(sizes, needed);
+        for (auto id : victims)
         {
-            break;
+            // delete_() erases the entry from the map
+            if (auto it = entries.find(id); it != entries.end())
+            {
+                it->second->delete_();
+            }
         }
+        needed = storage.shortfall(FAULTLOG_DUMP_MIN_SPACE_REQD);
     }
 
     if (!entries.size() && !getAllowedSize())
@@ -170,6 +178,8 @@ sdbusplus::message::object_path
                     pcieFunctionNumber, pcieDeviceNumber, pcieSegmentNumber,
                     pcieDeviceBusNumber, pcieSecondaryBusNumber, pcieSlotNumber,
                     originatorId, originatorType, *this)));
+        index.insert(id, timeStamp * 1000 * 1000, CperMetadata{});
+        metadataCache.primaryLogId(id, primayLogId);
     }
     catch (const std::invalid_argument& e)
     {
@@ -183,31 +193,12 @@ sdbusplus::message::object_path
     return objPath.string();
 }
 
-uint32_t cperDump(const std::string& dumpId, const std::string& dumpPath,
-                  const std::string& cperPath)
+std::vector<std::string> cperDump(const std::string& dumpId,
+                                  const std::string& dumpPath,
+                                  const std::string& cperPath)
 {
-    // Construct fpga dump arguments
-    std::vector<char*> arg_v;
-    std::string cPath = CPER_DUMP_BIN_PATH;
-    arg_v.push_back(&cPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string sOption = "-s";
-    arg_v.push_back(&sOption[0]);
-    arg_v.push_back(const_cast<char*>(cperPath.c_str()));
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // CPER dump execution is failed.
-    auto error = errno;
-    log<level::ERR>("CPER dump: Error occurred during CPER dump execution",
-                    entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    // Construct CPER dump arguments
+    return {CPER_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId, "-s", cperPath};
 }
 
 FaultLogEntryInfo Manager::captureDump(phosphor::dump::DumpCreateParams params)
@@ -229,71 +220,58 @@ FaultLogEntryInfo Manager::captureDump(phosphor::dump::DumpCreateParams params)
         params.erase("CPER_PATH");
     }
 
-    pid_t pid = fork();
-    if (pid == 0)
+    if (type != FaultDataType::CPER)
     {
-        if (type == FaultDataType::CPER)
-        {
-            fs::path dumpPath(dumpDir);
-            auto id = std::to_string(lastEntryId + 1);
-            dumpPath /= id;
-            cperDump(id, dumpPath, cperPath);
-        }
-        else
-        {
-            log<level::ERR>("FaultLog dump: Invalid FaultDataType");
-            elog<InternalFailure>();
-        }
+        log<level::ERR>("FaultLog dump: Invalid FaultDataType");
+        elog<InternalFailure>();
     }
-    else if (pid > 0)
-    {
-        auto entryId = lastEntryId + 1;
-        Child::Callback callback = [this, pid, entryId](Child&,
-                                                        const siginfo_t* si) {
-            if (si->si_status != 0)
-            {
-                std::string msg = "Dump process failed: (signo)" +
-                                  std::to_string(si->si_signo) + "; (code)" +
-                                  std::to_string(si->si_code) + "; (errno)" +
-                                  std::to_string(si->si_errno) + "; (pid)" +
-                                  std::to_string(si->si_pid) + "; (status)" +
-                                  std::to_string(si->si_status);
-                log<level::ERR>(msg.c_str());
-                this->createDumpFailed(entryId);
-            }
 
-            this->childPtrMap.erase(pid);
-        };
-
-        try
-        {
-            childPtrMap.emplace(pid,
-                                std::make_unique<Child>(eventLoop.get(), pid,
-                                                        WEXITED | WSTOPPED,
-                                                        std::move(callback)));
-        }
-        catch (const sdeventplus::SdEventError& ex)
+    auto entryId = lastEntryId + 1;
+#ifdef FAULTLOG_NATIVE_INGEST
+    if (!ingest.submit(entryId, cperPath))
+    {
+        log<level::ERR>("FaultLog dump: CPER ingestion is saturated");
+        elog<Unavailable>();
+    }
+#else
+    fs::path dumpPath(dumpDir);
+    auto id = std::to_string(entryId);
+    dumpPath /= id;
+    auto argv = cperDump(id, dumpPath, cperPath);
+
+    spawner.spawn(argv, collectorOptions(CollectorClass::Probe),
+                  [this, entryId](const siginfo_t* si) {
+        if (si->si_status != 0)
         {
-            // Failed to add to event loop
-            log<level::ERR>(
-                fmt::format(
-                    "Error occurred during the sdeventplus::source::Child "
-                    "creation ex({})",
-                    ex.what())
-                    .c_str());
-            elog<InternalFailure>();
+            std::string msg = "Dump process failed: (signo)" +
+                              std::to_string(si->si_signo) + "; (code)" +
+                              std::to_string(si->si_code) + "; (errno)" +
+                              std::to_string(si->si_errno) + "; (pid)" +
+                              std::to_string(si->si_pid) + "; (status)" +
+                              std::to_string(si->si_status);
+            log<level::ERR>(msg.c_str());
+            this->createDumpFailed(entryId);
         }
+        storage.settle(entryId);
+    });
+#endif
+    storage.reserve(entryId, FAULTLOG_DUMP_MAX_SIZE);
+
+    return std::make_tuple(++lastEntryId, type, additionalTypeName,
+                           primaryLogId);
+}
+
+void Manager::ingested(uint32_t id, const std::optional<fs::path>& file)
+{
+    if (file)
+    {
+        createEntry(*file);
     }
     else
     {
-        auto error = errno;
-        log<level::ERR>("FaultLog dump: Error occurred during fork",
-                        entry("ERRNO=%d", error));
-        elog<InternalFailure>();
+        createDumpFailed(id);
     }
-
-    return std::make_tuple(++lastEntryId, type, additionalTypeName,
-                           primaryLogId);
+    storage.settle(id);
 }
 
 void Manager::createEntry(const fs::path& file)
@@ -313,34 +291,29 @@ void Manager::createEntry(const fs::path& file)
         return;
     }
 
-    std::string notifType = "NA";
-    std::string sectionType = "NA";
-    std::string fruid = "NA";
-    std::string severity = "NA";
-    std::string nvipSignature = "NA";
-    std::string nvSeverity = "NA";
-    std::string nvSocketNumber = "NA";
-    std::string pcieVendorID = "NA";
-    std::string pcieDeviceID = "NA";
-    std::string pcieClassCode = "NA";
-    std::string pcieFunctionNumber = "NA";
-    std::string pcieDeviceNumber = "NA";
-    std::string pcieSegmentNumber = "NA";
-    std::string pcieDeviceBusNumber = "NA";
-    std::string pcieSecondaryBusNumber = "NA";
-    std::string pcieSlotNumber = "NA";
-
     auto idString = match[ID_POS];
     uint64_t timestamp = stoull(match[EPOCHTIME_POS]) * 1000 * 1000;
 
     auto id = stoul(idString);
 
+    auto metadata = metadataCache.read(id, "/var/lib/logging/dumps/faultlog/" +
+                                               std::to_string(id) +
+                                               "/Decoded/decoded.json");
+
     // If there is an existing entry update it and return.
     auto dumpEntry = entries.find(id);
     if (dumpEntry != entries.end())
     {
         dynamic_cast<phosphor::dump::faultLog::Entry*>(dumpEntry->second.get())
-            ->update(timestamp, fs::file_size(file), file, std::to_string(id));
+            ->update(timestamp, fs::file_size(file), file, metadata);
+        // Without decoded.json the entry keeps its CPER properties, and so
+        // does the index
+        if (!metadata)
+        {
+            auto indexed = index.find(id);
+            metadata = indexed ? indexed->metadata : CperMetadata{};
+        }
+        index.insert(id, timestamp, *metadata);
 
         return;
     }
@@ -348,106 +321,16 @@ void Manager::createEntry(const fs::path& file)
     // Entry Object path.
     auto objPath = fs::path(baseEntryPath) / std::to_string(id);
 
-    std::string cperDecodePath = "/var/lib/logging/dumps/faultlog/" +
-                                 std::to_string(id) + "/Decoded/decoded.json";
-    std::ifstream cperFile(cperDecodePath.c_str());
+    // The CPER numbering continues after the restored entries
+    auto primaryLogId = metadataCache.primaryLogId(id);
+    lastCperId = std::max(
+        lastCperId,
+        static_cast<uint32_t>(std::strtoul(primaryLogId.c_str(), nullptr, 10)));
 
-    if (cperFile.is_open())
+    CperMetadata cper;
+    if (metadata)
     {
-        json jsonData = json::parse(cperFile, nullptr, false);
-        if (!jsonData.is_discarded())
-        {
-            if (jsonData.contains("Header"))
-            {
-                const json& hdr = jsonData["Header"];
-
-                if (hdr.contains("NotificationType"))
-                    notifType = hdr["NotificationType"];
-
-                if (hdr.contains("SectionCount"))
-                {
-                    // int secCount = hdr["SectionCount"];  // unused
-                    if (jsonData.contains("Sections") &&
-                        jsonData["Sections"].is_array() &&
-                        jsonData["Sections"].size() > 0)
-                    {
-                        // TODO: Log multiple-sections
-
-                        // Log only the 1st section (most CPERs have only 1)
-                        const json& toLog = jsonData["Sections"][0];
-
-                        if (toLog.contains("SectionDescriptor"))
-                        {
-                            const json& descToLog = toLog["SectionDescriptor"];
-
-                            // Extracting existing fields
-                            if (descToLog.contains("SectionType"))
-                                sectionType = descToLog["SectionType"];
-
-                            if (descToLog.contains("FRUId"))
-                                fruid = descToLog["FRUId"];
-
-                            if (descToLog.contains("SectionSeverity"))
-                                severity = descToLog["SectionSeverity"];
-
-                            if (toLog.contains("Section"))
-                            {
-                                const json& sectionToLog = toLog["Section"];
-
-                                if (sectionToLog.contains("IPSignature"))
-                                    nvipSignature = sectionToLog["IPSignature"];
-
-                                if (sectionToLog.contains("Severity"))
-                                    nvSeverity = sectionToLog["Severity"];
-
-                                if (sectionToLog.contains("SocketNumber"))
-                                    nvSocketNumber =
-                                        sectionToLog["SocketNumber"].dump();
-
-                                if (sectionToLog.contains("DeviceID"))
-                                {
-                                    const json& devID =
-                                        sectionToLog["DeviceID"];
-
-                                    if (devID.contains("VendorID"))
-                                        pcieVendorID = devID["VendorID"];
-
-                                    if (devID.contains("DeviceID"))
-                                        pcieDeviceID = devID["DeviceID"];
-
-                                    if (devID.contains("ClassCode"))
-                                        pcieClassCode = devID["ClassCode"];
-
-                                    if (devID.contains("FunctionNumber"))
-                                        pcieFunctionNumber =
-                                            devID["FunctionNumber"];
-
-                                    if (devID.contains("DeviceNumber"))
-                                        pcieDeviceNumber =
-                                            devID["DeviceNumber"];
-
-                                    if (devID.contains("SegmentNumber"))
-                                        pcieSegmentNumber =
-                                            devID["SegmentNumber"];
-
-                                    if (devID.contains("DeviceBusNumber"))
-                                        pcieDeviceBusNumber =
-                                            devID["DeviceBusNumber"];
-
-                                    if (devID.contains("SecondaryBusNumber"))
-                                        pcieSecondaryBusNumber =
-                                            devID["SecondaryBusNumber"];
-
-                                    if (devID.contains("SlotNumber"))
-                                        pcieSlotNumber =
-                                            devID["SlotNumber"].dump();
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        cper = std::move(*metadata);
     }
     else
     {
@@ -463,13 +346,17 @@ void Manager::createEntry(const fs::path& file)
         entries.insert(std::make_pair(
             id, std::make_unique<faultLog::Entry>(
                     bus, objPath.c_str(), id, timestamp, FaultDataType::CPER,
-                    "CPER", "0", fs::file_size(file), file,
-                    phosphor::dump::OperationStatus::Completed, notifType,
-                    sectionType, fruid, severity, nvipSignature, nvSeverity,
-                    nvSocketNumber, pcieVendorID, pcieDeviceID, pcieClassCode,
-                    pcieFunctionNumber, pcieDeviceNumber, pcieSegmentNumber,
-                    pcieDeviceBusNumber, pcieSecondaryBusNumber, pcieSlotNumber,
-                    originatorId, originatorType, *this)));
+                    "CPER", primaryLogId, fs::file_size(file), file,
+                    phosphor::dump::OperationStatus::Completed,
+                    cper.notificationType, cper.sectionType, cper.fruid,
+                    cper.severity, cper.nvipSignature, cper.nvSeverity,
+                    cper.nvSocketNumber, cper.pcieVendorID, cper.pcieDeviceID,
+                    cper.pcieClassCode, cper.pcieFunctionNumber,
+                    cper.pcieDeviceNumber, cper.pcieSegmentNumber,
+                    cper.pcieDeviceBusNumber, cper.pcieSecondaryBusNumber,
+                    cper.pcieSlotNumber, originatorId, originatorType,
+                    *this)));
+        index.insert(id, timestamp, cper);
     }
 
     catch (const std::invalid_argument& e)
@@ -520,6 +407,13 @@ void Manager::watchCallback(const UserMap& fileInfo)
     }
 }
 
+void Manager::erase(uint32_t entryId)
+{
+    index.erase(entryId);
+    metadataCache.erase(entryId);
+    phosphor::dump::Manager::erase(entryId);
+}
+
 void Manager::removeWatch(const fs::path& path)
 {
     // Delete Watch entry from map.
@@ -531,10 +425,12 @@ void Manager::restore()
     fs::path dir(dumpDir);
     if (!fs::exists(dir) || fs::is_empty(dir))
     {
+        metadataCache.retain({});
         return;
     }
 
     // Dump file path: <DUMP_PATH>/<id>/<filename>
+    std::set<uint32_t> ids;
     for (const auto& p : fs::directory_iterator(dir))
     {
         auto idStr = p.path().filename().string();
@@ -544,8 +440,9 @@ void Manager::restore()
         if ((fs::is_directory(p.path())) &&
             std::all_of(idStr.begin(), idStr.end(), ::isdigit))
         {
-            lastEntryId = std::max(lastEntryId,
-                                   static_cast<uint32_t>(std::stoul(idStr)));
+            auto id = static_cast<uint32_t>(std::stoul(idStr));
+            ids.insert(id);
+            lastEntryId = std::max(lastEntryId, id);
             for (const auto& fileIt : fs::directory_iterator(p.path()))
             {
                 // Create dump entry d-bus object.
@@ -556,52 +453,17 @@ void Manager::restore()
             }
         }
     }
-}
-
-size_t calculate_directory_size(const fs::path& directory)
-{
-    size_t size = 0;
 
-    for (const auto& entry : fs::directory_iterator(directory))
-    {
-        if (fs::is_directory(entry))
-        {
-            size += calculate_directory_size(entry.path());
-        }
-        else if (fs::is_regular_file(entry))
-        {
-            size += fs::file_size(entry);
-        }
-    }
-    return size;
+    // Drop the metadata of the dumps removed while the manager was down
+    metadataCache.retain(ids);
+    metadataCache.flush();
 }
 
 size_t Manager::getAllowedSize()
 {
-    size_t size = 0;
-
-    try
-    {
-        size = calculate_directory_size(dumpDir);
-    }
-    catch (const fs::filesystem_error& e)
-    {
-        log<level::ERR>(
-            fmt::format(
-                "An error occurred during the calculation e({}), and the size 0 is returned.",
-                e.what())
-                .c_str());
-        return 0;
-    }
-
-    // Convert size into KB
-    size = size / 1024;
-
-    // Set the Dump size to Maximum  if the free space is greater than
-    // Dump max size otherwise return the available size.
-
-    size = (size > FAULTLOG_DUMP_TOTAL_SIZE ? 0
-                                            : FAULTLOG_DUMP_TOTAL_SIZE - size);
+    // Space left within FAULTLOG_DUMP_TOTAL_SIZE and on the partition, less
+    // what the dumps in flight reserved
+    auto size = storage.available();
 
     if (size > FAULTLOG_DUMP_MAX_SIZE)
     {
@@ -16,9 +16,15 @@
  */
 #pragma once
 
+#include "collector_class.hpp"
+#include "cper_ingest.hpp"
+#include "cper_metadata_cache.hpp"
 #include "dump_manager.hpp"
+#include "dump_spawner.hpp"
 #include "dump_utils.hpp"
 #include "faultlog_dump_entry.hpp"
+#include "faultlog_index.hpp"
+#include "storage_budget.hpp"
 #include "watch.hpp"
 #include "xyz/openbmc_project/Dump/Entry/CPERDecode/server.hpp"
 #include "xyz/openbmc_project/Dump/NewDump/server.hpp"
@@ -26,9 +32,10 @@
 #include <experimental/filesystem>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
-#include <sdeventplus/source/child.hpp>
 #include <xyz/openbmc_project/Dump/Create/server.hpp>
 
+#include "dump-extensions/faultlog-dump/faultlog_dump_config.h"
+
 namespace phosphor
 {
 namespace dump
@@ -44,7 +51,6 @@ using UserMap = phosphor::dump::inotify::UserMap;
 namespace fs = std::filesystem;
 
 using Watch = phosphor::dump::inotify::Watch;
-using ::sdeventplus::source::Child;
 
 using DumpId = uint32_t;
 using AdditionalTypeName = std::string;
@@ -87,7 +93,20 @@ class Manager :
             std::bind(
                 std::mem_fn(&phosphor::dump::faultLog::Manager::watchCallback),
                 this, std::placeholders::_1)),
-        dumpDir(filePath), lastCperId(0)
+        dumpDir(filePath), lastCperId(0), spawner(eventLoop),
+        storage(StorageBudget::instance().addPool("faultlog", filePath,
+                                                  FAULTLOG_DUMP_TOTAL_SIZE,
+                                                  FAULTLOG_DUMP_MAX_SIZE)),
+        metadataCache(eventLoop.get(), FAULTLOG_METADATA_CACHE),
+        queryInterface(bus, path, index)
+#ifdef FAULTLOG_NATIVE_INGEST
+        ,
+        ingest(eventLoop.get(), filePath, FAULTLOG_INGEST_WORKERS,
+               FAULTLOG_INGEST_QUEUE_DEPTH,
+               [this](uint32_t id, const std::optional<fs::path>& file) {
+        ingested(id, file);
+    })
+#endif
     {}
 
     /** @brief Implementation of dump watch call back
@@ -121,6 +140,12 @@ class Manager :
         }
     }
 
+  protected:
+    /** @brief Erase the entry and drop it from the index
+     *  @param[in] entryId - unique identifier of the entry
+     */
+    void erase(uint32_t entryId) override;
+
   private:
     /** @brief Create Dump entry d-bus object
      *  @param[in] fullPath - Full path of the Dump file name
@@ -133,14 +158,20 @@ class Manager :
      */
     FaultLogEntryInfo captureDump(phosphor::dump::DumpCreateParams params);
 
+    /** @brief Record the outcome of a CPER ingested in process
+     *  @param[in] id - Dump entry id.
+     *  @param[in] file - Dump file, std::nullopt if the ingestion failed.
+     */
+    void ingested(uint32_t id, const std::optional<fs::path>& file);
+
     /** @brief Remove specified watch object pointer from the
      *        watch map and associated entry from the map.
      *        @param[in] path - unique identifier of the map
      */
     void removeWatch(const fs::path& path);
 
-    /** @brief Calculate per dump allowed size based on the available
-     *        size in the dump location.
+    /** @brief Calculate per dump allowed size based on the space left in
+     *        the storage budget.
      *  @returns dump size in kilobytes.
      */
     size_t getAllowedSize();
@@ -174,8 +205,25 @@ class Manager :
     /** @brief Id of the last CPER entry */
     uint32_t lastCperId;
 
-    /** @brief map of SDEventPlus child pointer added to event loop */
-    std::map<pid_t, std::unique_ptr<Child>> childPtrMap;
+    /** @brief Launches the CPER dump collections */
+    Spawner spawner;
+
+    /** @brief Space of the faultlog dumps in the storage budget */
+    StoragePool& storage;
+
+    /** @brief Metadata of the entries, kept across restarts */
+    CperMetadataCache metadataCache;
+
+    /** @brief Entries by CPER attributes */
+    FaultLogIndex index;
+
+    /** @brief Queries of the index over D-Bus */
+    QueryInterface queryInterface;
+
+#ifdef FAULTLOG_NATIVE_INGEST
+    /** @brief Writes the CPER dumps without starting a collector */
+    CperIngest ingest;
+#endif
 };
 
 } // namespace faultLog
@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include "cper_metadata.hpp"
 #include "dump_entry.hpp"
 #include "xyz/openbmc_project/Common/FaultLogType/server.hpp"
 #include "xyz/openbmc_project/Dump/Entry/CPERDecode/server.hpp"
@@ -24,12 +25,9 @@
 #include "xyz/openbmc_project/Object/Delete/server.hpp"
 #include "xyz/openbmc_project/Time/EpochTime/server.hpp"
 
-#include <fstream>
-#include <nlohmann/json.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
 #include <string>
-using json = nlohmann::json;
 
 namespace phosphor
 {
@@ -143,9 +141,10 @@ class Entry : virtual public phosphor::dump::Entry, virtual public EntryIfaces
      * @param[in] timeStamp - Dump creation timestamp
      * @param[in] fileSize - Dump file size in bytes.
      * @param[in] file - Name of dump file.
+     * @param[in] metadata - Metadata of the CPER, std::nullopt to keep it.
      */
     void update(uint64_t timeStamp, uint64_t fileSize, const fs::path& filePath,
-                std::string id)
+                const std::optional<CperMetadata>& metadata)
     {
         elapsed(timeStamp);
         size(fileSize);
@@ -153,113 +152,35 @@ class Entry : virtual public phosphor::dump::Entry, virtual public EntryIfaces
         file = filePath;
         completedTime(timeStamp);
 
-        std::string cperDecodePath = "/var/lib/logging/dumps/faultlog/" + id +
-                                     "/Decoded/decoded.json";
-        std::ifstream cperFile(cperDecodePath.c_str());
-
-        if (cperFile.is_open())
+        if (metadata)
         {
-            json jsonData = json::parse(cperFile, nullptr, false);
-            if (!jsonData.is_discarded())
-            {
-                if (jsonData.contains("Header"))
-                {
-                    const json& hdr = jsonData["Header"];
-
-                    if (hdr.contains("NotificationType"))
-                        notificationType(hdr["NotificationType"]);
-
-                    if (hdr.contains("SectionCount"))
-                    {
-                        // int secCount = hdr["SectionCount"];  // unused
-                        if (jsonData.contains("Sections") &&
-                            jsonData["Sections"].is_array() &&
-                            jsonData["Sections"].size() > 0)
-                        {
-                            // TODO: Log multiple-sections
-
-                            // Log only the 1st section (most CPERs have only 1)
-                            const json& toLog = jsonData["Sections"][0];
-
-                            if (toLog.contains("SectionDescriptor"))
-                            {
-                                const json& descToLog =
-                                    toLog["SectionDescriptor"];
-
-                                // Extracting existing fields
-                                if (descToLog.contains("SectionType"))
-                                    sectionType(descToLog["SectionType"]);
-
-                                if (descToLog.contains("FRUId"))
-                                    fruid(descToLog["FRUId"]);
-
-                                if (descToLog.contains("SectionSeverity"))
-                                    severity(descToLog["SectionSeverity"]);
-
-                                if (toLog.contains("Section"))
-                                {
-                                    const json& sectionToLog = toLog["Section"];
-
-                                    if (sectionToLog.contains("IPSignature"))
-                                        nvipSignature(
-                                            sectionToLog["IPSignature"]);
-
-                                    if (sectionToLog.contains("Severity"))
-                                        nvSeverity(sectionToLog["Severity"]);
-
-                                    if (sectionToLog.contains("SocketNumber"))
-                                        nvSocketNumber(
-                                            sectionToLog["SocketNumber"]
-                                                .dump());
-
-                                    if (sectionToLog.contains("DeviceID"))
-                                    {
-                                        const json& devID =
-                                            sectionToLog["DeviceID"];
-
-                                        if (devID.contains("VendorID"))
-                                            pcieVendorID(devID["VendorID"]);
-
-                                        if (devID.contains("DeviceID"))
-                                            pcieDeviceID(devID["DeviceID"]);
-
-                                        if (devID.contains("ClassCode"))
-                                            pcieClassCode(devID["ClassCode"]);
-
-                                        if (devID.contains("FunctionNumber"))
-                                            pcieFunctionNumber(
-                                                devID["FunctionNumber"]);
-
-                                        if (devID.contains("DeviceNumber"))
-                                            pcieDeviceNumber(
-                                                devID["DeviceNumber"]);
-
-                                        if (devID.contains("SegmentNumber"))
-                                            pcieSegmentNumber(
-                                                devID["SegmentNumber"]);
-
-                                        if (devID.contains("DeviceBusNumber"))
-                                            pcieDeviceBusNumber(
-                                                devID["DeviceBusNumber"]);
-
-                                        if (devID.contains(
-                                                "SecondaryBusNumber"))
-                                            pcieSecondaryBusNumber(
-                                                devID["SecondaryBusNumber"]);
-
-                                        if (devID.contains("SlotNumber"))
-                                            pcieSlotNumber(
-                                                devID["SlotNumber"].dump());
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            cperMetadata(*metadata);
         }
     }
 
+    /** @brief Publish the metadata of the decoded CPER
+     *  @param[in] metadata - Metadata of the CPER.
+     */
+    void cperMetadata(const CperMetadata& metadata)
+    {
+        notificationType(metadata.notificationType);
+        sectionType(metadata.sectionType);
+        fruid(metadata.fruid);
+        severity(metadata.severity);
+        nvipSignature(metadata.nvipSignature);
+        nvSeverity(metadata.nvSeverity);
+        nvSocketNumber(metadata.nvSocketNumber);
+        pcieVendorID(metadata.pcieVendorID);
+        pcieDeviceID(metadata.pcieDeviceID);
+        pcieClassCode(metadata.pcieClassCode);
+        pcieFunctionNumber(metadata.pcieFunctionNumber);
+        pcieDeviceNumber(metadata.pcieDeviceNumber);
+        pcieSegmentNumber(metadata.pcieSegmentNumber);
+        pcieDeviceBusNumber(metadata.pcieDeviceBusNumber);
+        pcieSecondaryBusNumber(metadata.pcieSecondaryBusNumber);
+        pcieSlotNumber(metadata.pcieSlotNumber);
+    }
+
     /** @brief Minimal interface to allow setting status as failed
      */
     void setFailedStatus(void)
@@ -0,0 +1,257 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "faultlog_index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+constexpr auto QUERY_INTERFACE = "com.nvidia.Dump.FaultLogQuery";
+constexpr auto INVALID_ARGUMENT =
+    "xyz.openbmc_project.Common.Error.InvalidArgument";
+constexpr auto INTERNAL_FAILURE =
+    "xyz.openbmc_project.Common.Error.InternalFailure";
+
+const std::array<FaultLogIndex::Attribute, FaultLogIndex::attributeCount>
+    FaultLogIndex::attributes{{
+    {"NotificationType", &CperMetadata::notificationType},
+    {"SectionType", &CperMetadata::sectionType},
+    {"FRUID", &CperMetadata::fruid},
+    {"Severity", &CperMetadata::severity},
+    {"NvIPSignature", &CperMetadata::nvipSignature},
+    {"NvSeverity", &CperMetadata::nvSeverity},
+    {"NvSocketNumber", &CperMetadata::nvSocketNumber},
+    {"PCIeVendorID", &CperMetadata::pcieVendorID},
+    {"PCIeDeviceID", &CperMetadata::pcieDeviceID},
+}};
+
+void FaultLogIndex::insert(uint32_t id, uint64_t timestamp,
+                           const CperMetadata& metadata)
+{
+    erase(id);
+
+    auto& record = records[id] = {id, timestamp, metadata};
+    for (size_t i = 0; i < attributes.size(); ++i)
+    {
+        postings[i][record.metadata.*attributes[i].member].insert(id);
+    }
+    byTime.emplace(timestamp, id);
+}
+
+void FaultLogIndex::erase(uint32_t id)
+{
+    auto it = records.find(id);
+    if (it == records.end())
+    {
+        return;
+    }
+
+    const auto& record = it->second;
+    for (size_t i = 0; i < attributes.size(); ++i)
+    {
+        auto posting = postings[i].find(record.metadata.*attributes[i].member);
+        posting->second.erase(id);
+        if (posting->second.empty())
+        {
+            postings[i].erase(posting);
+        }
+    }
+    byTime.erase({record.timestamp, id});
+    records.erase(it);
+}
+
+const FaultLogRecord* FaultLogIndex::find(uint32_t id) const
+{
+    auto it = records.find(id);
+    return it == records.end() ? nullptr : &it->second;
+}
+
+std::pair<size_t, std::vector<const FaultLogRecord*>>
+    FaultLogIndex::query(const FaultLogQuery& query) const
+{
+    // Entries of each filter, the smallest set is walked
+    std::vector<std::pair<size_t, const std::string*>> filters;
+    const std::set<uint32_t>* smallest = nullptr;
+    for (const auto& [property, value] : query.filters)
+    {
+        auto attribute = std::find_if(attributes.begin(), attributes.end(),
+                                      [&property](const auto& a) {
+            return property == a.property;
+        });
+        if (attribute == attributes.end())
+        {
+            throw std::invalid_argument("Not an indexed property: " +
+                                        property);
+        }
+
+        auto i = static_cast<size_t>(attribute - attributes.begin());
+        auto posting = postings[i].find(value);
+        if (posting == postings[i].end())
+        {
+            return {0, {}};
+        }
+        if (smallest == nullptr || posting->second.size() < smallest->size())
+        {
+            smallest = &posting->second;
+        }
+        filters.emplace_back(i, &value);
+    }
+
+    auto matches = [&](const FaultLogRecord& record) {
+        if (record.timestamp < query.since || record.timestamp > query.until)
+        {
+            return false;
+        }
+        return std::all_of(filters.begin(), filters.end(),
+                           [&record](const auto& filter) {
+            return record.metadata.*attributes[filter.first].member ==
+                   *filter.second;
+        });
+    };
+
+    std::vector<const FaultLogRecord*> found;
+    if (smallest != nullptr)
+    {
+        for (auto id : *smallest)
+        {
+            const auto& record = records.at(id);
+            if (matches(record))
+            {
+                found.push_back(&record);
+            }
+        }
+    }
+    else
+    {
+        auto end = byTime.upper_bound({query.until,
+                                       std::numeric_limits<uint32_t>::max()});
+        for (auto it = byTime.lower_bound({query.since, 0}); it != end; ++it)
+        {
+            found.push_back(&records.at(it->second));
+        }
+        if (query.sort == QuerySort::Id)
+        {
+            std::sort(found.begin(), found.end(),
+                      [](const auto* l, const auto* r) {
+                return l->id < r->id;
+            });
+        }
+    }
+
+    // Walking a filter gives the id order, the time index the time order
+    if (query.sort == QuerySort::Timestamp && smallest != nullptr)
+    {
+        std::sort(found.begin(), found.end(), [](const auto* l, const auto* r) {
+            return std::tie(l->timestamp, l->id) <
+                   std::tie(r->timestamp, r->id);
+        });
+    }
+    if (query.descending)
+    {
+        std::reverse(found.begin(), found.end());
+    }
+
+    auto total = found.size();
+    auto first = std::min(query.offset, total);
+    auto last = query.limit == 0 ? total
+                                 : first + std::min(query.limit, total - first);
+    found.erase(found.begin() + last, found.end());
+    found.erase(found.begin(), found.begin() + first);
+    return {total, std::move(found)};
+}
+
+const sdbusplus::vtable::vtable_t QueryInterface::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("Query", "a{ss}ttsbuu", "ua(utsssssss)",
+                              QueryInterface::query),
+    sdbusplus::vtable::end()};
+
+QueryInterface::QueryInterface(sdbusplus::bus_t& bus, const char* path,
+                               const FaultLogIndex& index) :
+    index(index),
+    interface(bus, path, QUERY_INTERFACE, vtable, this)
+{}
+
+int QueryInterface::query(sd_bus_message* msg, void* context,
+                          sd_bus_error* error)
+{
+    auto self = static_cast<QueryInterface*>(context);
+    using Record = std::tuple<uint32_t, uint64_t, std::string, std::string,
+                              std::string, std::string, std::string,
+                              std::string, std::string>;
+
+    try
+    {
+        sdbusplus::message_t m(msg);
+        FaultLogQuery query;
+        std::string sortBy;
+        uint32_t offset = 0;
+        uint32_t limit = 0;
+        m.read(query.filters, query.since, query.until, sortBy,
+               query.descending, offset, limit);
+        query.offset = offset;
+        query.limit = limit;
+        if (sortBy == "Timestamp")
+        {
+            query.sort = QuerySort::Timestamp;
+        }
+        else if (sortBy != "Id")
+        {
+            throw std::invalid_argument("Invalid sort: " + sortBy);
+        }
+
+        auto [total, page] = self->index.query(query);
+        std::vector<Record> records;
+        records.reserve(page.size());
+        for (const auto* r : page)
+        {
+            const auto& cper = r->metadata;
+            records.emplace_back(r->id, r->timestamp, cper.notificationType,
+                                 cper.sectionType, cper.fruid, cper.severity,
+                                 cper.nvipSignature, cper.pcieVendorID,
+                                 cper.pcieDeviceID);
+        }
+
+        auto reply = m.new_method_return();
+        reply.append(static_cast<uint32_t>(total), records);
+        reply.method_return();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        sd_bus_error_set(error, INVALID_ARGUMENT, e.what());
+        return -EINVAL;
+    }
+    catch (const std::exception& e)
+    {
+        sd_bus_error_set(error, INTERNAL_FAILURE, e.what());
+        return -EIO;
+    }
+    return 1;
+}
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "cper_metadata.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace faultLog
+{
+
+/** @struct FaultLogRecord
+ *
+ *  Indexed attributes of a faultlog entry.
+ */
+struct FaultLogRecord
+{
+    uint32_t id;
+    /** @brief Microseconds since the epoch the dump was created or completed */
+    uint64_t timestamp;
+    CperMetadata metadata;
+};
+
+/** @brief Order of the query results */
+enum class QuerySort
+{
+    Id,
+    Timestamp,
+};
+
+/** @struct FaultLogQuery
+ *
+ *  Entries wanted, with all the filters and in the time range.
+ */
+struct FaultLogQuery
+{
+    /** @brief Value of the CPERDecode property, by property name */
+    std::map<std::string, std::string> filters;
+    uint64_t since = 0;
+    uint64_t until = std::numeric_limits<uint64_t>::max();
+    QuerySort sort = QuerySort::Id;
+    bool descending = false;
+    /** @brief Page of the results, all of them from offset if limit is 0 */
+    size_t offset = 0;
+    size_t limit = 0;
+};
+
+/** @class FaultLogIndex
+ *
+ *  @brief Faultlog entries indexed by their CPER attributes and time.
+ *
+ *  A query walks the entries of its most selective filter, checking the
+ *  others on each of them, or the time index when it has no filter.
+ */
+class FaultLogIndex
+{
+  public:
+    /** @brief Add or replace an entry
+     *  @param[in] id - Entry id.
+     *  @param[in] timestamp - Microseconds since the epoch.
+     *  @param[in] metadata - Metadata of the CPER.
+     */
+    void insert(uint32_t id, uint64_t timestamp, const CperMetadata& metadata);
+
+    /** @brief Remove an entry, if indexed */
+    void erase(uint32_t id);
+
+    /** @brief Indexed attributes of an entry, nullptr if not indexed */
+    const FaultLogRecord* find(uint32_t id) const;
+
+    /** @brief Find the entries
+     *  @details std::invalid_argument is thrown for a filter on a property
+     *           which is not indexed.
+     *
+     *  @param[in] query - Filters, order and page.
+     *
+     *  @returns the number of entries matching and the requested page
+     */
+    std::pair<size_t, std::vector<const FaultLogRecord*>>
+        query(const FaultLogQuery& query) const;
+
+  private:
+    /** @brief Indexed property and its field in the metadata */
+    struct Attribute
+    {
+        const char* property;
+        std::string CperMetadata::*member;
+    };
+
+    static constexpr size_t attributeCount = 9;
+
+    static const std::array<Attribute, attributeCount> attributes;
+
+    /** @brief Entry ids by value, for each attribute */
+    std::array<std::unordered_map<std::string, std::set<uint32_t>>,
+               attributeCount>
+        postings;
+
+    std::map<uint32_t, FaultLogRecord> records;
+
+    /** @brief Entries by timestamp */
+    std::set<std::pair<uint64_t, uint32_t>> byTime;
+};
+
+/** @class QueryInterface
+ *
+ *  @brief com.nvidia.Dump.FaultLogQuery interface of the faultlog manager,
+ *  returning the entries matching CPER attributes in one call.
+ *
+ *  Query(a{ss} filters, t since, t until, s sortBy, b descending, u offset,
+ *  u limit) returns the number of entries matching and, for the page
+ *  requested, (id, timestamp, NotificationType, SectionType, FRUID,
+ *  Severity, NvIPSignature, PCIeVendorID, PCIeDeviceID). sortBy is "Id" or
+ *  "Timestamp", a limit of 0 returns all the entries from offset.
+ */
+class QueryInterface
+{
+  public:
+    QueryInterface() = delete;
+    QueryInterface(const QueryInterface&) = delete;
+    QueryInterface& operator=(const QueryInterface&) = delete;
+    QueryInterface(QueryInterface&&) = delete;
+    QueryInterface& operator=(QueryInterface&&) = delete;
+    ~QueryInterface() = default;
+
+    /** @brief Constructor to put the interface at the manager path
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Faultlog manager object path.
+     *  @param[in] index - Index of the faultlog entries.
+     */
+    QueryInterface(sdbusplus::bus_t& bus, const char* path,
+                   const FaultLogIndex& index);
+
+  private:
+    /** @brief Query method handler */
+    static int query(sd_bus_message* msg, void* context, sd_bus_error* error);
+
+    static const sdbusplus::vtable::vtable_t vtable[];
+
+    const FaultLogIndex& index;
+
+    sdbusplus::server::interface_t interface;
+};
+
+} // namespace faultLog
+} // namespace dump
+} // namespace phosphor
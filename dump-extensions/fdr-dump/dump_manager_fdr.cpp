@@ -30,8 +30,6 @@
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <regex>
-#include <sdeventplus/exception.hpp>
-#include <sdeventplus/source/base.hpp>
 #include <string>
 
 #include "dump-extensions/fdr-dump/fdr_dump_config.h"
@@ -85,15 +83,16 @@ sdbusplus::message::object_path
 
     // Handle other actions like clear log and generate certificates
     auto dumpAction = std::get<std::string>(params["Action"]);
+    AdmissionDecision decision = AdmissionDecision::Admitted;
     if (dumpAction != "Collect")
     {
-        triggerFDRDumpScript(params);
+        triggerFDRDumpScript(params, decision);
         return fs::path(baseEntryPath).string();
     }
 
     // Limit dumps to max allowed entries
     limitDumpEntries();
-    auto id = triggerFDRDumpScript(params);
+    auto id = triggerFDRDumpScript(params, decision);
 
     // Entry Object path.
     auto objPath = fs::path(baseEntryPath) / std::to_string(id);
@@ -122,40 +121,34 @@ sdbusplus::message::object_path
                         entry("ID=%d", id));
         elog<InternalFailure>();
     }
+    setAdmission(id, decision);
 
     return objPath.string();
 }
 
-uint32_t fdrDump(phosphor::dump::DumpCreateParams params)
+std::vector<std::string> fdrDump(phosphor::dump::DumpCreateParams params)
 {
     // Construct FDR dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = FDR_DUMP_BIN_PATH;
-    std::string time_start, time_end, max_dump_size, extended_source;
+    std::vector<std::string> argv{FDR_DUMP_BIN_PATH};
 
-    arg_v.push_back(&fPath[0]);
+    argv.push_back("-p");
+    argv.push_back(std::get<std::string>(params["DumpPath"]));
 
-    arg_v.push_back(const_cast<char*>("-p"));
-    auto dump_path = std::get<std::string>(params["DumpPath"]);
-    arg_v.push_back(const_cast<char*>(dump_path.c_str()));
+    argv.push_back("-i");
+    argv.push_back(std::get<std::string>(params["DumpID"]));
 
-    arg_v.push_back(const_cast<char*>("-i"));
-    auto dump_id = std::get<std::string>(params["DumpID"]);
-    arg_v.push_back(const_cast<char*>(dump_id.c_str()));
-
-    arg_v.push_back(const_cast<char*>("-a"));
+    argv.push_back("-a");
     auto dump_action = std::get<std::string>(params["Action"]);
     std::transform(dump_action.begin(), dump_action.end(), dump_action.begin(),
                    ::tolower);
-    arg_v.push_back(const_cast<char*>(dump_action.c_str()));
+    argv.push_back(dump_action);
 
     if (auto search = params.find("TimeRangeStart"); search != params.end())
     {
         if (std::holds_alternative<std::string>(search->second))
         {
-            arg_v.push_back(const_cast<char*>("-s"));
-            time_start = std::get<std::string>(params["TimeRangeStart"]);
-            arg_v.push_back(const_cast<char*>(time_start.c_str()));
+            argv.push_back("-s");
+            argv.push_back(std::get<std::string>(search->second));
         }
     }
 
@@ -163,9 +156,8 @@ uint32_t fdrDump(phosphor::dump::DumpCreateParams params)
     {
         if (std::holds_alternative<std::string>(search->second))
         {
-            arg_v.push_back(const_cast<char*>("-e"));
-            time_end = std::get<std::string>(params["TimeRangeEnd"]);
-            arg_v.push_back(const_cast<char*>(time_end.c_str()));
+            argv.push_back("-e");
+            argv.push_back(std::get<std::string>(search->second));
         }
     }
 
@@ -173,9 +165,8 @@ uint32_t fdrDump(phosphor::dump::DumpCreateParams params)
     {
         if (std::holds_alternative<std::string>(search->second))
         {
-            arg_v.push_back(const_cast<char*>("-m"));
-            max_dump_size = std::get<std::string>(params["MaxDumpSize"]);
-            arg_v.push_back(const_cast<char*>(max_dump_size.c_str()));
+            argv.push_back("-m");
+            argv.push_back(std::get<std::string>(search->second));
         }
     }
 
@@ -183,75 +174,24 @@ uint32_t fdrDump(phosphor::dump::DumpCreateParams params)
     {
         if (std::holds_alternative<std::string>(search->second))
         {
-            arg_v.push_back(const_cast<char*>("-S"));
-            extended_source = std::get<std::string>(params["ExtendedSource"]);
-            arg_v.push_back(const_cast<char*>(extended_source.c_str()));
+            argv.push_back("-S");
+            argv.push_back(std::get<std::string>(search->second));
         }
     }
 
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // FDR Dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "FDR dump: Error occurred during fdr dump function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return argv;
 }
 
-uint32_t Manager::triggerFDRDumpScript(phosphor::dump::DumpCreateParams params)
+uint32_t Manager::triggerFDRDumpScript(phosphor::dump::DumpCreateParams params,
+                                       AdmissionDecision& decision)
 {
-    // check if minimum required space is available on destination partition
-    std::error_code ec{};
-    fs::path partitionPath(dumpDir);
-
+    // Only the collections write to the dump partition
     auto dumpAction = std::get<std::string>(params["Action"]);
-    if (dumpAction == "Collect")
+    auto collect = (dumpAction == "Collect");
+    size_t size = 0;
+    if (collect)
     {
-#if (JFFS_SPACE_CALC_INACCURACY_OFFSET_WORKAROUND_PERCENT > 0)
-        /* jffs2 space available problem is worked around by substracting 2%
-           of capacity from currently available space, eg. 200M - 4M = 196M
-           it solves problem of failed dump when user request it close to space
-           limit so instead if silently failing the task user receives
-           appropriate message. Test it yourself - fill up the partition until
-           'no space left' message appears, check `df -T` for available space,
-           if there seems to be at least 1% space available then you just
-           reproduced the issue*/
-        uintmax_t offset =
-            (fs::space(partitionPath, ec).capacity *
-             JFFS_SPACE_CALC_INACCURACY_OFFSET_WORKAROUND_PERCENT) /
-            100;
-        uintmax_t spaceAvailable = fs::space(partitionPath, ec).available;
-        uintmax_t sizeLeftKb = 0;
-        if (spaceAvailable >= offset)
-        {
-            sizeLeftKb = (spaceAvailable - offset) / 1024;
-        }
-#else
-        uintmax_t sizeLeftKb = fs::space(partitionPath, ec).available / 1024;
-#endif
-        uintmax_t reqSizeKb = FDR_DUMP_MIN_SPACE_REQD;
-
-        if (ec.value() != 0)
-        {
-            log<level::ERR>("Failed to check available space");
-            elog<InternalFailure>();
-        }
-
-        if (sizeLeftKb < reqSizeKb)
-        {
-            log<level::ERR>(
-                "Not enough space available to create FDR dump",
-                entry("REQ_KB=%d", static_cast<unsigned int>(reqSizeKb)),
-                entry("LEFT_KB=%d", static_cast<unsigned int>(sizeLeftKb)));
-            using QuotaExceeded = sdbusplus::xyz::openbmc_project::Dump::
-                Create::Error::QuotaExceeded;
-            using Reason =
-                xyz::openbmc_project::Dump::Create::QuotaExceeded::REASON;
-            elog<QuotaExceeded>(Reason("Not enough space: Delete old dumps"));
-        }
+        size = getAllowedSize();
     }
 
     // Validate request argument
@@ -287,76 +227,104 @@ uint32_t Manager::triggerFDRDumpScript(phosphor::dump::DumpCreateParams params)
     log<level::INFO>(
         fmt::format("Capturing FDR dump of type ({})", diagnosticType).c_str());
 
-    pid_t pid = fork();
-
-    if (pid == 0)
-    {
-        fs::path dumpPath(dumpDir);
-        auto id = std::to_string(lastEntryId + 1);
-        dumpPath /= id;
-
-        if (diagnosticType == typeFDR)
+    fs::path dumpPath(dumpDir);
+    auto id = std::to_string(lastEntryId + 1);
+    dumpPath /= id;
+
+    params["DumpID"] = id;
+    params["DumpPath"] = dumpPath;
+    auto argv = fdrDump(params);
+
+    // Collections wait for the BMC pressure to subside, the other actions
+    // are short and only run fewer at a time
+    auto entryId = lastEntryId + 1;
+    auto priority = collect ? DumpPriority::Low : DumpPriority::High;
+    decision = admission.submit(
+        entryId, priority,
+        [this, argv = std::move(argv), collect,
+         entryId](AdmissionDecision decision, bool queued) {
+        if (!queued)
         {
-            params["DumpID"] = id;
-            params["DumpPath"] = dumpPath;
-            fdrDump(params);
+            startDump(argv, entryId);
+            return;
         }
-        else
+        if (collect)
         {
-            log<level::ERR>("FDR dump: Invalid DiagnosticType");
-            elog<InternalFailure>();
-        }
-    }
-    else if (pid > 0)
-    {
-        auto entryId = lastEntryId + 1;
-        Child::Callback callback = [this, pid, entryId](Child&,
-                                                        const siginfo_t* si) {
-            if (si->si_status != 0)
+            auto it = entries.find(entryId);
+            if (it == entries.end() || !it->second)
             {
-                std::string msg = "Dump process failed: (signo)" +
-                                  std::to_string(si->si_signo) + "; (code)" +
-                                  std::to_string(si->si_code) + "; (errno)" +
-                                  std::to_string(si->si_errno) + "; (pid)" +
-                                  std::to_string(si->si_pid) + "; (status)" +
-                                  std::to_string(si->si_status);
-                log<level::ERR>(msg.c_str());
-                this->createDumpFailed(entryId);
+                // erase() cancels the waiting collections, nothing to
+                // collect for an entry which went away anyway
+                log<level::INFO>("Dropping a held back FDR dump without entry",
+                                 entry("ID=%d", entryId));
+                storage.settle(entryId);
+                admission.done();
+                return;
             }
-
-            this->childPtrMap.erase(pid);
-        };
-
+            setAdmission(entryId, decision);
+        }
         try
         {
-            childPtrMap.emplace(pid,
-                                std::make_unique<Child>(eventLoop.get(), pid,
-                                                        WEXITED | WSTOPPED,
-                                                        std::move(callback)));
+            startDump(argv, entryId);
         }
-        catch (const sdeventplus::SdEventError& ex)
+        catch (const std::exception& e)
         {
-            // Failed to add to event loop
-            log<level::ERR>(
-                fmt::format(
-                    "Error occurred during the sdeventplus::source::Child "
-                    "creation ex({})",
-                    ex.what())
-                    .c_str());
-            elog<InternalFailure>();
+            log<level::ERR>("Failed to start a held back FDR dump",
+                            entry("ID=%d", entryId),
+                            entry("ERROR=%s", e.what()));
+            this->createDumpFailed(entryId);
+            storage.settle(entryId);
+            admission.done();
         }
+    });
+    if (decision != AdmissionDecision::Admitted)
+    {
+        log<level::INFO>(
+            "FDR dump held back by the BMC pressure", entry("ID=%d", entryId),
+            entry("DECISION=%s", admissionDecisionToString(decision).c_str()));
     }
-    else
+    if (collect)
     {
-        auto error = errno;
-        log<level::ERR>("FDR dump: Error occurred during fork",
-                        entry("ERRNO=%d", error));
-        elog<InternalFailure>();
+        storage.reserve(entryId, size);
     }
 
     return ++lastEntryId;
 }
 
+void Manager::erase(uint32_t entryId)
+{
+    // A collection still waiting for the pressure to subside must not bring
+    // the entry back once started
+    if (admission.cancel(entryId))
+    {
+        log<level::INFO>("Cancelled a held back FDR dump",
+                         entry("ID=%d", entryId));
+        storage.settle(entryId);
+    }
+    phosphor::dump::Manager::erase(entryId);
+}
+
+void Manager::startDump(const std::vector<std::string>& argv,
+                        uint32_t entryId)
+{
+    spawner.spawn(argv, collectorOptions(CollectorClass::Bulk),
+                  [this, entryId](const siginfo_t* si) {
+        if (si->si_status != 0)
+        {
+            std::string msg = "Dump process failed: (signo)" +
+                              std::to_string(si->si_signo) + "; (code)" +
+                              std::to_string(si->si_code) + "; (errno)" +
+                              std::to_string(si->si_errno) + "; (pid)" +
+                              std::to_string(si->si_pid) + "; (status)" +
+                              std::to_string(si->si_status);
+            log<level::ERR>(msg.c_str());
+            this->createDumpFailed(entryId);
+        }
+        storage.settle(entryId);
+        admission.done();
+    });
+}
+
 void Manager::createEntry(const fs::path& file)
 {
     // Dump File Name format obmcdump_ID_EPOCHTIME.EXT
@@ -490,28 +458,18 @@ size_t Manager::getAllowedSize()
     using namespace sdbusplus::xyz::openbmc_project::Dump::Create::Error;
     using Reason = xyz::openbmc_project::Dump::Create::QuotaExceeded::REASON;
 
-    auto size = 0;
-
-    // Get current size of the dump directory.
-    for (const auto& p : fs::recursive_directory_iterator(dumpDir))
-    {
-        if (!fs::is_directory(p))
-        {
-            size += fs::file_size(p);
-        }
-    }
-
-    // Convert size into KB
-    size = size / 1024;
-
-    // Set the Dump size to Maximum  if the free space is greater than
-    // Dump max size otherwise return the available size.
-
-    size = (size > FDR_DUMP_TOTAL_SIZE ? 0 : FDR_DUMP_TOTAL_SIZE - size);
+    // Space left within FDR_DUMP_TOTAL_SIZE and on the partition, less what
+    // the dumps in flight reserved
+    auto size = storage.available();
 
     if (size < FDR_DUMP_MIN_SPACE_REQD)
     {
         // Reached to maximum limit
+        log<level::ERR>(
+            "Not enough space available to create FDR dump",
+            entry("REQ_KB=%d",
+                  static_cast<unsigned int>(FDR_DUMP_MIN_SPACE_REQD)),
+            entry("LEFT_KB=%d", static_cast<unsigned int>(size)));
         elog<QuotaExceeded>(Reason("Not enough space: Delete old dumps"));
     }
     if (size > FDR_DUMP_MAX_SIZE)
@@ -16,9 +16,12 @@
  */
 #pragma once
 
+#include "collector_class.hpp"
 #include "dump_manager.hpp"
+#include "dump_spawner.hpp"
 #include "dump_utils.hpp"
 #include "fdr_dump_entry.hpp"
+#include "storage_budget.hpp"
 #include "watch.hpp"
 #include "xyz/openbmc_project/Dump/NewDump/server.hpp"
 
@@ -26,7 +29,6 @@
 #include <map>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
-#include <sdeventplus/source/child.hpp>
 #include <xyz/openbmc_project/Dump/Create/server.hpp>
 
 namespace phosphor
@@ -44,7 +46,6 @@ using UserMap = phosphor::dump::inotify::UserMap;
 namespace fs = std::filesystem;
 
 using Watch = phosphor::dump::inotify::Watch;
-using ::sdeventplus::source::Child;
 
 /** @class Manager
  *  @brief OpenBMC Dump manager implementation.
@@ -80,7 +81,9 @@ class Manager :
             filePath,
             std::bind(std::mem_fn(&phosphor::dump::FDR::Manager::watchCallback),
                       this, std::placeholders::_1)),
-        dumpDir(filePath)
+        dumpDir(filePath), spawner(eventLoop), admission(eventLoop.get()),
+        storage(StorageBudget::instance().addPool(
+            "fdr", filePath, FDR_DUMP_TOTAL_SIZE, FDR_DUMP_MAX_SIZE))
     {}
 
     /** @brief Implementation of dump watch call back
@@ -114,6 +117,14 @@ class Manager :
         }
     }
 
+  protected:
+    /** @brief Erase specified entry d-bus object, cancelling its collection
+     *         if it still waits for the admission control
+     *
+     * @param[in] entryId - unique identifier of the entry
+     */
+    void erase(uint32_t entryId) override;
+
   private:
     /** @brief Create Dump entry d-bus object
      *  @param[in] fullPath - Full path of the Dump file name
@@ -122,9 +133,19 @@ class Manager :
 
     /** @brief Capture FDR Dump.
      *  @param[in] parama - Additional arguments for FDR dump.
+     *  @param[out] decision - Admission of the dump, to publish once the
+     *              entry exists.
      *  @return id - The Dump entry id number.
      */
-    uint32_t triggerFDRDumpScript(phosphor::dump::DumpCreateParams params);
+    uint32_t triggerFDRDumpScript(phosphor::dump::DumpCreateParams params,
+                                  AdmissionDecision& decision);
+
+    /** @brief Start the FDR script for a dump admitted by the admission
+     *         control
+     *  @param[in] argv - FDR script command line.
+     *  @param[in] entryId - Id of the dump entry.
+     */
+    void startDump(const std::vector<std::string>& argv, uint32_t entryId);
 
     /** @brief Remove specified watch object pointer from the
      *        watch map and associated entry from the map.
@@ -132,8 +153,8 @@ class Manager :
      */
     void removeWatch(const fs::path& path);
 
-    /** @brief Calculate per dump allowed size based on the available
-     *        size in the dump location.
+    /** @brief Calculate per dump allowed size based on the space left in
+     *        the storage budget.
      *  @returns dump size in kilobytes.
      */
     size_t getAllowedSize();
@@ -152,8 +173,14 @@ class Manager :
      */
     std::map<fs::path, std::unique_ptr<Watch>> childWatchMap;
 
-    /** @brief map of SDEventPlus child pointer added to event loop */
-    std::map<pid_t, std::unique_ptr<Child>> childPtrMap;
+    /** @brief Launches the FDR dump collections */
+    Spawner spawner;
+
+    /** @brief Holds back the collections while the BMC is under pressure */
+    AdmissionControl admission;
+
+    /** @brief Space of the FDR dumps in the storage budget */
+    StoragePool& storage;
 
     /** @brief Erase FDR dump entry and delete respective dump file
      *         from permanent location on reaching maximum allowed
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "diagnostic_scheduler.hpp"
+
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace system
+{
+
+bool DiagnosticScheduler::submit(Resources resources, Launch&& launch)
+{
+    Resources reserved = ResourceNone;
+    for (const auto& pending : queue)
+    {
+        reserved |= pending.resources;
+    }
+    if ((busy | reserved) & resources)
+    {
+        queue.push_back({resources, std::move(launch)});
+        return false;
+    }
+
+    busy |= resources;
+    try
+    {
+        launch(false);
+    }
+    catch (...)
+    {
+        busy &= ~resources;
+        throw;
+    }
+    return true;
+}
+
+void DiagnosticScheduler::release(Resources resources)
+{
+    busy &= ~resources;
+
+    // Take out all the diagnostics that can start before starting them,
+    // a launch failing releases its resources through us.
+    std::vector<Launch> ready;
+    Resources reserved = ResourceNone;
+    for (auto it = queue.begin(); it != queue.end();)
+    {
+        if ((busy | reserved) & it->resources)
+        {
+            reserved |= it->resources;
+            ++it;
+            continue;
+        }
+        busy |= it->resources;
+        ready.push_back(std::move(it->launch));
+        it = queue.erase(it);
+    }
+    for (auto& launch : ready)
+    {
+        launch(true);
+    }
+}
+
+} // namespace system
+} // namespace dump
+} // namespace phosphor
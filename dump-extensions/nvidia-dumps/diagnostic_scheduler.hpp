@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "dump_manager.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+namespace system
+{
+
+/** @brief Hardware and system resources a diagnostic holds while it runs,
+ *         diagnostics holding a common resource do not run together.
+ */
+enum Resource : uint32_t
+{
+    ResourceNone = 0,
+    /** I2C bus shared by the FPGA, the MCU and the retimers */
+    ResourceI2cBus = 1 << 0,
+    ResourceFpga = 1 << 1,
+    ResourceRetimer = 1 << 2,
+    ResourceErot = 1 << 3,
+    /** NSM endpoints, one per device class */
+    ResourceNsmNVSwitch = 1 << 4,
+    ResourceNsmNIC = 1 << 5,
+    ResourceNsmGPU = 1 << 6,
+    /** Collection keeping the BMC CPU busy */
+    ResourceCpuHeavy = 1 << 7,
+};
+
+using Resources = uint32_t;
+
+/** @brief Arguments of a diagnostic collection */
+struct DiagnosticArgs
+{
+    std::string id;
+    std::string dumpPath;
+    std::string deviceID;
+    std::string vendorId;
+    size_t size;
+    bool resume;
+    phosphor::dump::DumpCreateParams params;
+};
+
+/** @brief Entry of the diagnostic registry */
+struct Diagnostic
+{
+    /** @brief DiagnosticType value, empty for the dreport system dump */
+    const char* type;
+
+    /** @brief Resources held while collecting */
+    Resources resources;
+
+    /** @brief Collector command line */
+    std::vector<std::string> (*command)(const DiagnosticArgs& args);
+};
+
+/** @class DiagnosticScheduler
+ *  @brief Runs diagnostics as soon as the resources they hold are free.
+ *
+ *  @details Requests conflicting with a running diagnostic are queued and
+ *  started in order when it ends. A queued request reserves its resources,
+ *  so later requests do not overtake it on them.
+ */
+class DiagnosticScheduler
+{
+  public:
+    /** @brief Starts a diagnostic, told whether it was queued */
+    using Launch = std::function<void(bool queued)>;
+
+    /** @brief Run a diagnostic now if its resources are free, else queue it
+     *  @param[in] resources - resources the diagnostic holds.
+     *  @param[in] launch - starts the diagnostic. When run now, exceptions
+     *                      are passed to the caller and the resources freed.
+     *                      When queued, it must release the resources itself
+     *                      on failure.
+     *  @return true if run now, false if queued.
+     */
+    bool submit(Resources resources, Launch&& launch);
+
+    /** @brief Free the resources of a diagnostic that ended and start the
+     *         queued ones that can run.
+     *  @param[in] resources - resources the diagnostic held.
+     */
+    void release(Resources resources);
+
+    /** @brief Number of queued diagnostics */
+    size_t queued() const
+    {
+        return queue.size();
+    }
+
+  private:
+    struct Pending
+    {
+        Resources resources;
+        Launch launch;
+    };
+
+    std::deque<Pending> queue;
+
+    /** @brief Resources held by the running diagnostics */
+    Resources busy = ResourceNone;
+};
+
+} // namespace system
+} // namespace dump
+} // namespace phosphor
@@ -32,8 +32,6 @@
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <regex>
-#include <sdeventplus/exception.hpp>
-#include <sdeventplus/source/base.hpp>
 
 namespace phosphor
 {
@@ -82,17 +80,10 @@ sdbusplus::message::object_path
 {
     // Limit dumps to max allowed entries
     limitDumpEntries();
-    // Check whether there is same dump already running
-    // Also ensure RetLTSSM and RetRegister will not run at the same time
+    // Check whether there is same dump already running or queued, dumps
+    // sharing resources are serialized by the scheduler
     auto dumpType = std::get<std::string>(params["DiagnosticType"]);
-    if ((Manager::dumpInProgress.find(dumpType) !=
-         Manager::dumpInProgress.end()) ||
-        (Manager::dumpInProgress.find("RetLTSSM") !=
-             Manager::dumpInProgress.end() &&
-         dumpType == "RetRegister") ||
-        (Manager::dumpInProgress.find("RetRegister") !=
-             Manager::dumpInProgress.end() &&
-         dumpType == "RetLTSSM"))
+    if (Manager::dumpInProgress.find(dumpType) != Manager::dumpInProgress.end())
     {
         elog<Unavailable>();
     }
@@ -130,561 +121,384 @@ sdbusplus::message::object_path
     return objPath.string();
 }
 
-// captureDump helper functions
-uint32_t executeDreport(const std::string& dumpType, const std::string& dumpId,
-                        const std::string& dumpPath, const size_t size,
-                        const std::array<std::string, 3>& addArgs)
+// captureDump helper functions, building the collector command lines
+std::vector<std::string>
+    executeDreport(const std::string& dumpType, const std::string& dumpId,
+                   const std::string& dumpPath, const size_t size,
+                   const std::array<std::string, 3>& addArgs)
 {
     // Construct dreport arguments
-    std::vector<char*> arg_v;
-    std::string fPath = "/usr/bin/dreport";
-    arg_v.push_back(&fPath[0]);
-    std::string dOption = "-d";
-    arg_v.push_back(&dOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string sOption = "-s";
-    arg_v.push_back(&sOption[0]);
-    arg_v.push_back(const_cast<char*>(std::to_string(size).c_str()));
-    std::string qOption = "-q";
-    arg_v.push_back(&qOption[0]);
-    std::string vOption = "-v";
-    arg_v.push_back(&vOption[0]);
-    std::string tOption = "-t";
-    arg_v.push_back(&tOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpType.c_str()));
+    std::vector<std::string> argv{"/usr/bin/dreport",
+                                  "-d",
+                                  dumpPath,
+                                  "-i",
+                                  dumpId,
+                                  "-s",
+                                  std::to_string(size),
+                                  "-q",
+                                  "-v",
+                                  "-t",
+                                  dumpType};
     // Add additional arguments
-    std::string aOption = "-a";
-    for (int i = 0; i < (int)addArgs.size(); i++)
+    for (const auto& addArg : addArgs)
     {
-        arg_v.push_back(&aOption[0]);
-        arg_v.push_back(const_cast<char*>((addArgs[i]).c_str()));
+        argv.push_back("-a");
+        argv.push_back(addArg);
     }
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // dreport script execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during dreport function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return argv;
 }
 
-uint32_t selfTest(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> selfTest(const std::string& dumpId,
+                                  const std::string& dumpPath)
 {
     // Construct selftest dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = SELFTEST_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string dOption = "-v";
-    arg_v.push_back(&dOption[0]);
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // self test execution is failed.
-    auto error = errno;
-    log<level::ERR>("System dump: Error occurred during self test execution",
-                    entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {SELFTEST_BIN_PATH, "-p", dumpPath, "-i", dumpId, "-v"};
 }
 
-uint32_t fpgaRegDump(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> fpgaRegDump(const std::string& dumpId,
+                                     const std::string& dumpPath)
 {
     // Construct fpga dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = FPGA_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // FPGA register dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during FPGA register dump execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {FPGA_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId};
 }
 
-uint32_t mcuRegDump(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> mcuRegDump(const std::string& dumpId,
+                                    const std::string& dumpPath)
 {
     // Construct mcu dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = MCU_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // MCU register dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during MCU register dump execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {MCU_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId};
 }
 
-uint32_t netDump(const std::string& dumpId, const std::string& dumpPath,
-                 const std::string& tempPath, const std::string& targetDevice)
+std::vector<std::string> netDump(const std::string& dumpId,
+                                 const std::string& dumpPath,
+                                 const std::string& tempPath,
+                                 const std::string& targetDevice, bool resume)
 {
     // Construct net dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = NET_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string tOption = "-t";
-    arg_v.push_back(&tOption[0]);
-    arg_v.push_back(const_cast<char*>(tempPath.c_str()));
-    std::string dOption = "-d";
-    arg_v.push_back(&dOption[0]);
-    arg_v.push_back(const_cast<char*>(targetDevice.c_str()));
-
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // dreport script execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during netDump function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    std::vector<std::string> argv{NET_DUMP_BIN_PATH, "-p", dumpPath, "-i",
+                                  dumpId,            "-t", tempPath, "-d",
+                                  targetDevice};
+    if (resume)
+    {
+        argv.push_back("-r");
+    }
+    return argv;
 }
 
-uint32_t erotDump(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> erotDump(const std::string& dumpId,
+                                  const std::string& dumpPath)
 {
     // Construct erot dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = EROT_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // dreport script execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during dreport function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {EROT_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId};
 }
 
-uint32_t retimerLtssmDump(const std::string& dumpId,
-                          const std::string& dumpPath,
-                          const std::string& vendorId)
+std::vector<std::string> retimerLtssmDump(const std::string& dumpId,
+                                          const std::string& dumpPath,
+                                          const std::string& vendorId)
 {
     // Construct Ltssm dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = RETIMER_LTSSM_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string vOption = "-v";
+    std::vector<std::string> argv{RETIMER_LTSSM_DUMP_BIN_PATH, "-p", dumpPath,
+                                  "-i", dumpId};
     if (!vendorId.empty())
     {
-        arg_v.push_back(&vOption[0]);
-        arg_v.push_back(const_cast<char*>(vendorId.c_str()));
+        argv.push_back("-v");
+        argv.push_back(vendorId);
     }
-
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // Retimer LTSSM Dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during retimerLtssmDump function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return argv;
 }
 
-uint32_t retimerRegisterDump(const std::string& dumpId,
-                             const std::string& dumpPath,
-                             const std::string& retimer_address,
-                             const std::string& vendorId)
+std::vector<std::string>
+    retimerRegisterDump(const std::string& dumpId, const std::string& dumpPath,
+                        const std::string& retimer_address,
+                        const std::string& vendorId)
 {
     // Construct Register dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = RETIMER_REGISTER_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string aOption = "-a";
-    std::string vOption = "-v";
+    std::vector<std::string> argv{RETIMER_REGISTER_DUMP_BIN_PATH, "-p",
+                                  dumpPath, "-i", dumpId};
     if (!retimer_address.empty())
     {
-        arg_v.push_back(&aOption[0]);
-        arg_v.push_back(const_cast<char*>(retimer_address.c_str()));
+        argv.push_back("-a");
+        argv.push_back(retimer_address);
     }
     if (!vendorId.empty())
     {
-        arg_v.push_back(&vOption[0]);
-        arg_v.push_back(const_cast<char*>(vendorId.c_str()));
+        argv.push_back("-v");
+        argv.push_back(vendorId);
     }
-
-    arg_v.push_back(nullptr);
-
-    execv(arg_v[0], &arg_v[0]);
-
-    // Retimer Register Dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during retimerRegisterDump function execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return argv;
 }
 
-uint32_t fwAttrsDump(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> fwAttrsDump(const std::string& dumpId,
+                                     const std::string& dumpPath)
 {
     // Construct firmware attributes dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = FWATTRS_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string dOption = "-v";
-    arg_v.push_back(&dOption[0]);
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // firmware attributes dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during firmware attributes dump execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {FWATTRS_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId, "-v"};
 }
 
-uint32_t hwCheckoutDump(const std::string& dumpId, const std::string& dumpPath)
+std::vector<std::string> hwCheckoutDump(const std::string& dumpId,
+                                        const std::string& dumpPath)
 {
     // Construct hardware checkout dump arguments
-    std::vector<char*> arg_v;
-    std::string fPath = HWCHECKOUT_DUMP_BIN_PATH;
-    arg_v.push_back(&fPath[0]);
-    std::string pOption = "-p";
-    arg_v.push_back(&pOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpPath.c_str()));
-    std::string iOption = "-i";
-    arg_v.push_back(&iOption[0]);
-    arg_v.push_back(const_cast<char*>(dumpId.c_str()));
-    std::string dOption = "-v";
-    arg_v.push_back(&dOption[0]);
-
-    arg_v.push_back(nullptr);
-    execv(arg_v[0], &arg_v[0]);
-
-    // hardware checkout dump execution is failed.
-    auto error = errno;
-    log<level::ERR>(
-        "System dump: Error occurred during hardware checkout dump execution",
-        entry("ERRNO=%d", error));
-    elog<InternalFailure>();
+    return {HWCHECKOUT_DUMP_BIN_PATH, "-p", dumpPath, "-i", dumpId, "-v"};
 }
 
-uint32_t Manager::captureDump(phosphor::dump::DumpCreateParams params)
+namespace
 {
-    // check if minimum required space is available on destination partition
-    std::error_code ec{};
-    fs::path partitionPath(dumpDir);
-
-#if (JFFS_SPACE_CALC_INACCURACY_OFFSET_WORKAROUND_PERCENT > 0)
-    /* jffs2 space available problem is worked around by substracting 2%
-       of capacity from currently available space, eg. 200M - 4M = 196M
-       it solves problem of failed dump when user request it close to space
-       limit so instead if silently failing the task user receives appropriate
-       message. Test it yourself - fill up the partition until 'no space left'
-       message appears, check `df -T` for available space, if there seems to be
-       at least 1% space available then you just reproduced the issue*/
-    uintmax_t offset = (fs::space(partitionPath, ec).capacity *
-                        JFFS_SPACE_CALC_INACCURACY_OFFSET_WORKAROUND_PERCENT) /
-                       100;
-    uintmax_t spaceAvailable = fs::space(partitionPath, ec).available;
-    uintmax_t sizeLeftKb = 0;
-    if (spaceAvailable >= offset)
+
+/** @brief Diagnostics collected by the system dump manager, with the
+ *         resources each holds while running */
+const std::array<Diagnostic, 13> diagnostics{{
+    {"", ResourceCpuHeavy,
+     [](const DiagnosticArgs& args) {
+    // Fix additional arguments order 'bf_ip', 'bf_username', 'bf_password'
+    std::array<std::string, 3> addArgs;
+    for (auto itr = args.params.begin(); itr != args.params.end(); ++itr)
+    {
+        auto kvPair = itr->first + "=" + std::get<std::string>(itr->second);
+        if (itr->first == "bf_ip")
+        {
+            addArgs[0] = kvPair;
+        }
+        else if (itr->first == "bf_username")
+        {
+            addArgs[1] = kvPair;
+        }
+        else if (itr->first == "bf_password")
+        {
+            addArgs[2] = kvPair;
+        }
+        else
+        {
+            log<level::ERR>("System dump: Unknown additional arguments");
+        }
+    }
+    return executeDreport("system", args.id, args.dumpPath, args.size,
+                          addArgs);
+}},
+    {"SelfTest", ResourceI2cBus | ResourceFpga,
+     [](const DiagnosticArgs& args) {
+    return selfTest(args.id, args.dumpPath);
+}},
+    {"FPGA", ResourceI2cBus | ResourceFpga,
+     [](const DiagnosticArgs& args) {
+    return fpgaRegDump(args.id, args.dumpPath);
+}},
+    {"MCU", ResourceI2cBus,
+     [](const DiagnosticArgs& args) {
+    return mcuRegDump(args.id, args.dumpPath);
+}},
+    {"EROT", ResourceErot,
+     [](const DiagnosticArgs& args) {
+    return erotDump(args.id, args.dumpPath);
+}},
+    {"ROT", ResourceErot,
+     [](const DiagnosticArgs& args) {
+    return erotDump(args.id, args.dumpPath);
+}},
+    {"Net_NVSwitch", ResourceNsmNVSwitch,
+     [](const DiagnosticArgs& args) {
+    return netDump(args.id, args.dumpPath, NET_DUMP_TEMP_PATH,
+                   "Net_NVSwitch_" + args.deviceID, args.resume);
+}},
+    {"Net_NVLinkManagementNIC", ResourceNsmNIC,
+     [](const DiagnosticArgs& args) {
+    return netDump(args.id, args.dumpPath, NET_DUMP_TEMP_PATH,
+                   "Net_NVLinkManagementNIC_" + args.deviceID, args.resume);
+}},
+    {"Net_GPU_SXM", ResourceNsmGPU,
+     [](const DiagnosticArgs& args) {
+    return netDump(args.id, args.dumpPath, NET_DUMP_TEMP_PATH,
+                   "Net_GPU_SXM_" + args.deviceID, args.resume);
+}},
+    {"RetLTSSM", ResourceI2cBus | ResourceRetimer,
+     [](const DiagnosticArgs& args) {
+    return retimerLtssmDump(args.id, args.dumpPath, args.vendorId);
+}},
+    {"RetRegister", ResourceI2cBus | ResourceRetimer,
+     [](const DiagnosticArgs& args) {
+    std::string retimerAddress;
+    if (auto it = args.params.find("Address"); it != args.params.end())
     {
-        sizeLeftKb = (spaceAvailable - offset) / 1024;
+        retimerAddress = std::get<std::string>(it->second);
     }
-#else
-    uintmax_t sizeLeftKb = fs::space(partitionPath, ec).available / 1024;
-#endif
-    uintmax_t reqSizeKb = SYSTEM_DUMP_MIN_SPACE_REQD;
-
-    if (ec.value() != 0)
+    return retimerRegisterDump(args.id, args.dumpPath, retimerAddress,
+                               args.vendorId);
+}},
+    {"FirmwareAttributes", ResourceNone,
+     [](const DiagnosticArgs& args) {
+    return fwAttrsDump(args.id, args.dumpPath);
+}},
+    {"HardwareCheckout", ResourceCpuHeavy,
+     [](const DiagnosticArgs& args) {
+    return hwCheckoutDump(args.id, args.dumpPath);
+}},
+}};
+
+/** @brief Registry entry of a DiagnosticType, nullptr if unknown */
+const Diagnostic* findDiagnostic(const std::string& type)
+{
+    for (const auto& diagnostic : diagnostics)
     {
-        log<level::ERR>("Failed to check available space");
-        elog<InternalFailure>();
+        if (type == diagnostic.type)
+        {
+            return &diagnostic;
+        }
     }
+    return nullptr;
+}
 
-    if (sizeLeftKb < reqSizeKb)
+} // namespace
+
+void Manager::startDump(const Diagnostic& diagnostic, DiagnosticArgs args,
+                        uint32_t entryId)
+{
+    std::string diagnosticType = diagnostic.type;
+    if (diagnosticType == "RetLTSSM")
     {
-        log<level::ERR>(
-            "Not enough space available to create system dump",
-            entry("REQ_KB=%d", static_cast<unsigned int>(reqSizeKb)),
-            entry("LEFT_KB=%d", static_cast<unsigned int>(sizeLeftKb)));
-        using QuotaExceeded =
-            sdbusplus::xyz::openbmc_project::Dump::Create::Error::QuotaExceeded;
-        using Reason =
-            xyz::openbmc_project::Dump::Create::QuotaExceeded::REASON;
-        elog<QuotaExceeded>(Reason("Not enough space: Delete old dumps"));
+        retimerState.debugMode(true);
     }
+    args.vendorId = retimerState.getVendorId();
+
+    // The CPU heavy collections compress, the others read a device
+    auto collectorClass = (diagnostic.resources & ResourceCpuHeavy)
+                              ? CollectorClass::Bulk
+                              : CollectorClass::Probe;
+    spawner.spawn(diagnostic.command(args), collectorOptions(collectorClass),
+                  [this, entryId, diagnosticType,
+                   resources = diagnostic.resources](const siginfo_t* si) {
+        if (si->si_status != 0)
+        {
+            std::string msg = "Dump process failed: (signo)" +
+                              std::to_string(si->si_signo) + "; (code)" +
+                              std::to_string(si->si_code) + "; (errno)" +
+                              std::to_string(si->si_errno) + "; (pid)" +
+                              std::to_string(si->si_pid) + "; (status)" +
+                              std::to_string(si->si_status);
+            log<level::ERR>(msg.c_str());
+            this->createDumpFailed(entryId);
+        }
 
+        storage.settle(entryId);
+        // Remove dumpType from dumpInProgress when dump ends
+        Manager::dumpInProgress.erase(diagnosticType);
+        // Start the dumps waiting for the resources it held
+        scheduler.release(resources);
+    });
+}
+
+uint32_t Manager::captureDump(phosphor::dump::DumpCreateParams params)
+{
     // Get Dump size.
     auto size = getAllowedSize();
 
     // Validate request argument
-    const std::string typeSelftest = "SelfTest";
-    const std::string typeFPGA = "FPGA";
-    const std::string typeEROT = "EROT";
-    const std::string typeROT = "ROT";
-    const std::string typeMCU = "MCU";
-    const std::string typeNVSwitch = "Net_NVSwitch";
-    const std::string typeNet_NVLinkManagementNIC = "Net_NVLinkManagementNIC";
-    const std::string typeNet_GPU_SXM = "Net_GPU_SXM";
-    const std::string typeLTSSM = "RetLTSSM";
-    const std::string typeRetimerRegister = "RetRegister";
-    const std::string typeFwAtts = "FirmwareAttributes";
-    const std::string typeHwCheckout = "HardwareCheckout";
     auto diagnosticType = std::get<std::string>(params["DiagnosticType"]);
     auto deviceID = std::get<std::string>(params["DeviceID"]);
     params.erase("DiagnosticType");
     params.erase("DeviceID");
-    if (!diagnosticType.empty())
+    if (deviceID.empty())
     {
-        if (diagnosticType != typeSelftest && diagnosticType != typeFPGA &&
-            diagnosticType != typeEROT && diagnosticType != typeROT &&
-            diagnosticType != typeLTSSM && diagnosticType != typeMCU &&
-            diagnosticType != typeRetimerRegister &&
-            diagnosticType != typeFwAtts && diagnosticType != typeHwCheckout &&
-            diagnosticType != typeNet_NVLinkManagementNIC &&
-            diagnosticType != typeNVSwitch && diagnosticType != typeNet_GPU_SXM)
-        {
-            log<level::ERR>("Unrecognized DiagnosticType option",
-                            entry("DIAG_TYPE=%s", diagnosticType.c_str()));
-            using INV_ARG =
-                xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_NAME;
-            using INV_VAL =
-                xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_VALUE;
-            elog<InvalidArgument>(INV_ARG("DiagnosticType"),
-                                  INV_VAL(diagnosticType.c_str()));
-        }
-#ifdef FAULTLOG_DUMP_EXTENSION
-        if (diagnosticType == typeSelftest)
-        {
-            log<level::ERR>("Unsupported DiagnosticType option",
-                            entry("DIAG_TYPE=%s", diagnosticType.c_str()));
-            using INV_ARG =
-                xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_NAME;
-            using INV_VAL =
-                xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_VALUE;
-            elog<InvalidArgument>(INV_ARG("DiagnosticType"),
-                                  INV_VAL(diagnosticType.c_str()));
-        }
+        deviceID = "0";
+    }
+
+    // Continue a failed Net_* collection from where it stopped
+    bool resume = false;
+    if (auto it = params.find("Resume"); it != params.end())
+    {
+        auto value = std::get_if<std::string>(&it->second);
+        resume = value && (*value == "true" || *value == "1");
+        params.erase(it);
+    }
+
+    using INV_ARG = xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_NAME;
+    using INV_VAL =
+        xyz::openbmc_project::Common::InvalidArgument::ARGUMENT_VALUE;
+#ifndef NET_DUMP_RESUME
+    if (resume)
+    {
+        // The net dump script would fail on an unknown -r
+        log<level::ERR>("Resume is not supported by the net dump script");
+        elog<InvalidArgument>(INV_ARG("Resume"), INV_VAL("true"));
+    }
 #endif
+
+    auto diagnostic = findDiagnostic(diagnosticType);
+    if (diagnostic == nullptr)
+    {
+        log<level::ERR>("Unrecognized DiagnosticType option",
+                        entry("DIAG_TYPE=%s", diagnosticType.c_str()));
+        elog<InvalidArgument>(INV_ARG("DiagnosticType"),
+                              INV_VAL(diagnosticType.c_str()));
     }
+#ifdef FAULTLOG_DUMP_EXTENSION
+    if (diagnosticType == "SelfTest")
+    {
+        log<level::ERR>("Unsupported DiagnosticType option",
+                        entry("DIAG_TYPE=%s", diagnosticType.c_str()));
+        elog<InvalidArgument>(INV_ARG("DiagnosticType"),
+                              INV_VAL(diagnosticType.c_str()));
+    }
+#endif
 
     log<level::INFO>(
         fmt::format("Capturing system dump of type ({})", diagnosticType)
             .c_str());
 
-    if (diagnosticType == typeLTSSM)
-    {
-        retimerState.debugMode(true);
-    }
+    auto entryId = lastEntryId + 1;
+    fs::path dumpPath(dumpDir);
+    dumpPath /= std::to_string(entryId);
+    DiagnosticArgs args{std::to_string(entryId),
+                        dumpPath,
+                        deviceID,
+                        std::string(),
+                        size,
+                        resume,
+                        params};
 
     Manager::dumpInProgress.insert(diagnosticType);
-
-    pid_t pid = fork();
-
-    if (pid == 0)
+    try
     {
-        fs::path dumpPath(dumpDir);
-        auto id = std::to_string(lastEntryId + 1);
-        dumpPath /= id;
-
-        std::string dumpType = "system";
-
-        // Construct additional arguments from params
-        std::array<std::string, 3> addArgs;
-        // Fix additional arguments order 'bf_ip', 'bf_username', 'bf_password'
-        // std::map<std::string, std::string>::iterator itr;
-        for (auto itr = params.begin(); itr != params.end(); ++itr)
-        {
-            auto kvPair = itr->first + "=" + std::get<std::string>(itr->second);
-            if (itr->first == "bf_ip")
-            {
-                addArgs[0] = kvPair;
-            }
-            else if (itr->first == "bf_username")
+        auto started = scheduler.submit(
+            diagnostic->resources,
+            [this, diagnostic, args, entryId](bool queued) {
+            if (!queued)
             {
-                addArgs[1] = kvPair;
+                startDump(*diagnostic, args, entryId);
+                return;
             }
-            else if (itr->first == "bf_password")
+            try
             {
-                addArgs[2] = kvPair;
+                startDump(*diagnostic, args, entryId);
             }
-            else
-            {
-                log<level::ERR>("System dump: Unknown additional arguments");
-            }
-        }
-
-        if (diagnosticType.empty())
-        {
-            executeDreport(dumpType, id, dumpPath, size, addArgs);
-        }
-        else if (diagnosticType == typeSelftest)
-        {
-            selfTest(id, dumpPath);
-        }
-        else if (diagnosticType == typeFPGA)
-        {
-            fpgaRegDump(id, dumpPath);
-        }
-        else if (diagnosticType == typeMCU)
-        {
-            mcuRegDump(id, dumpPath);
-        }
-        else if (diagnosticType == typeEROT || diagnosticType == typeROT)
-        {
-            erotDump(id, dumpPath);
-        }
-        else if (diagnosticType == typeNVSwitch ||
-                 diagnosticType == typeNet_NVLinkManagementNIC ||
-                 diagnosticType == typeNet_GPU_SXM)
-        {
-            if (deviceID.empty())
+            catch (const std::exception& e)
             {
-                deviceID = "0";
+                // Nobody to return the error to, the entry reports it
+                log<level::ERR>(e.what());
+                createDumpFailed(entryId);
+                storage.settle(entryId);
+                Manager::dumpInProgress.erase(diagnostic->type);
+                scheduler.release(diagnostic->resources);
             }
-            diagnosticType = diagnosticType + "_" + deviceID;
-            std::string tempPath = NET_DUMP_TEMP_PATH;
-            netDump(id, dumpPath, tempPath, diagnosticType);
-        }
-        else if (diagnosticType == typeLTSSM)
-        {
-            retimerLtssmDump(id, dumpPath, retimerState.getVendorId());
-        }
-        else if (diagnosticType == typeRetimerRegister)
+        });
+        if (!started)
         {
-            std::string retimer_address =
-                std::get<std::string>(params["Address"]);
-            retimerRegisterDump(id, dumpPath, retimer_address,
-                                retimerState.getVendorId());
-        }
-        else if (diagnosticType == typeFwAtts)
-        {
-            fwAttrsDump(id, dumpPath);
-        }
-        else if (diagnosticType == typeHwCheckout)
-        {
-            hwCheckoutDump(id, dumpPath);
-        }
-        else
-        {
-            log<level::ERR>("System dump: Invalid DiagnosticType");
-            elog<InternalFailure>();
-        }
-    }
-    else if (pid > 0)
-    {
-        auto entryId = lastEntryId + 1;
-        Child::Callback callback =
-            [this, pid, entryId, diagnosticType](Child&, const siginfo_t* si) {
-            if (si->si_status != 0)
-            {
-                std::string msg = "Dump process failed: (signo)" +
-                                  std::to_string(si->si_signo) + "; (code)" +
-                                  std::to_string(si->si_code) + "; (errno)" +
-                                  std::to_string(si->si_errno) + "; (pid)" +
-                                  std::to_string(si->si_pid) + "; (status)" +
-                                  std::to_string(si->si_status);
-                log<level::ERR>(msg.c_str());
-                this->createDumpFailed(entryId);
-            }
-
-            this->childPtrMap.erase(pid);
-            // Remove dumpType from dumpInProgress when dump ends
-            Manager::dumpInProgress.erase(diagnosticType);
-        };
-
-        try
-        {
-            childPtrMap.emplace(pid,
-                                std::make_unique<Child>(eventLoop.get(), pid,
-                                                        WEXITED | WSTOPPED,
-                                                        std::move(callback)));
-        }
-        catch (const sdeventplus::SdEventError& ex)
-        {
-            // Failed to add to event loop
-            log<level::ERR>(
-                fmt::format(
-                    "Error occurred during the sdeventplus::source::Child "
-                    "creation ex({})",
-                    ex.what())
+            log<level::INFO>(
+                fmt::format("System dump of type ({}) queued behind dumps "
+                            "using the same resources",
+                            diagnosticType)
                     .c_str());
-            // Remove dumpType from dumpInProgress
-            Manager::dumpInProgress.erase(diagnosticType);
-            elog<InternalFailure>();
         }
     }
-    else
+    catch (...)
     {
-        auto error = errno;
-        log<level::ERR>("System dump: Error occurred during fork",
-                        entry("ERRNO=%d", error));
-        elog<InternalFailure>();
+        Manager::dumpInProgress.erase(diagnosticType);
+        throw;
     }
 
-    return ++lastEntryId;
+    storage.reserve(entryId, size);
+
+    lastEntryId = entryId;
+    return entryId;
 }
 
 void Manager::createEntry(const fs::path& file)
@@ -832,28 +646,18 @@ size_t Manager::getAllowedSize()
     using namespace sdbusplus::xyz::openbmc_project::Dump::Create::Error;
     using Reason = xyz::openbmc_project::Dump::Create::QuotaExceeded::REASON;
 
-    auto size = 0;
-
-    // Get current size of the dump directory.
-    for (const auto& p : fs::recursive_directory_iterator(dumpDir))
-    {
-        if (!fs::is_directory(p))
-        {
-            size += fs::file_size(p);
-        }
-    }
-
-    // Convert size into KB
-    size = size / 1024;
-
-    // Set the Dump size to Maximum  if the free space is greater than
-    // Dump max size otherwise return the available size.
-
-    size = (size > SYSTEM_DUMP_TOTAL_SIZE ? 0 : SYSTEM_DUMP_TOTAL_SIZE - size);
+    // Space left within SYSTEM_DUMP_TOTAL_SIZE and on the partition, less
+    // what the dumps in flight reserved
+    auto size = storage.available();
 
     if (size < SYSTEM_DUMP_MIN_SPACE_REQD)
     {
         // Reached to maximum limit
+        log<level::ERR>(
+            "Not enough space available to create system dump",
+            entry("REQ_KB=%d",
+                  static_cast<unsigned int>(SYSTEM_DUMP_MIN_SPACE_REQD)),
+            entry("LEFT_KB=%d", static_cast<unsigned int>(size)));
         elog<QuotaExceeded>(Reason("Not enough space: Delete old dumps"));
     }
     if (size > SYSTEM_DUMP_MAX_SIZE)
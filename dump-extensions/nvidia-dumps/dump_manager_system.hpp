@@ -16,17 +16,20 @@
  */
 #pragma once
 
+#include "collector_class.hpp"
+#include "diagnostic_scheduler.hpp"
 #include "dump_manager.hpp"
+#include "dump_spawner.hpp"
 #include "dump_utils.hpp"
 #include "nvidia_dumps_config.hpp"
 #include "retimer_debug_mode_state.hpp"
+#include "storage_budget.hpp"
 #include "system_dump_entry.hpp"
 #include "watch.hpp"
 #include "xyz/openbmc_project/Dump/NewDump/server.hpp"
 
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
-#include <sdeventplus/source/child.hpp>
 #include <xyz/openbmc_project/Dump/Create/server.hpp>
 
 namespace phosphor
@@ -44,7 +47,6 @@ using UserMap = phosphor::dump::inotify::UserMap;
 namespace fs = std::filesystem;
 
 using Watch = phosphor::dump::inotify::Watch;
-using ::sdeventplus::source::Child;
 
 /** @class Manager
  *  @brief OpenBMC Dump manager implementation.
@@ -81,7 +83,10 @@ class Manager :
             std::bind(
                 std::mem_fn(&phosphor::dump::system::Manager::watchCallback),
                 this, std::placeholders::_1)),
-        dumpDir(filePath), retimerState(bus, RETIMER_DEBUG_MODE_OBJPATH)
+        dumpDir(filePath), spawner(eventLoop),
+        retimerState(bus, RETIMER_DEBUG_MODE_OBJPATH, eventLoop.get()),
+        storage(StorageBudget::instance().addPool(
+            "system", filePath, SYSTEM_DUMP_TOTAL_SIZE, SYSTEM_DUMP_MAX_SIZE))
     {}
 
     /** @brief Implementation of dump watch call back
@@ -127,14 +132,22 @@ class Manager :
      */
     uint32_t captureDump(phosphor::dump::DumpCreateParams params);
 
+    /** @brief Fork the collection of a diagnostic
+     *  @param[in] diagnostic - registry entry of the diagnostic.
+     *  @param[in] args - arguments of the collection.
+     *  @param[in] entryId - dump entry id.
+     */
+    void startDump(const Diagnostic& diagnostic, DiagnosticArgs args,
+                   uint32_t entryId);
+
     /** @brief Remove specified watch object pointer from the
      *        watch map and associated entry from the map.
      *        @param[in] path - unique identifier of the map
      */
     void removeWatch(const fs::path& path);
 
-    /** @brief Calculate per dump allowed size based on the available
-     *        size in the dump location.
+    /** @brief Calculate per dump allowed size based on the space left in
+     *        the storage budget.
      *  @returns dump size in kilobytes.
      */
     size_t getAllowedSize();
@@ -153,15 +166,22 @@ class Manager :
      */
     std::map<fs::path, std::unique_ptr<Watch>> childWatchMap;
 
-    /** @brief map of SDEventPlus child pointer added to event loop */
-    std::map<pid_t, std::unique_ptr<Child>> childPtrMap;
+    /** @brief Launches the diagnostic collections */
+    Spawner spawner;
 
     /** @brief D-bus object for indicating retimer state*/
     phosphor::dump::retimer::State retimerState;
 
-    /** @brief a set containing string of dump types that are in progress */
+    /** @brief a set containing string of dump types that are in progress
+     *         or queued */
     std::set<std::string> dumpInProgress;
 
+    /** @brief runs the dumps not sharing resources in parallel */
+    DiagnosticScheduler scheduler;
+
+    /** @brief Space of the system dumps in the storage budget */
+    StoragePool& storage;
+
     /** @brief Erase BMC dump entry and delete respective dump file
      *         from permanent location on reaching maximum allowed
      *         entries.
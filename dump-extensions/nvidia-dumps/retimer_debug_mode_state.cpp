@@ -51,7 +51,49 @@ using namespace phosphor::logging;
 using DebugModeIface = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Dump::server::DebugMode>;
 
-bool State::debugMode() const
+namespace
+{
+
+/* Bus of the FPGA, shared with the FPGA telemetry */
+constexpr auto I2C_BUS = "/dev/i2c-2";
+constexpr unsigned char FPGA_ADDRESS = 0x60;
+constexpr unsigned char DEBUG_MODE_REGISTER = 0xe3;
+
+/* Saved reads between two reports of the cache counters */
+constexpr uint64_t CACHE_REPORT_PERIOD = 1000;
+
+} // namespace
+
+State::~State()
+{
+    closeBus();
+}
+
+int State::openBus() const
+{
+    if (i2cFd < 0)
+    {
+        i2cFd = open(I2C_BUS, O_RDONLY | O_CLOEXEC);
+        if (i2cFd < 0)
+        {
+            auto error = errno;
+            log<level::ERR>("System dump: Failed to open the I2C bus",
+                            entry("ERRNO=%d", error));
+        }
+    }
+    return i2cFd;
+}
+
+void State::closeBus() const
+{
+    if (i2cFd >= 0)
+    {
+        close(i2cFd);
+        i2cFd = -1;
+    }
+}
+
+bool State::readDebugMode(bool& value) const
 {
     /* FPGA aggregate command for reading retimer debug mode from HMC:
     i2ctransfer -y 2 w1@0x60 0xe3 r2
@@ -59,28 +101,23 @@ bool State::debugMode() const
     Each bit represent a single retimer, 0 means normal state, 1 means debug
     mode. The second byte implies who has the arbitary, 0x01 means HMC, 0x02
     means HostBMC, 0x00 means none. */
-    const char i2cBus[] = "/dev/i2c-2";
-    unsigned char outbuf = 0xe3, saddr = 0x60;
+    unsigned char outbuf = DEBUG_MODE_REGISTER;
     unsigned char inbuf[2];
     struct i2c_rdwr_ioctl_data packets;
     struct i2c_msg messages[2];
 
-    int file = open(i2cBus, O_RDONLY);
-
+    int file = openBus();
     if (file < 0)
     {
-        auto error = errno;
-        log<level::ERR>("System dump: Failed to open the I2C bus",
-                        entry("ERRNO=%d", error));
-        return DebugModeIface::debugMode();
+        return false;
     }
 
-    messages[0].addr = saddr;
+    messages[0].addr = FPGA_ADDRESS;
     messages[0].flags = 0x00;
     messages[0].len = 1;
     messages[0].buf = &outbuf;
 
-    messages[1].addr = saddr;
+    messages[1].addr = FPGA_ADDRESS;
     messages[1].flags = I2C_M_RD;
     messages[1].len = 2;
     messages[1].buf = inbuf;
@@ -88,57 +125,80 @@ bool State::debugMode() const
     packets.msgs = messages;
     packets.nmsgs = 2;
 
+    ++i2cReads;
     if (ioctl(file, I2C_RDWR, &packets) < 0)
     {
         auto error = errno;
         log<level::ERR>(
             "System dump: Failed to read retimerDebugMode from FPGA",
             entry("ERRNO=%d", error));
-        close(file);
-        return DebugModeIface::debugMode();
+        // The adapter may have gone away, reopen it next time
+        closeBus();
+        cachedDebugMode.reset();
+        return false;
     }
 
-    close(file);
-    if (inbuf[0] > 0)
+    value = inbuf[0] > 0;
+    cachedDebugMode = value;
+    cachedAt = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool State::debugMode() const
+{
+#if RETIMER_DEBUG_MODE_CACHE_TTL > 0
+    if (cachedDebugMode &&
+        std::chrono::steady_clock::now() - cachedAt <
+            std::chrono::milliseconds(RETIMER_DEBUG_MODE_CACHE_TTL))
     {
-        return true;
+        if (++i2cReadsSaved % CACHE_REPORT_PERIOD == 0)
+        {
+            lg2::info("Retimer DebugMode cache: {SAVED} I2C reads saved, "
+                      "{READS} done",
+                      "SAVED", i2cReadsSaved, "READS", i2cReads);
+        }
+        return *cachedDebugMode;
     }
+#endif
 
-    return false;
+    bool value = false;
+    if (!readDebugMode(value))
+    {
+        return DebugModeIface::debugMode();
+    }
+    return value;
 }
 
 bool State::debugMode(bool value)
 {
     /* FPGA aggregate command for setting retimer debug mode from HMC:
     i2ctransfer -y 2 w3@0x60 0xe3 0xff 0x01 */
-    const char i2cBus[] = "/dev/i2c-2";
-    unsigned char saddr = 0x60;
     unsigned char* outbuf;
     if (value)
     {
         ServiceReadyIface::state(States::Enabled);
-        static unsigned char command[3] = {0xe3, 0xff, 0x01};
+        static unsigned char command[3] = {DEBUG_MODE_REGISTER, 0xff, 0x01};
         outbuf = &command[0];
     }
     else
     {
         ServiceReadyIface::state(States::Disabled);
-        static unsigned char command[3] = {0xe3, 0x00, 0x00};
+        static unsigned char command[3] = {DEBUG_MODE_REGISTER, 0x00, 0x00};
         outbuf = &command[0];
     }
     struct i2c_rdwr_ioctl_data packets;
     struct i2c_msg messages[1];
 
-    int file = open(i2cBus, O_RDONLY);
+    // The FPGA arbitrates the request, the mode is read back after a write
+    cachedDebugMode.reset();
+
+    int file = openBus();
     if (file < 0)
     {
-        auto error = errno;
-        log<level::ERR>("System dump: Failed to open the I2C bus",
-                        entry("ERRNO=%d", error));
         return debugMode();
     }
 
-    messages[0].addr = saddr;
+    messages[0].addr = FPGA_ADDRESS;
     messages[0].flags = 0x00;
     messages[0].len = 3;
     messages[0].buf = outbuf;
@@ -151,14 +211,36 @@ bool State::debugMode(bool value)
         auto error = errno;
         log<level::ERR>("System dump: Failed to write retimerDebugMode to FPGA",
                         entry("ERRNO=%d", error));
-        close(file);
+        closeBus();
         return debugMode();
     }
-    close(file);
 
     return DebugModeIface::debugMode(value);
 }
 
+void State::startRefresh(sd_event* event)
+{
+#if RETIMER_DEBUG_MODE_REFRESH_INTERVAL > 0
+    try
+    {
+        refreshTimer.emplace(
+            sdeventplus::Event(event),
+            [this](Timer&) {
+            bool value = false;
+            readDebugMode(value);
+        },
+            std::chrono::milliseconds(RETIMER_DEBUG_MODE_REFRESH_INTERVAL));
+    }
+    catch (const std::exception& e)
+    {
+        lg2::error("Failed to start the retimer DebugMode refresh: {ERROR}",
+                   "ERROR", e);
+    }
+#else
+    (void)event;
+#endif
+}
+
 std::string State::getVendorId() const
 {
     return retimerVendorId;
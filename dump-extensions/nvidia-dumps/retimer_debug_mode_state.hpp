@@ -20,6 +20,13 @@
 #include "xyz/openbmc_project/State/ServiceReady/server.hpp"
 
 #include <sdbusplus/bus.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
 
 constexpr auto SWITCH_INTERFACE = "xyz.openbmc_project.Inventory.Item.Switch";
 constexpr auto RETIMER_SWITCHES_BASE_PATH =
@@ -43,22 +50,26 @@ using ServiceReadyIface = sdbusplus::server::object_t<
  * false. ServiceReady interface indicates the service state which will be read
  * by CSM. Switch interface maintains Vendor ID information for retimer, the
  * property will be set by nvidia-retimer-app.
+ * The debug mode read from the FPGA is cached for
+ * RETIMER_DEBUG_MODE_CACHE_TTL milliseconds, and optionally refreshed in the
+ * background, so D-Bus clients polling it do not load the shared I2C bus.
  */
 class State : virtual public DebugModeIface, virtual public ServiceReadyIface
 {
   public:
     State() = delete;
-    State(const State&) = default;
+    State(const State&) = delete;
     State& operator=(const State&) = delete;
     State(State&&) = delete;
     State& operator=(State&&) = delete;
-    virtual ~State() = default;
+    virtual ~State();
 
     /** @brief Constructor to put object onto bus at a dbus path.
      *  @param[in] bus - Bus to attach to.
      *  @param[in] path - Path to attach at.
+     *  @param[in] event - Event loop of the background refresh.
      */
-    State(sdbusplus::bus::bus& bus, const char* path) :
+    State(sdbusplus::bus::bus& bus, const char* path, sd_event* event) :
         DebugModeIface(bus, path), ServiceReadyIface(bus, path)
     {
         DebugModeIface::debugMode(false);
@@ -90,6 +101,7 @@ class State : virtual public DebugModeIface, virtual public ServiceReadyIface
             retimerVendorId = vendorId;
         }
         listenRetimerVendorIdEvents(bus);
+        startRefresh(event);
     }
 
     bool debugMode() const override;
@@ -101,6 +113,42 @@ class State : virtual public DebugModeIface, virtual public ServiceReadyIface
     std::string getVendorId() const;
 
   private:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    /** @brief Open the I2C bus, once for the life of the object
+     *  @return file descriptor, -1 on failure.
+     */
+    int openBus() const;
+
+    /** @brief Close the I2C bus, reopened on the next transaction */
+    void closeBus() const;
+
+    /** @brief Read the debug mode from the FPGA and cache it
+     *  @param[out] value - debug mode of the retimers.
+     *  @return false on failure.
+     */
+    bool readDebugMode(bool& value) const;
+
+    /** @brief Start the background refresh of the cached debug mode, if
+     *         configured.
+     *  @param[in] event - Event loop to run it on.
+     */
+    void startRefresh(sd_event* event);
+
+    /** @brief I2C bus file descriptor */
+    mutable int i2cFd = -1;
+
+    /** @brief Debug mode last read from or written to the FPGA */
+    mutable std::optional<bool> cachedDebugMode;
+    mutable std::chrono::steady_clock::time_point cachedAt;
+
+    /** @brief I2C transactions done and saved by the cache */
+    mutable uint64_t i2cReads = 0;
+    mutable uint64_t i2cReadsSaved = 0;
+
+    /** @brief Background refresh of the cached debug mode */
+    std::optional<Timer> refreshTimer;
+
     /** @brief a string for retimer vendor id*/
     std::string retimerVendorId;
 
@@ -18,6 +18,7 @@
 
 #include "dump_manager.hpp"
 #include "dump_offload.hpp"
+#include "dump_utils.hpp"
 
 #include <phosphor-logging/log.hpp>
 
@@ -42,6 +43,8 @@ void Entry::delete_()
         log<level::ERR>(e.what());
     }
 
+    removeDumpCopy(file);
+
     // Remove Dump entry D-bus object
     phosphor::dump::Entry::delete_();
 }
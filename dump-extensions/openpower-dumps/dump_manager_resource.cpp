@@ -34,31 +34,33 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
     // If there a completed one with same source id ignore it
     // if there is no invalid id, create new entry
     openpower::dump::resource::Entry* upEntry = NULL;
-    for (auto& entry : entries)
+    for (auto entryId : sourceIds.find(dumpId))
     {
         openpower::dump::resource::Entry* resEntry =
-            dynamic_cast<openpower::dump::resource::Entry*>(entry.second.get());
+            dynamic_cast<openpower::dump::resource::Entry*>(
+                entries.at(entryId).get());
 
         // If there is already a completed entry with input source id then
         // ignore this notification.
-        if ((resEntry->sourceDumpId() == dumpId) &&
-            (resEntry->status() == phosphor::dump::OperationStatus::Completed))
+        if (resEntry->status() == phosphor::dump::OperationStatus::Completed)
         {
             lg2::info("Resource dump entry with source dump id: {DUMP_ID} "
                       "is already present with entry id: {ENTRY_ID}",
                       "DUMP_ID", dumpId, "ENTRY_ID", resEntry->getDumpId());
             return;
         }
+    }
 
-        // Save the first entry with INVALID_SOURCE_ID
-        // but continue in the loop to make sure the
-        // new entry is not duplicate
-        if ((resEntry->status() ==
-             phosphor::dump::OperationStatus::InProgress) &&
-            (resEntry->sourceDumpId() == INVALID_SOURCE_ID) &&
-            (upEntry == NULL))
+    // Update the oldest entry with INVALID_SOURCE_ID in progress
+    for (auto entryId : sourceIds.placeholders())
+    {
+        openpower::dump::resource::Entry* resEntry =
+            dynamic_cast<openpower::dump::resource::Entry*>(
+                entries.at(entryId).get());
+        if (resEntry->status() == phosphor::dump::OperationStatus::InProgress)
         {
             upEntry = resEntry;
+            break;
         }
     }
     if (upEntry != NULL)
@@ -68,6 +70,7 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
                   "DUMP_ID", upEntry->getDumpId(), "SOURCE_ID", dumpId, "SIZE",
                   size);
         upEntry->update(timeStamp, size, dumpId);
+        sourceIds.add(upEntry->getDumpId(), dumpId);
         return;
     }
 
@@ -91,6 +94,7 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
                     std::string(), std::string(),
                     phosphor::dump::OperationStatus::Completed, std::string(),
                     originatorTypes::Internal, *this)));
+        sourceIds.add(id, dumpId);
     }
     catch (const std::invalid_argument& e)
     {
@@ -198,6 +202,7 @@ sdbusplus::message::object_path
                     bus, objPath.c_str(), id, timeStamp, 0, INVALID_SOURCE_ID,
                     vspString, pwd, phosphor::dump::OperationStatus::InProgress,
                     originatorId, originatorType, *this)));
+        sourceIds.add(id, INVALID_SOURCE_ID);
     }
     catch (const std::invalid_argument& e)
     {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "dump_manager.hpp"
+#include "source_id_index.hpp"
 #include "xyz/openbmc_project/Dump/NewDump/server.hpp"
 
 #include <com/ibm/Dump/Create/server.hpp>
@@ -69,6 +70,18 @@ class Manager :
      */
     sdbusplus::message::object_path
         createDump(phosphor::dump::DumpCreateParams params) override;
+
+  protected:
+    /** @brief Remove a dump entry and its source id */
+    void erase(uint32_t entryId) override
+    {
+        sourceIds.remove(entryId);
+        phosphor::dump::Manager::erase(entryId);
+    }
+
+  private:
+    /** @brief Entries by source dump id */
+    SourceIdIndex sourceIds;
 };
 
 } // namespace resource
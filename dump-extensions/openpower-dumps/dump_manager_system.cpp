@@ -12,6 +12,8 @@
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/lg2.hpp>
 
+#include <vector>
+
 namespace openpower
 {
 namespace dump
@@ -36,53 +38,56 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
     // source id. Since only one system dump creation is allowed at a time, if
     // there's an entry with an invalid sourceId, we will update that entry.
     openpower::dump::system::Entry* upEntry = nullptr;
-    for (auto& entry : entries)
+    std::vector<openpower::dump::system::Entry*> stale;
+    for (auto entryId : sourceIds.find(dumpId))
     {
         openpower::dump::system::Entry* sysEntry =
-            dynamic_cast<openpower::dump::system::Entry*>(entry.second.get());
+            dynamic_cast<openpower::dump::system::Entry*>(
+                entries.at(entryId).get());
 
-        // If there's already a completed entry with the input source id and
-        // size, ignore this notification
-        if ((sysEntry->sourceDumpId() == dumpId) && (sysEntry->size() == size))
+        // If the dump id is the same but the size is different, then this is
+        // a new dump. So, the stale entry is deleted after the lookup, which
+        // walks the index the deletion changes.
+        if (sysEntry->size() != size)
         {
-            if (sysEntry->status() ==
-                phosphor::dump::OperationStatus::Completed)
-            {
-                lg2::info(
-                    "System dump entry with source dump id:{SOURCE_ID} and "
-                    "size: {SIZE} is already present with entry id:{ID}",
-                    "SOURCE_ID", dumpId, "SIZE", size, "ID",
-                    sysEntry->getDumpId());
-                return;
-            }
-            else
-            {
-                lg2::error("A duplicate notification for an incomplete dump "
-                           "dump id: {SOURCE_ID} entry id: {ID}",
-                           "SOURCE_D", dumpId, "ID", sysEntry->getDumpId());
-                upEntry = sysEntry;
-                break;
-            }
+            stale.push_back(sysEntry);
         }
-        else if (sysEntry->sourceDumpId() == dumpId)
+        else if (upEntry == nullptr)
         {
-            // If the dump id is the same but the size is different, then this
-            // is a new dump. So, delete the stale entry and prepare to create a
-            // new one.
-            lg2::info("A previous dump entry found with same source id: "
-                      "{SOURCE_ID}, deleting it, entry id: {DUMP_ID}",
-                      "SOURCE_ID", dumpId, "DUMP_ID", sysEntry->getDumpId());
-            sysEntry->delete_();
-            // No 'break' here, as we need to continue checking other entries.
+            upEntry = sysEntry;
         }
+    }
+
+    for (auto sysEntry : stale)
+    {
+        lg2::info("A previous dump entry found with same source id: "
+                  "{SOURCE_ID}, deleting it, entry id: {DUMP_ID}",
+                  "SOURCE_ID", dumpId, "DUMP_ID", sysEntry->getDumpId());
+        sysEntry->delete_();
+    }
 
-        // Save the first entry with INVALID_SOURCE_ID, but continue in the loop
-        // to ensure the new entry is not a duplicate.
-        if ((sysEntry->sourceDumpId() == INVALID_SOURCE_ID) &&
-            (upEntry == nullptr))
+    // If there's already a completed entry with the input source id and
+    // size, ignore this notification
+    if (upEntry != nullptr)
+    {
+        if (upEntry->status() == phosphor::dump::OperationStatus::Completed)
         {
-            upEntry = sysEntry;
+            lg2::info("System dump entry with source dump id:{SOURCE_ID} and "
+                      "size: {SIZE} is already present with entry id:{ID}",
+                      "SOURCE_ID", dumpId, "SIZE", size, "ID",
+                      upEntry->getDumpId());
+            return;
         }
+        lg2::error("A duplicate notification for an incomplete dump "
+                   "dump id: {SOURCE_ID} entry id: {ID}",
+                   "SOURCE_ID", dumpId, "ID", upEntry->getDumpId());
+    }
+
+    // Otherwise update the oldest entry waiting for its source id
+    if ((upEntry == nullptr) && !sourceIds.placeholders().empty())
+    {
+        upEntry = dynamic_cast<openpower::dump::system::Entry*>(
+            entries.at(*sourceIds.placeholders().begin()).get());
     }
 
     if (upEntry != nullptr)
@@ -92,6 +97,7 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
             "Size:{SIZE}",
             "ID", upEntry->getDumpId(), "SOURCE_ID", dumpId, "SIZE", size);
         upEntry->update(timeStamp, size, dumpId);
+        sourceIds.add(upEntry->getDumpId(), dumpId);
         return;
     }
 
@@ -112,6 +118,7 @@ void Manager::notify(uint32_t dumpId, uint64_t size)
                     bus, objPath.c_str(), id, timeStamp, size, dumpId,
                     phosphor::dump::OperationStatus::Completed, std::string(),
                     originatorTypes::Internal, *this)));
+        sourceIds.add(id, dumpId);
     }
     catch (const std::invalid_argument& e)
     {
@@ -213,6 +220,7 @@ sdbusplus::message::object_path
                     bus, objPath.c_str(), id, timeStamp, 0, INVALID_SOURCE_ID,
                     phosphor::dump::OperationStatus::InProgress, originatorId,
                     originatorType, *this)));
+        sourceIds.add(id, INVALID_SOURCE_ID);
     }
     catch (const std::invalid_argument& e)
     {
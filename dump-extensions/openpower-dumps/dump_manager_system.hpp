@@ -2,6 +2,7 @@
 
 #include "dump_manager.hpp"
 #include "dump_utils.hpp"
+#include "source_id_index.hpp"
 #include "xyz/openbmc_project/Dump/NewDump/server.hpp"
 
 #include <sdbusplus/bus.hpp>
@@ -69,6 +70,18 @@ class Manager :
      */
     sdbusplus::message::object_path
         createDump(phosphor::dump::DumpCreateParams params) override;
+
+  protected:
+    /** @brief Remove a dump entry and its source id */
+    void erase(uint32_t entryId) override
+    {
+        sourceIds.remove(entryId);
+        phosphor::dump::Manager::erase(entryId);
+    }
+
+  private:
+    /** @brief Entries by source dump id */
+    SourceIdIndex sourceIds;
 };
 
 } // namespace system
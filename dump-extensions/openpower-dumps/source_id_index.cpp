@@ -0,0 +1,57 @@
+#include "source_id_index.hpp"
+
+#include "op_dump_consts.hpp"
+
+namespace openpower
+{
+namespace dump
+{
+
+void SourceIdIndex::add(uint32_t entryId, uint32_t sourceId)
+{
+    remove(entryId);
+
+    sourceOf.emplace(entryId, sourceId);
+    if (sourceId == INVALID_SOURCE_ID)
+    {
+        waiting.insert(entryId);
+    }
+    else
+    {
+        bySource[sourceId].insert(entryId);
+    }
+}
+
+void SourceIdIndex::remove(uint32_t entryId)
+{
+    auto it = sourceOf.find(entryId);
+    if (it == sourceOf.end())
+    {
+        return;
+    }
+
+    if (it->second == INVALID_SOURCE_ID)
+    {
+        waiting.erase(entryId);
+    }
+    else if (auto ids = bySource.find(it->second); ids != bySource.end())
+    {
+        ids->second.erase(entryId);
+        if (ids->second.empty())
+        {
+            bySource.erase(ids);
+        }
+    }
+    sourceOf.erase(it);
+}
+
+const std::set<uint32_t>& SourceIdIndex::find(uint32_t sourceId) const
+{
+    static const std::set<uint32_t> none;
+
+    auto ids = bySource.find(sourceId);
+    return ids == bySource.end() ? none : ids->second;
+}
+
+} // namespace dump
+} // namespace openpower
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+
+namespace openpower
+{
+namespace dump
+{
+
+/** @class SourceIdIndex
+ *
+ *  @brief Entries of a host dump manager by the id the host gave to their
+ *  dump, and the entries still waiting for the host to report theirs, so
+ *  that a notification finds its entry without walking all of them.
+ */
+class SourceIdIndex
+{
+  public:
+    /** @brief Index an entry
+     *  @param[in] entryId - Entry id.
+     *  @param[in] sourceId - Id of the dump on the host, INVALID_SOURCE_ID
+     *                        while the host did not report it.
+     */
+    void add(uint32_t entryId, uint32_t sourceId);
+
+    /** @brief Drop an entry, if indexed
+     *  @param[in] entryId - Entry id.
+     */
+    void remove(uint32_t entryId);
+
+    /** @brief Entries with a source id
+     *  @param[in] sourceId - Id of the dump on the host.
+     *
+     *  @returns the entry ids, empty if none
+     */
+    const std::set<uint32_t>& find(uint32_t sourceId) const;
+
+    /** @brief Entries waiting for their source id, oldest first */
+    const std::set<uint32_t>& placeholders() const
+    {
+        return waiting;
+    }
+
+  private:
+    /** @brief Entry ids by source id, placeholders excepted */
+    std::unordered_map<uint32_t, std::set<uint32_t>> bySource;
+
+    /** @brief Source id of each entry */
+    std::unordered_map<uint32_t, uint32_t> sourceOf;
+
+    /** @brief Entries with INVALID_SOURCE_ID */
+    std::set<uint32_t> waiting;
+};
+
+} // namespace dump
+} // namespace openpower
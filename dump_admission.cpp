@@ -0,0 +1,257 @@
+#include "config.h"
+
+#include "dump_admission.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sdbusplus/vtable.hpp>
+#include <sdeventplus/event.hpp>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+
+namespace
+{
+
+constexpr auto ADMISSION_INTERFACE = "com.nvidia.Dump.Admission";
+
+/** @brief "some avg10" of a /proc/pressure file, 0 if not available */
+double readStall(const char* path)
+{
+    std::ifstream file(path);
+    std::string kind;
+    std::string avg10;
+    if (!(file >> kind >> avg10) || kind != "some" ||
+        avg10.rfind("avg10=", 0) != 0)
+    {
+        return 0;
+    }
+    return std::strtod(avg10.c_str() + 6, nullptr);
+}
+
+} // namespace
+
+std::string admissionDecisionToString(AdmissionDecision decision)
+{
+    switch (decision)
+    {
+        case AdmissionDecision::Throttled:
+            return "com.nvidia.Dump.Admission.Decision.Throttled";
+        case AdmissionDecision::Deferred:
+            return "com.nvidia.Dump.Admission.Decision.Deferred";
+        case AdmissionDecision::Admitted:
+        default:
+            return "com.nvidia.Dump.Admission.Decision.Admitted";
+    }
+}
+
+Pressure readPressure()
+{
+    Pressure pressure;
+    pressure.cpu = readStall("/proc/pressure/cpu");
+    pressure.io = readStall("/proc/pressure/io");
+    pressure.memory = readStall("/proc/pressure/memory");
+    return pressure;
+}
+
+AdmissionControl::AdmissionControl(sd_event* event) :
+    recheckTimer(sdeventplus::Event(event),
+                 [this](Timer&) { dispatch(underPressure()); })
+{}
+
+bool AdmissionControl::underPressure()
+{
+    auto pressure = readPressure();
+    return (PSI_CPU_THRESHOLD > 0 && pressure.cpu >= PSI_CPU_THRESHOLD) ||
+           (PSI_IO_THRESHOLD > 0 && pressure.io >= PSI_IO_THRESHOLD) ||
+           (PSI_MEMORY_THRESHOLD > 0 &&
+            pressure.memory >= PSI_MEMORY_THRESHOLD);
+}
+
+AdmissionDecision AdmissionControl::submit(uint32_t entryId,
+                                           DumpPriority priority,
+                                           Launch&& launch)
+{
+    if (!underPressure())
+    {
+        // The pressure subsided since the last recheck, the waiting dumps
+        // go first
+        dispatch(false);
+        start(launch, AdmissionDecision::Admitted);
+        return AdmissionDecision::Admitted;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (priority == DumpPriority::High)
+    {
+        if (high.empty() && running < DUMP_ADMISSION_PARALLELISM)
+        {
+            start(launch, AdmissionDecision::Throttled);
+        }
+        else
+        {
+            high.push_back({entryId, std::move(launch), now});
+            armRecheck();
+        }
+        return AdmissionDecision::Throttled;
+    }
+
+    low.push_back({entryId, std::move(launch), now});
+    armRecheck();
+    return AdmissionDecision::Deferred;
+}
+
+std::optional<DumpPriority> AdmissionControl::cancel(uint32_t entryId)
+{
+    auto drop = [entryId](std::deque<Pending>& queue) {
+        auto it = std::find_if(queue.begin(), queue.end(),
+                               [entryId](const Pending& pending) {
+            return pending.entryId == entryId;
+        });
+        if (it == queue.end())
+        {
+            return false;
+        }
+        queue.erase(it);
+        return true;
+    };
+
+    std::optional<DumpPriority> priority;
+    if (drop(high))
+    {
+        priority = DumpPriority::High;
+    }
+    else if (drop(low))
+    {
+        priority = DumpPriority::Low;
+    }
+    if (high.empty() && low.empty())
+    {
+        recheckTimer.setEnabled(false);
+    }
+    return priority;
+}
+
+void AdmissionControl::done()
+{
+    if (running > 0)
+    {
+        --running;
+    }
+    if (!high.empty() || !low.empty())
+    {
+        dispatch(underPressure());
+    }
+}
+
+void AdmissionControl::start(Launch& launch, AdmissionDecision decision)
+{
+    ++running;
+    try
+    {
+        launch(decision, false);
+    }
+    catch (...)
+    {
+        --running;
+        throw;
+    }
+}
+
+void AdmissionControl::armRecheck()
+{
+    if (!recheckTimer.isEnabled())
+    {
+        recheckTimer.restartOnce(
+            std::chrono::seconds(DUMP_ADMISSION_RECHECK_INTERVAL));
+    }
+}
+
+void AdmissionControl::dispatch(bool pressure)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto decision = pressure ? AdmissionDecision::Throttled
+                             : AdmissionDecision::Admitted;
+
+    // Take out the dumps that can start before starting them, a launch
+    // failing calls done() from within
+    std::vector<Launch> ready;
+    size_t slots = 0;
+    if (pressure && running < DUMP_ADMISSION_PARALLELISM)
+    {
+        slots = DUMP_ADMISSION_PARALLELISM - running;
+    }
+    while (!high.empty() && (!pressure || ready.size() < slots))
+    {
+        ready.push_back(std::move(high.front().launch));
+        high.pop_front();
+    }
+    while (!low.empty() && (!pressure || ready.size() < slots))
+    {
+        // Past the maximum deferral a dump is taken under pressure anyway
+        auto overdue = DUMP_ADMISSION_MAX_DEFERRAL > 0 &&
+                       now - low.front().submitted >=
+                           std::chrono::seconds(DUMP_ADMISSION_MAX_DEFERRAL);
+        if (pressure && !overdue)
+        {
+            break;
+        }
+        ready.push_back(std::move(low.front().launch));
+        low.pop_front();
+    }
+
+    if (high.empty() && low.empty())
+    {
+        recheckTimer.setEnabled(false);
+    }
+    else
+    {
+        armRecheck();
+    }
+
+    running += ready.size();
+    for (auto& launch : ready)
+    {
+        launch(decision, true);
+    }
+}
+
+const sdbusplus::vtable::vtable_t AdmissionStatus::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("Decision", "s", AdmissionStatus::getDecision,
+                                sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::end()};
+
+AdmissionStatus::AdmissionStatus(sdbusplus::bus_t& bus,
+                                 const std::string& path,
+                                 AdmissionDecision decision) :
+    value(decision),
+    interface(bus, path.c_str(), ADMISSION_INTERFACE, vtable, this)
+{
+    interface.emit_added();
+}
+
+void AdmissionStatus::decision(AdmissionDecision decision)
+{
+    if (value != decision)
+    {
+        value = decision;
+        interface.property_changed("Decision");
+    }
+}
+
+int AdmissionStatus::getDecision(sd_bus*, const char*, const char*,
+                                 const char*, sd_bus_message* reply,
+                                 void* context, sd_bus_error*)
+{
+    auto status = static_cast<AdmissionStatus*>(context);
+    return sd_bus_message_append(
+        reply, "s", admissionDecisionToString(status->value).c_str());
+}
+
+} // namespace dump
+} // namespace phosphor
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <systemd/sd-event.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/utility/timer.hpp>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace phosphor
+{
+namespace dump
+{
+
+/** @brief How much a dump matters when the BMC is under pressure */
+enum class DumpPriority
+{
+    /** Requested by a user, can wait */
+    Low,
+    /** Captures an error as it happens, can not wait */
+    High,
+};
+
+/** @brief Admission of a dump */
+enum class AdmissionDecision
+{
+    /** Started, the BMC was not under pressure */
+    Admitted,
+    /** Started or waiting for one of the few slots left under pressure */
+    Throttled,
+    /** Waiting for the pressure to subside */
+    Deferred,
+};
+
+/** @brief D-Bus enumeration string of an admission decision */
+std::string admissionDecisionToString(AdmissionDecision decision);
+
+/** @struct Pressure
+ *
+ *  Share of time some tasks stalled on a resource over the last 10 seconds,
+ *  in percent, from /proc/pressure.
+ */
+struct Pressure
+{
+    double cpu = 0;
+    double io = 0;
+    double memory = 0;
+};
+
+/** @brief Read the pressure stall information, 0 for the resources the
+ *         kernel does not report.
+ */
+Pressure readPressure();
+
+/** @class AdmissionControl
+ *
+ *  @brief Holds back the dumps while the BMC is under CPU, I/O or memory
+ *  pressure.
+ *
+ *  Under pressure low priority dumps are deferred until it subsides, or
+ *  until they waited DUMP_ADMISSION_MAX_DEFERRAL, and high priority dumps
+ *  run DUMP_ADMISSION_PARALLELISM at a time. Waiting dumps are started in
+ *  order, the high priority ones first.
+ */
+class AdmissionControl
+{
+  public:
+    /** @brief Starts a dump
+     *  @details Told under which decision the dump starts and whether it
+     *           waited. A dump that did not wait passes its exceptions to
+     *           the submitter, one that waited must handle them and call
+     *           done().
+     */
+    using Launch = std::function<void(AdmissionDecision, bool queued)>;
+
+    AdmissionControl() = delete;
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+    AdmissionControl(AdmissionControl&&) = delete;
+    AdmissionControl& operator=(AdmissionControl&&) = delete;
+    ~AdmissionControl() = default;
+
+    /** @brief Constructor
+     *  @param[in] event - Event loop to recheck the pressure from.
+     */
+    explicit AdmissionControl(sd_event* event);
+
+    /** @brief Start a dump now or once the pressure allows it
+     *  @param[in] entryId - Id of the dump entry.
+     *  @param[in] priority - Priority of the dump.
+     *  @param[in] launch - Starts the dump.
+     *
+     *  @returns the decision taken for the dump
+     */
+    AdmissionDecision submit(uint32_t entryId, DumpPriority priority,
+                             Launch&& launch);
+
+    /** @brief Drop a dump still waiting, its entry went away
+     *  @param[in] entryId - Id of the dump entry.
+     *
+     *  @returns the priority of the dump dropped, none if it was not
+     *           waiting
+     */
+    std::optional<DumpPriority> cancel(uint32_t entryId);
+
+    /** @brief A dump started by launch ended */
+    void done();
+
+  private:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    struct Pending
+    {
+        uint32_t entryId;
+        Launch launch;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    /** @brief Whether a resource is above its threshold */
+    static bool underPressure();
+
+    /** @brief Start the waiting dumps the pressure allows
+     *  @param[in] pressure - Whether the BMC is under pressure.
+     */
+    void dispatch(bool pressure);
+
+    /** @brief Start a submitted dump and count it */
+    void start(Launch& launch, AdmissionDecision decision);
+
+    /** @brief Recheck the pressure later, if not planned yet */
+    void armRecheck();
+
+    /** @brief Waiting high and low priority dumps */
+    std::deque<Pending> high;
+    std::deque<Pending> low;
+
+    /** @brief Dumps started and not done */
+    size_t running = 0;
+
+    /** @brief Rechecks the pressure while dumps wait */
+    Timer recheckTimer;
+};
+
+/** @class AdmissionStatus
+ *
+ *  @brief com.nvidia.Dump.Admission interface of a dump entry, telling
+ *  whether the dump was held back and why.
+ */
+class AdmissionStatus
+{
+  public:
+    AdmissionStatus() = delete;
+    AdmissionStatus(const AdmissionStatus&) = delete;
+    AdmissionStatus& operator=(const AdmissionStatus&) = delete;
+    AdmissionStatus(AdmissionStatus&&) = delete;
+    AdmissionStatus& operator=(AdmissionStatus&&) = delete;
+    ~AdmissionStatus() = default;
+
+    /** @brief Constructor to put the interface at the entry path
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] path - Entry object path.
+     *  @param[in] decision - Admission of the dump.
+     */
+    AdmissionStatus(sdbusplus::bus_t& bus, const std::string& path,
+                    AdmissionDecision decision);
+
+    /** @brief Update the admission, emitting PropertiesChanged */
+    void decision(AdmissionDecision decision);
+
+  private:
+    /** @brief Decision property getter */
+    static int getDecision(sd_bus* bus, const char* path, const char* intf,
+                           const char* property, sd_bus_message* reply,
+                           void* context, sd_bus_error* error);
+
+    static const sdbusplus::vtable::vtable_t vtable[];
+
+    AdmissionDecision value;
+
+    sdbusplus::server::interface_t interface;
+};
+
+} // namespace dump
+} // namespace phosphor
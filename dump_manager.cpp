@@ -1,12 +1,36 @@
 #include "dump_manager.hpp"
 
+#include <filesystem>
+
 namespace phosphor
 {
 namespace dump
 {
 
+void Manager::setAdmission(uint32_t entryId, AdmissionDecision decision)
+{
+    // The interface goes on the entry object, not on a path left empty
+    auto entry = entries.find(entryId);
+    if (entry == entries.end() || !entry->second)
+    {
+        return;
+    }
+
+    auto it = admissions.find(entryId);
+    if (it != admissions.end())
+    {
+        it->second->decision(decision);
+        return;
+    }
+    auto objPath = std::filesystem::path(baseEntryPath) /
+                   std::to_string(entryId);
+    admissions.emplace(entryId, std::make_unique<AdmissionStatus>(
+                                    bus, objPath, decision));
+}
+
 void Manager::erase(uint32_t entryId)
 {
+    admissions.erase(entryId);
     entries.erase(entryId);
 }
 
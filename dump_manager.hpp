@@ -1,5 +1,6 @@
 #pragma once
 
+#include "dump_admission.hpp"
 #include "dump_entry.hpp"
 #include "xyz/openbmc_project/Collection/DeleteAll/server.hpp"
 
@@ -53,11 +54,19 @@ class Manager : public Iface
     virtual void restore() = 0;
 
   protected:
+    /** @brief Report the admission of the dump of an entry, once the entry
+     *         object exists
+     *
+     * @param[in] entryId - unique identifier of the entry
+     * @param[in] decision - admission of the dump
+     */
+    void setAdmission(uint32_t entryId, AdmissionDecision decision);
+
     /** @brief Erase specified entry d-bus object
      *
      * @param[in] entryId - unique identifier of the entry
      */
-    void erase(uint32_t entryId);
+    virtual void erase(uint32_t entryId);
 
     /** @brief  Erase all BMC dump entries and  Delete all Dump files
      * from Permanent location
@@ -71,6 +80,9 @@ class Manager : public Iface
     /** @brief Dump Entry dbus objects map based on entry id */
     std::map<uint32_t, std::unique_ptr<Entry>> entries;
 
+    /** @brief Admission interfaces of the entries, by entry id */
+    std::map<uint32_t, std::unique_ptr<AdmissionStatus>> admissions;
+
     /** @brief Id of the last Dump entry */
     uint32_t lastEntryId;
 
@@ -11,12 +11,9 @@
 #include <sys/inotify.h>
 #include <unistd.h>
 
-#include <cmath>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/lg2.hpp>
-#include <sdeventplus/exception.hpp>
-#include <sdeventplus/source/base.hpp>
 
 namespace phosphor
 {
@@ -72,7 +69,8 @@ sdbusplus::message::object_path
     lg2::info("Initiating new BMC dump with type: {TYPE} path: {PATH}", "TYPE",
               dumpTypeToString(dumpType).value(), "PATH", path);
 
-    auto id = captureDump(dumpType, path);
+    AdmissionDecision decision = AdmissionDecision::Admitted;
+    auto id = captureDump(dumpType, path, decision);
 
     // Entry Object path.
     auto objPath = std::filesystem::path(baseEntryPath) / std::to_string(id);
@@ -97,6 +95,7 @@ sdbusplus::message::object_path
                    "ERROR", e, "OBJECT_PATH", objPath, "ID", id);
         elog<InternalFailure>();
     }
+    setAdmission(id, decision);
 
     if (dumpType == DumpTypes::USER)
     {
@@ -105,7 +104,8 @@ sdbusplus::message::object_path
     return objPath.string();
 }
 
-uint32_t Manager::captureDump(DumpTypes type, const std::string& path)
+uint32_t Manager::captureDump(DumpTypes type, const std::string& path,
+                              AdmissionDecision& decision)
 {
     // Get Dump size.
     auto size = getAllowedSize();
@@ -114,77 +114,131 @@ uint32_t Manager::captureDump(DumpTypes type, const std::string& path)
                                  dumpTypeToString(type).value())
                          .c_str());
 
-    pid_t pid = fork();
-
-    if (pid == 0)
-    {
-        std::filesystem::path dumpPath(dumpDir);
-        auto id = std::to_string(lastEntryId + 1);
-        dumpPath /= id;
-
-        auto strType = dumpTypeToString(type).value();
-        execl("/usr/bin/dreport", "dreport", "-d", dumpPath.c_str(), "-i",
-              id.c_str(), "-s", std::to_string(size).c_str(), "-q", "-v", "-p",
-              path.empty() ? "" : path.c_str(), "-t", strType.c_str(), "-c",
-              CompressionType, nullptr);
-
-        // dreport script execution is failed.
-        auto error = errno;
-        lg2::error("Error occurred during dreport function execution, "
-                   "errno: {ERRNO}",
-                   "ERRNO", error);
-        elog<InternalFailure>();
-    }
-    else if (pid > 0)
-    {
-        auto entryId = lastEntryId + 1;
-        Child::Callback callback = [this, type, pid,
-                                    entryId](Child&, const siginfo_t* si) {
-            if (si->si_status != 0)
-            {
-                std::string msg = "Dump process failed: (signo)" +
-                                  std::to_string(si->si_signo) + "; (code)" +
-                                  std::to_string(si->si_code) + "; (errno)" +
-                                  std::to_string(si->si_errno) + "; (pid)" +
-                                  std::to_string(si->si_pid) + "; (status)" +
-                                  std::to_string(si->si_status);
-                lg2::error(msg.c_str());
-                this->createDumpFailed(entryId);
-            }
+    std::filesystem::path dumpPath(dumpDir);
+    auto id = std::to_string(lastEntryId + 1);
+    dumpPath /= id;
+
+    auto strType = dumpTypeToString(type).value();
+    std::vector<std::string> argv{"/usr/bin/dreport",
+                                  "-d",
+                                  dumpPath,
+                                  "-i",
+                                  id,
+                                  "-s",
+                                  std::to_string(size),
+                                  "-q",
+                                  "-v",
+                                  "-p",
+                                  path,
+                                  "-t",
+                                  strType,
+                                  "-c",
+                                  CompressionType};
+
+    // User dumps wait for the BMC pressure to subside, the others capture
+    // an error and only run fewer at a time
+    auto entryId = lastEntryId + 1;
+    auto priority = (type == DumpTypes::USER) ? DumpPriority::Low
+                                              : DumpPriority::High;
+    decision = admission.submit(
+        entryId, priority,
+        [this, argv = std::move(argv), type,
+         entryId](AdmissionDecision decision, bool queued) {
+        if (!queued)
+        {
+            startDump(argv, type, entryId);
+            return;
+        }
+        auto entry = entries.find(entryId);
+        if (entry == entries.end() || !entry->second)
+        {
+            // erase() cancels the waiting dumps, nothing to collect for an
+            // entry which went away anyway
+            lg2::info("Dropping a held back BMC dump without entry, ID: {ID}",
+                      "ID", entryId);
             if (type == DumpTypes::USER)
             {
-                lg2::info("User initiated dump completed, resetting flag");
                 Manager::fUserDumpInProgress = false;
             }
-            this->childPtrMap.erase(pid);
-        };
+            storage.settle(entryId);
+            admission.done();
+            return;
+        }
+        setAdmission(entryId, decision);
         try
         {
-            childPtrMap.emplace(pid,
-                                std::make_unique<Child>(eventLoop.get(), pid,
-                                                        WEXITED | WSTOPPED,
-                                                        std::move(callback)));
+            startDump(argv, type, entryId);
         }
-        catch (const sdeventplus::SdEventError& ex)
+        catch (const std::exception& e)
         {
-            // Failed to add to event loop
-            lg2::error(
-                "Error occurred during the sdeventplus::source::Child creation "
-                "ex: {ERROR}",
-                "ERROR", ex);
-            elog<InternalFailure>();
+            // Nobody to return the error to, the entry reports it
+            lg2::error("Failed to start a held back BMC dump, ID: {ID}, "
+                       "ERROR: {ERROR}",
+                       "ID", entryId, "ERROR", e);
+            createDumpFailed(entryId);
+            if (type == DumpTypes::USER)
+            {
+                Manager::fUserDumpInProgress = false;
+            }
+            storage.settle(entryId);
+            admission.done();
         }
-    }
-    else
+    });
+    if (decision != AdmissionDecision::Admitted)
     {
-        auto error = errno;
-        lg2::error("Error occurred during fork, errno: {ERRNO}", "ERRNO",
-                   error);
-        elog<InternalFailure>();
+        lg2::info("BMC dump held back by the BMC pressure, ID: {ID}, "
+                  "DECISION: {DECISION}",
+                  "ID", entryId, "DECISION",
+                  admissionDecisionToString(decision));
     }
+    storage.reserve(entryId, size);
+
     return ++lastEntryId;
 }
 
+void Manager::erase(uint32_t entryId)
+{
+    // A dump still waiting for the pressure to subside must not bring the
+    // entry back once started
+    if (auto priority = admission.cancel(entryId))
+    {
+        lg2::info("Cancelled a held back BMC dump, ID: {ID}", "ID", entryId);
+        // User dumps are the low priority ones
+        if (*priority == DumpPriority::Low)
+        {
+            Manager::fUserDumpInProgress = false;
+        }
+        storage.settle(entryId);
+    }
+    phosphor::dump::Manager::erase(entryId);
+}
+
+void Manager::startDump(const std::vector<std::string>& argv, DumpTypes type,
+                        uint32_t entryId)
+{
+    spawner.spawn(argv, collectorOptions(CollectorClass::Bulk),
+                  [this, type, entryId](const siginfo_t* si) {
+        if (si->si_status != 0)
+        {
+            std::string msg = "Dump process failed: (signo)" +
+                              std::to_string(si->si_signo) + "; (code)" +
+                              std::to_string(si->si_code) + "; (errno)" +
+                              std::to_string(si->si_errno) + "; (pid)" +
+                              std::to_string(si->si_pid) + "; (status)" +
+                              std::to_string(si->si_status);
+            lg2::error(msg.c_str());
+            this->createDumpFailed(entryId);
+        }
+        if (type == DumpTypes::USER)
+        {
+            lg2::info("User initiated dump completed, resetting flag");
+            Manager::fUserDumpInProgress = false;
+        }
+        storage.settle(entryId);
+        admission.done();
+    });
+}
+
 void Manager::createEntry(const std::filesystem::path& file)
 {
     auto dumpDetails = extractDumpDetails(file);
@@ -324,44 +378,45 @@ void Manager::restore()
     }
 }
 
-size_t getDirectorySize(const std::string dir)
+size_t Manager::getAllowedSize()
 {
-    auto size = 0;
-    for (const auto& p : std::filesystem::recursive_directory_iterator(dir))
+#ifdef BMC_DUMP_ROTATE_CONFIG
+    // Pick the oldest completed dumps freeing enough space from the entry
+    // sizes and delete them at once. Only the space the BMC dumps are short
+    // of counts, the dumps in flight of the other pools are not made room
+    // for, and the BMC dumps in flight are left alone.
+    auto needed = storage.shortfall(BMC_DUMP_MIN_SPACE_REQD);
+    while (needed > 0)
     {
-        if (!std::filesystem::is_directory(p))
+        std::vector<std::pair<uint32_t, size_t>> sizes;
+        for (const auto& [id, entry] : entries)
         {
-            size += std::ceil(std::filesystem::file_size(p) / 1024.0);
+            if (entry && entry->status() != OperationStatus::InProgress)
+            {
+                sizes.emplace_back(id, (entry->size() + 1023) / 1024);
+            }
+        }
+        if (sizes.empty())
+        {
+            break;
         }
-    }
-    return size;
-}
-
-size_t Manager::getAllowedSize()
-{
-    // Get current size of the dump directory.
-    auto size = getDirectorySize(dumpDir);
-
-    // Set the Dump size to Maximum  if the free space is greater than
-    // Dump max size otherwise return the available size.
-
-    size = (size > BMC_DUMP_TOTAL_SIZE ? 0 : BMC_DUMP_TOTAL_SIZE - size);
 
-#ifdef BMC_DUMP_ROTATE_CONFIG
-    // Delete the first existing file until the space is enough
-    while (size < BMC_DUMP_MIN_SPACE_REQD)
-    {
-        auto delEntry = min_element(
-            entries.begin(), entries.end(),
-            [](const auto& l, const auto& r) { return l.first < r.first; });
-        auto delPath = std::filesystem::path(dumpDir) /
-                       std::to_string(delEntry->first);
+        for (auto id : selectEvictions(sizes, needed))
+        {
+            // delete_() erases the entry from the map
+            if (auto it = entries.find(id); it != entries.end())
+            {
+                it->second->delete_();
+            }
+        }
+        needed = storage.shortfall(BMC_DUMP_MIN_SPACE_REQD);
+    }
+#endif
 
-        size += getDirectorySize(delPath);
+    // Space left within BMC_DUMP_TOTAL_SIZE and on the partition, less what
+    // the dumps in flight reserved
+    auto size = storage.available();
 
-        delEntry->second->delete_();
-    }
-#else
     using namespace sdbusplus::xyz::openbmc_project::Dump::Create::Error;
     using Reason = xyz::openbmc_project::Dump::Create::QuotaExceeded::REASON;
 
@@ -370,7 +425,6 @@ size_t Manager::getAllowedSize()
         // Reached to maximum limit
         elog<QuotaExceeded>(Reason("Not enough space: Delete old dumps"));
     }
-#endif
 
     if (size > BMC_DUMP_MAX_SIZE)
     {
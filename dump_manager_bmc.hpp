@@ -1,14 +1,18 @@
 #pragma once
 
+#include "config.h"
+
 #include "bmc_dump_entry.hpp"
+#include "collector_class.hpp"
 #include "dump_entry.hpp"
 #include "dump_manager.hpp"
+#include "dump_spawner.hpp"
 #include "dump_utils.hpp"
+#include "storage_budget.hpp"
 #include "watch.hpp"
 
 #include <filesystem>
 #include <map>
-#include <sdeventplus/source/child.hpp>
 #include <xyz/openbmc_project/Dump/Create/server.hpp>
 
 namespace phosphor
@@ -24,7 +28,6 @@ using CreateIface = sdbusplus::server::object_t<
 using UserMap = phosphor::dump::inotify::UserMap;
 
 using Watch = phosphor::dump::inotify::Watch;
-using ::sdeventplus::source::Child;
 
 /** @class Manager
  *  @brief OpenBMC Dump  manager implementation.
@@ -60,7 +63,9 @@ class Manager :
             filePath,
             std::bind(std::mem_fn(&phosphor::dump::bmc::Manager::watchCallback),
                       this, std::placeholders::_1)),
-        dumpDir(filePath)
+        dumpDir(filePath), spawner(eventLoop), admission(eventLoop.get()),
+        storage(StorageBudget::instance().addPool(
+            "bmc", filePath, BMC_DUMP_TOTAL_SIZE, BMC_DUMP_MAX_SIZE))
     {}
 
     /** @brief Implementation of dump watch call back
@@ -93,6 +98,14 @@ class Manager :
         }
     }
 
+  protected:
+    /** @brief Erase specified entry d-bus object, cancelling its dump if it
+     *         still waits for the admission control
+     *
+     * @param[in] entryId - unique identifier of the entry
+     */
+    void erase(uint32_t entryId) override;
+
   private:
     /** @brief Create Dump entry d-bus object
      *  @param[in] fullPath - Full path of the Dump file name
@@ -103,9 +116,20 @@ class Manager :
      *  @param[in] type - Type of the dump to pass to dreport
      *  @param[in] path - An absolute path to the file
      *             to be included as part of Dump package.
+     *  @param[out] decision - Admission of the dump, to publish once the
+     *              entry exists.
      *  @return id - The Dump entry id number.
      */
-    uint32_t captureDump(DumpTypes type, const std::string& path);
+    uint32_t captureDump(DumpTypes type, const std::string& path,
+                         AdmissionDecision& decision);
+
+    /** @brief Start dreport for a dump admitted by the admission control
+     *  @param[in] argv - dreport command line.
+     *  @param[in] type - Type of the dump.
+     *  @param[in] entryId - Id of the dump entry.
+     */
+    void startDump(const std::vector<std::string>& argv, DumpTypes type,
+                   uint32_t entryId);
 
     /** @brief Remove specified watch object pointer from the
      *        watch map and associated entry from the map.
@@ -113,8 +137,8 @@ class Manager :
      */
     void removeWatch(const std::filesystem::path& path);
 
-    /** @brief Calculate per dump allowed size based on the available
-     *        size in the dump location.
+    /** @brief Calculate per dump allowed size based on the space left in
+     *        the storage budget.
      *  @returns dump size in kilobytes.
      */
     size_t getAllowedSize();
@@ -137,8 +161,14 @@ class Manager :
      */
     std::map<std::filesystem::path, std::unique_ptr<Watch>> childWatchMap;
 
-    /** @brief map of SDEventPlus child pointer added to event loop */
-    std::map<pid_t, std::unique_ptr<Child>> childPtrMap;
+    /** @brief Launches the dreport collections */
+    Spawner spawner;
+
+    /** @brief Holds back the dumps while the BMC is under pressure */
+    AdmissionControl admission;
+
+    /** @brief Space of the BMC dumps in the storage budget */
+    StoragePool& storage;
 };
 
 } // namespace bmc
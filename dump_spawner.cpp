@@ -0,0 +1,325 @@
+#include "dump_spawner.hpp"
+
+#include "xyz/openbmc_project/Common/error.hpp"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/lg2.hpp>
+#include <string_view>
+
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 39)
+#define HAVE_PIDFD_SPAWN
+#include <sys/pidfd.h>
+#endif
+#endif
+
+namespace phosphor
+{
+namespace dump
+{
+
+using namespace phosphor::logging;
+using namespace sdbusplus::xyz::openbmc_project::Common::Error;
+
+namespace
+{
+
+/** @brief Environment of the collector: ours, with the variables of the
+ *         options replacing the ones of the same name.
+ */
+std::vector<char*> makeEnvironment(const std::vector<std::string>& extra)
+{
+    std::vector<char*> envp;
+    for (char** var = environ; *var != nullptr; ++var)
+    {
+        auto name = std::string_view(*var).substr(
+            0, std::string_view(*var).find('='));
+        bool replaced = false;
+        for (const auto& value : extra)
+        {
+            if (value.size() > name.size() && value[name.size()] == '=' &&
+                value.compare(0, name.size(), name) == 0)
+            {
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced)
+        {
+            envp.push_back(*var);
+        }
+    }
+    for (const auto& value : extra)
+    {
+        envp.push_back(const_cast<char*>(value.c_str()));
+    }
+    envp.push_back(nullptr);
+    return envp;
+}
+
+// From linux/ioprio.h
+constexpr int IOPRIO_WHO_PROCESS = 1;
+
+/** @class SpawnPriority
+ *
+ *  @brief Nice value and I/O priority of the calling thread while it spawns
+ *  a collector.
+ *
+ *  Both are per thread and inherited by the child, so the collector starts
+ *  with them before it execs and before it can fork helpers of its own.
+ *  The thread gets back its own values once the collector is started.
+ */
+class SpawnPriority
+{
+  public:
+    SpawnPriority(const SpawnPriority&) = delete;
+    SpawnPriority& operator=(const SpawnPriority&) = delete;
+    SpawnPriority(SpawnPriority&&) = delete;
+    SpawnPriority& operator=(SpawnPriority&&) = delete;
+
+    SpawnPriority(int nice, int ioprio)
+    {
+        if (nice != 0)
+        {
+            errno = 0;
+            savedNice = getpriority(PRIO_PROCESS, 0);
+            if (errno == 0 && setpriority(PRIO_PROCESS, 0, nice) == 0)
+            {
+                niceSet = true;
+            }
+            else
+            {
+                auto error = errno;
+                lg2::warning("Failed to set the collector priority, "
+                             "errno: {ERRNO}",
+                             "ERRNO", error);
+            }
+        }
+        if (ioprio != 0)
+        {
+            savedIoprio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+            if (savedIoprio >= 0 &&
+                syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio) == 0)
+            {
+                ioprioSet = true;
+            }
+            else
+            {
+                auto error = errno;
+                lg2::warning("Failed to set the collector I/O priority, "
+                             "errno: {ERRNO}",
+                             "ERRNO", error);
+            }
+        }
+    }
+
+    ~SpawnPriority()
+    {
+        if (niceSet && setpriority(PRIO_PROCESS, 0, savedNice) < 0)
+        {
+            auto error = errno;
+            lg2::error("Failed to restore the dump manager priority, "
+                       "errno: {ERRNO}",
+                       "ERRNO", error);
+        }
+        if (ioprioSet &&
+            syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, savedIoprio) < 0)
+        {
+            auto error = errno;
+            lg2::error("Failed to restore the dump manager I/O priority, "
+                       "errno: {ERRNO}",
+                       "ERRNO", error);
+        }
+    }
+
+  private:
+    int savedNice = 0;
+    long savedIoprio = 0;
+    bool niceSet = false;
+    bool ioprioSet = false;
+};
+
+#ifndef HAVE_PIDFD_SPAWN
+/** @brief Open a pidfd on a child, -1 if the kernel has no pidfd support */
+int openPidfd([[maybe_unused]] pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    return -1;
+#endif
+}
+#endif
+
+} // namespace
+
+pid_t Spawner::spawn(const std::vector<std::string>& argv,
+                     const SpawnOptions& options, Callback&& callback)
+{
+    if (argv.empty())
+    {
+        lg2::error("Empty collector command");
+        elog<InternalFailure>();
+    }
+
+    std::vector<char*> args;
+    for (const auto& arg : argv)
+    {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    auto envp = makeEnvironment(options.environment);
+
+    // SIGCHLD is blocked in the manager for sd-event, not in the collector
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    short flags = POSIX_SPAWN_SETSIGMASK;
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    pid_t pid = -1;
+    int pidfd = -1;
+    int rc = 0;
+    bool inCgroup = options.cgroup.empty();
+    auto start = std::chrono::steady_clock::now();
+    std::optional<SpawnPriority> priority(std::in_place, options.nice,
+                                          options.ioprio);
+#ifdef HAVE_PIDFD_SPAWN
+    // Start the collector in its cgroup, and get its pidfd without a race
+    // against the pid being reused
+    int cgroupFd = -1;
+    if (!inCgroup)
+    {
+        cgroupFd = open(options.cgroup.c_str(),
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (cgroupFd >= 0)
+        {
+            posix_spawnattr_setcgroup_np(&attr, cgroupFd);
+            flags |= POSIX_SPAWN_SETCGROUP;
+            inCgroup = true;
+        }
+    }
+    posix_spawnattr_setflags(&attr, flags);
+    rc = pidfd_spawn(&pidfd, args[0], nullptr, &attr, args.data(),
+                     envp.data());
+    if (rc != 0 && (flags & POSIX_SPAWN_SETCGROUP))
+    {
+        // A cgroup which can not take processes, threaded or not delegated,
+        // does not cost the dump, the collector is moved after the spawn
+        lg2::warning("Failed to start the collector in its cgroup, "
+                     "CGROUP: {CGROUP}, errno: {ERRNO}",
+                     "CGROUP", options.cgroup, "ERRNO", rc);
+        flags &= ~POSIX_SPAWN_SETCGROUP;
+        inCgroup = false;
+        posix_spawnattr_setflags(&attr, flags);
+        rc = pidfd_spawn(&pidfd, args[0], nullptr, &attr, args.data(),
+                         envp.data());
+    }
+    if (cgroupFd >= 0)
+    {
+        close(cgroupFd);
+    }
+    if (rc == 0)
+    {
+        pid = pidfd_getpid(pidfd);
+    }
+#else
+    // Without pidfd_spawn the collector is moved to its cgroup after the
+    // spawn, clone3 would copy the manager's page tables like fork does
+    posix_spawnattr_setflags(&attr, flags);
+    rc = posix_spawn(&pid, args[0], nullptr, &attr, args.data(), envp.data());
+    if (rc == 0)
+    {
+        pidfd = openPidfd(pid);
+    }
+#endif
+    priority.reset();
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    posix_spawnattr_destroy(&attr);
+
+    if (rc != 0)
+    {
+        lg2::error("Error occurred during the collector spawn, PATH: {PATH}, "
+                   "errno: {ERRNO}",
+                   "PATH", argv[0], "ERRNO", rc);
+        elog<InternalFailure>();
+    }
+    lg2::info("Collector spawned, PATH: {PATH}, PID: {PID}, "
+              "LATENCY_US: {LATENCY_US}",
+              "PATH", argv[0], "PID", pid, "LATENCY_US", latency.count());
+
+    if (!inCgroup)
+    {
+        // Best effort, what the collector forks before the move stays out
+        std::ofstream procs(options.cgroup + "/cgroup.procs");
+        procs << pid << std::flush;
+        if (!procs)
+        {
+            lg2::warning("Failed to move the collector to its cgroup, "
+                         "CGROUP: {CGROUP}, PID: {PID}",
+                         "CGROUP", options.cgroup, "PID", pid);
+        }
+    }
+
+    auto process = std::make_unique<Process>(*this, pid, std::move(callback));
+    if (pidfd >= 0)
+    {
+        rc = sd_event_add_child_pidfd(event, &process->source, pidfd, WEXITED,
+                                      onExit, process.get());
+        if (rc < 0)
+        {
+            close(pidfd);
+        }
+        else
+        {
+            sd_event_source_set_child_pidfd_own(process->source, true);
+        }
+    }
+    else
+    {
+        rc = sd_event_add_child(event, &process->source, pid, WEXITED, onExit,
+                                process.get());
+    }
+    if (rc < 0)
+    {
+        // Not followed, the collector would run unnoticed
+        lg2::error("Error occurred during the child event source creation, "
+                   "PID: {PID}, rc: {RC}",
+                   "PID", pid, "RC", rc);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        elog<InternalFailure>();
+    }
+
+    processes.emplace(pid, std::move(process));
+    return pid;
+}
+
+int Spawner::onExit(sd_event_source*, const siginfo_t* si, void* userdata)
+{
+    auto process = static_cast<Process*>(userdata);
+    auto& spawner = process->spawner;
+
+    // The source goes away with the process, keep what the callback needs
+    auto info = *si;
+    auto callback = std::move(process->callback);
+    spawner.processes.erase(process->pid);
+
+    callback(&info);
+    return 0;
+}
+
+} // namespace dump
+} // namespace phosphor
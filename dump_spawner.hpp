@@ -0,0 +1,131 @@
+#pragma once
+
+#include "dump_utils.hpp"
+
+#include <signal.h>
+#include <systemd/sd-event.h>
+#include <unistd.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+
+/** @struct SpawnOptions
+ *
+ *  Settings of the process a collector runs in.
+ */
+struct SpawnOptions
+{
+    /** @brief Variables added to the environment, as NAME=value */
+    std::vector<std::string> environment;
+
+    /** @brief cgroup v2 directory to run in, the manager's cgroup if empty */
+    std::string cgroup;
+
+    /** @brief Nice value */
+    int nice = 0;
+
+    /** @brief I/O priority, as an ioprio_set() value, 0 to keep ours */
+    int ioprio = 0;
+};
+
+/** @class Spawner
+ *
+ *  @brief Launches the dump collectors and reports their exit.
+ *
+ *  Collectors are started with posix_spawn, which does not copy the
+ *  manager's memory and runs no code of ours in the child, and followed
+ *  through a pidfd in the sd-event loop. They start in their cgroup with
+ *  pidfd_spawn, or are moved there right after the spawn when the C library
+ *  lacks it or the cgroup refuses them, and inherit their nice value and I/O
+ *  priority from the spawning thread.
+ */
+class Spawner
+{
+  public:
+    /** @brief Called with the exit status of the collector */
+    using Callback = std::function<void(const siginfo_t*)>;
+
+    Spawner() = delete;
+    Spawner(const Spawner&) = delete;
+    Spawner& operator=(const Spawner&) = delete;
+    Spawner(Spawner&&) = delete;
+    Spawner& operator=(Spawner&&) = delete;
+    ~Spawner() = default;
+
+    /** @brief Constructor
+     *  @param[in] event - Event loop the exits are reported from.
+     */
+    explicit Spawner(const EventPtr& event) : event(event.get()) {}
+
+    /** @brief Start a collector
+     *  @details Failing to apply the cgroup or a priority is logged and the
+     *           collector runs without it. InternalFailure is thrown if
+     *           the collector can not be started.
+     *
+     *  @param[in] argv - Collector path and arguments.
+     *  @param[in] options - Process settings.
+     *  @param[in] callback - Called once the collector exited.
+     *
+     *  @returns pid of the collector
+     */
+    pid_t spawn(const std::vector<std::string>& argv,
+                const SpawnOptions& options, Callback&& callback);
+
+    /** @brief Number of collectors running */
+    size_t running() const
+    {
+        return processes.size();
+    }
+
+  private:
+    /** @brief Collector being followed */
+    struct Process
+    {
+        Process(Spawner& spawner, pid_t pid, Callback&& callback) :
+            spawner(spawner), pid(pid), callback(std::move(callback))
+        {}
+        Process(const Process&) = delete;
+        Process& operator=(const Process&) = delete;
+
+        ~Process()
+        {
+            if (source != nullptr)
+            {
+                sd_event_source_disable_unref(source);
+            }
+        }
+
+        Spawner& spawner;
+        pid_t pid;
+        Callback callback;
+        sd_event_source* source = nullptr;
+    };
+
+    /** @brief sd-event callback of a collector exit
+     *
+     *  @param[in] s - child event source
+     *  @param[in] si - exit status
+     *  @param[in] userdata - pointer to the Process
+     *
+     *  @returns 0
+     */
+    static int onExit(sd_event_source* s, const siginfo_t* si,
+                      void* userdata);
+
+    /** @brief Event loop */
+    sd_event* event;
+
+    /** @brief Collectors running, by pid */
+    std::map<pid_t, std::unique_ptr<Process>> processes;
+};
+
+} // namespace dump
+} // namespace phosphor
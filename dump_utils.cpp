@@ -77,5 +77,19 @@ std::optional<std::tuple<uint32_t, uint64_t, uint64_t>>
                            std::filesystem::file_size(file));
 }
 
+void removeDumpCopy(const std::filesystem::path& file)
+{
+    // Named as create-dump-dbus saves it
+    auto copy = std::filesystem::path(BMC_DUMP_COPY_PATH) /
+                ("copy_" + file.filename().string());
+    std::error_code ec;
+    if (!std::filesystem::remove(copy, ec) && ec)
+    {
+        lg2::error("Failed to delete the dump copy, PATH: {PATH}, "
+                   "ERROR: {ERROR}",
+                   "PATH", copy, "ERROR", ec.message());
+    }
+}
+
 } // namespace dump
 } // namespace phosphor
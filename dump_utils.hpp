@@ -388,5 +388,14 @@ inline DumpTypes getErrorDumpType(phosphor::dump::DumpCreateParams& params)
 std::optional<std::tuple<uint32_t, uint64_t, uint64_t>>
     extractDumpDetails(const std::filesystem::path& file);
 
+/**
+ * @brief Removes the copy of a dump file create-dump-dbus linked to
+ *        BMC_DUMP_COPY_PATH, which would keep the space of the dump once
+ *        deleted.
+ *
+ * @param[in] file The path to the dump file.
+ */
+void removeDumpCopy(const std::filesystem::path& file);
+
 } // namespace dump
 } // namespace phosphor
@@ -5,8 +5,12 @@
 #include "dump_utils.hpp"
 #include "xyz/openbmc_project/Common/error.hpp"
 
+#include <unistd.h>
+
+#include <fstream>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/lg2.hpp>
+#include <sdeventplus/event.hpp>
 
 namespace phosphor
 {
@@ -19,49 +23,137 @@ using namespace phosphor::logging;
 using NotAllowed = sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
 using Reason = xyz::openbmc_project::Common::NotAllowed::REASON;
 
-int openPLDM()
+constexpr auto eidPath = "/usr/share/pldm/host_eid";
+
+Session& Session::get()
+{
+    static Session session;
+    return session;
+}
+
+Session::~Session()
 {
-    auto fd = pldm_open();
-    if (fd < 0)
+    closeFd();
+}
+
+mctp_eid_t Session::eid()
+{
+    if (hostEID)
     {
-        auto e = errno;
-        lg2::error("pldm_open failed, errno: {ERRNO}, FD: FD", "ERRNO", e, "FD",
-                   fd);
-        elog<NotAllowed>(
-            Reason("Required host dump action via pldm is not allowed due "
-                   "to pldm_open failed"));
+        return *hostEID;
+    }
+
+    std::ifstream eidFile{eidPath};
+    if (!eidFile.good())
+    {
+        lg2::error("Could not open host EID file");
+        elog<NotAllowed>(Reason("Required host dump action via pldm is not "
+                                "allowed due to mctp end point read failed"));
     }
-    return fd;
+
+    std::string eid;
+    eidFile >> eid;
+    if (eid.empty())
+    {
+        lg2::error("EID file was empty");
+        elog<NotAllowed>(Reason("Required host dump action via pldm is not "
+                                "allowed due to mctp end point read failed"));
+    }
+
+    hostEID = static_cast<mctp_eid_t>(strtol(eid.c_str(), nullptr, 10));
+    lg2::info("Host PLDM eid: {EID}", "EID", *hostEID);
+    return *hostEID;
 }
 
-uint8_t getPLDMInstanceID(uint8_t eid)
+uint8_t Session::instanceID()
 {
     constexpr auto pldmRequester = "xyz.openbmc_project.PLDM.Requester";
     constexpr auto pldm = "/xyz/openbmc_project/pldm";
+    auto eid = this->eid();
     uint8_t instanceID = 0;
 
-    try
+    // A cached service may be gone with a restart of the PLDM daemon, it is
+    // looked up again once before giving up
+    for (auto attempt = 0;; ++attempt)
     {
-        auto bus = sdbusplus::bus::new_default();
-        auto service = phosphor::dump::getService(bus, pldm, pldmRequester);
+        try
+        {
+            if (!bus)
+            {
+                bus.emplace(sdbusplus::bus::new_default());
+            }
+            if (service.empty())
+            {
+                service = phosphor::dump::getService(*bus, pldm,
+                                                     pldmRequester);
+            }
+
+            auto method = bus->new_method_call(service.c_str(), pldm,
+                                               pldmRequester, "GetInstanceId");
+            method.append(eid);
+            auto reply = bus->call(method);
 
-        auto method = bus.new_method_call(service.c_str(), pldm, pldmRequester,
-                                          "GetInstanceId");
-        method.append(eid);
-        auto reply = bus.call(method);
+            reply.read(instanceID);
+            break;
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            service.clear();
+            if (attempt == 0)
+            {
+                continue;
+            }
+            lg2::error("Failed to get instance id error: {ERROR}", "ERROR", e);
+            elog<NotAllowed>(
+                Reason("Failure in communicating with pldm service, "
+                       "service may not be running"));
+        }
+    }
+
+    lg2::info("Got instanceId: {INSTANCE_ID} from PLDM eid: {EID}",
+              "INSTANCE_ID", instanceID, "EID", eid);
+    return instanceID;
+}
+
+int Session::send(const uint8_t* msg, size_t size)
+{
+    return pldm_send(eid(), fd(), msg, size);
+}
 
-        reply.read(instanceID);
+int Session::fd()
+{
+    if (pldmFd >= 0)
+    {
+        return pldmFd;
+    }
 
-        lg2::info("Got instanceId: {INSTANCE_ID} from PLDM eid: {EID}",
-                  "INSTANCE_ID", instanceID, "EID", eid);
+    pldmFd = pldm_open();
+    if (pldmFd < 0)
+    {
+        auto e = errno;
+        lg2::error("pldm_open failed, errno: {ERRNO}, FD: {FD}", "ERRNO", e,
+                   "FD", pldmFd);
+        elog<NotAllowed>(
+            Reason("Required host dump action via pldm is not allowed due "
+                   "to pldm_open failed"));
     }
-    catch (const sdbusplus::exception::SdBusError& e)
+
+    // The fd is never read, the messages of the host pile up in it until it
+    // is closed
+    closeSource = std::make_unique<sdeventplus::source::Defer>(
+        sdeventplus::Event::get_default(),
+        [this](auto& /*source*/) { closeFd(); });
+    return pldmFd;
+}
+
+void Session::closeFd()
+{
+    if (pldmFd >= 0)
     {
-        lg2::error("Failed to get instance id error: {ERROR}", "ERROR", e);
-        elog<NotAllowed>(Reason("Failure in communicating with pldm service, "
-                                "service may not be running"));
+        close(pldmFd);
+        pldmFd = -1;
     }
-    return instanceID;
+    closeSource.reset();
 }
 
 } // namespace pldm
@@ -4,6 +4,15 @@
 
 #include <libpldm/pldm.h>
 
+#include <sdbusplus/bus.hpp>
+#include <sdeventplus/source/event.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
 namespace phosphor
 {
 namespace dump
@@ -12,22 +21,89 @@ namespace pldm
 {
 
 /**
- * @brief Opens the PLDM file descriptor
+ * @class Session
+ *
+ * @brief PLDM state shared by the requests to the host
  *
- * @return file descriptor on success and throw
- *         exception (xyz::openbmc_project::Common::Error::NotAllowed) on
- *         failures.
+ * The host EID, the PLDM requester service and the bus to reach it are set
+ * up by the first request and reused by the next ones. The PLDM file
+ * descriptor is shared by the requests of one event loop iteration, a batch
+ * of deletes for instance, and closed after them: mctp-demux queues every
+ * PLDM message of the host to each of its clients, and the manager does not
+ * read them.
  */
-int openPLDM();
+class Session
+{
+  public:
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+    Session(Session&&) = delete;
+    Session& operator=(Session&&) = delete;
+    ~Session();
 
-/**
- * @brief Returns the PLDM instance ID to use for PLDM commands
- *
- * @param[in] eid - The PLDM EID
- *
- * @return uint8_t - The instance ID
- **/
-uint8_t getPLDMInstanceID(uint8_t eid);
+    /**
+     * @brief Returns the session of the dump manager
+     */
+    static Session& get();
+
+    /**
+     * @brief Returns the host MCTP endpoint ID, read from its file once
+     *
+     * @return the EID and throw exception
+     *         (xyz::openbmc_project::Common::Error::NotAllowed) on failures.
+     */
+    mctp_eid_t eid();
+
+    /**
+     * @brief Returns the PLDM instance ID to use for the next PLDM command
+     *
+     * @return uint8_t - The instance ID, throw exception
+     *         (xyz::openbmc_project::Common::Error::NotAllowed) on failures.
+     */
+    uint8_t instanceID();
+
+    /**
+     * @brief Sends a PLDM message to the host
+     *
+     * @param[in] msg - Encoded message.
+     * @param[in] size - Size of the message.
+     *
+     * @return the pldm_send return code, errno is set on failures.
+     */
+    int send(const uint8_t* msg, size_t size);
+
+  private:
+    Session() = default;
+
+    /**
+     * @brief Returns the PLDM file descriptor, opened on first use in the
+     *        event loop iteration
+     *
+     * @return file descriptor on success and throw
+     *         exception (xyz::openbmc_project::Common::Error::NotAllowed) on
+     *         failures.
+     */
+    int fd();
+
+    /** @brief Closes the PLDM file descriptor */
+    void closeFd();
+
+    /** @brief Host EID, once read */
+    std::optional<mctp_eid_t> hostEID;
+
+    /** @brief Bus to the PLDM requester, once connected */
+    std::optional<sdbusplus::bus_t> bus;
+
+    /** @brief PLDM requester service, empty until looked up */
+    std::string service;
+
+    /** @brief PLDM file descriptor */
+    int pldmFd = -1;
+
+    /** @brief Closes the PLDM file descriptor from the next event loop
+     *         iteration */
+    std::unique_ptr<sdeventplus::source::Defer> closeSource;
+};
 
 } // namespace pldm
 } // namespace dump
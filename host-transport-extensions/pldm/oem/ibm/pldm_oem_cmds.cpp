@@ -24,7 +24,6 @@
 #include <libpldm/platform.h>
 #include <unistd.h>
 
-#include <fstream>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/lg2.hpp>
 #include <sdbusplus/bus.hpp>
@@ -57,43 +56,9 @@ namespace pldm
 
 using namespace phosphor::logging;
 
-constexpr auto eidPath = "/usr/share/pldm/host_eid";
-constexpr mctp_eid_t defaultEIDValue = 9;
-
 using NotAllowed = sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
 using Reason = xyz::openbmc_project::Common::NotAllowed::REASON;
 
-mctp_eid_t readEID()
-{
-    mctp_eid_t eid = defaultEIDValue;
-
-    std::ifstream eidFile{eidPath};
-    if (!eidFile.good())
-    {
-        lg2::error("Could not open host EID file");
-        elog<NotAllowed>(Reason("Required host dump action via pldm is not "
-                                "allowed due to mctp end point read failed"));
-    }
-    else
-    {
-        std::string eid;
-        eidFile >> eid;
-        if (!eid.empty())
-        {
-            eid = strtol(eid.c_str(), nullptr, 10);
-        }
-        else
-        {
-            lg2::error("EID file was empty");
-            elog<NotAllowed>(
-                Reason("Required host dump action via pldm is not "
-                       "allowed due to mctp end point read failed"));
-        }
-    }
-
-    return eid;
-}
-
 void requestOffload(uint32_t id)
 {
     uint16_t effecterId = 0x05; // TODO PhyP temporary Hardcoded value.
@@ -107,9 +72,10 @@ void requestOffload(uint32_t id)
 
     memcpy(effecterValue.data(), &id, sizeof(id));
 
-    mctp_eid_t eid = readEID();
+    auto& session = Session::get();
+    mctp_eid_t eid = session.eid();
 
-    auto instanceID = getPLDMInstanceID(eid);
+    auto instanceID = session.instanceID();
 
     auto rc = encode_set_numeric_effecter_value_req(
         instanceID, effecterId, PLDM_EFFECTER_DATA_SIZE_UINT32,
@@ -123,12 +89,10 @@ void requestOffload(uint32_t id)
                                 "allowed due to encode failed"));
     }
 
-    CustomFd fd(openPLDM());
-
     lg2::info("Sending request to offload dump id: {ID}, eid: {EID}", "ID", id,
               "EID", eid);
 
-    rc = pldm_send(eid, fd(), requestMsg.data(), requestMsg.size());
+    rc = session.send(requestMsg.data(), requestMsg.size());
     if (rc < 0)
     {
         auto e = errno;
@@ -158,9 +122,9 @@ void requestDelete(uint32_t dumpId, uint32_t dumpType)
     const size_t pldmMsgHdrSize = sizeof(pldm_msg_hdr);
     std::array<uint8_t, pldmMsgHdrSize + PLDM_FILE_ACK_REQ_BYTES> fileAckReqMsg;
 
-    mctp_eid_t mctpEndPointId = readEID();
+    auto& session = Session::get();
 
-    auto pldmInstanceId = getPLDMInstanceID(mctpEndPointId);
+    auto pldmInstanceId = session.instanceID();
 
     // - PLDM_SUCCESS - To indicate dump was readed (offloaded) or user decided,
     //   no longer host dump is not required so, initiate deletion from
@@ -181,10 +145,7 @@ void requestDelete(uint32_t dumpId, uint32_t dumpType)
                                 "allowed due to encode fileack failed"));
     }
 
-    CustomFd pldmFd(openPLDM());
-
-    retCode = pldm_send(mctpEndPointId, pldmFd(), fileAckReqMsg.data(),
-                        fileAckReqMsg.size());
+    retCode = session.send(fileAckReqMsg.data(), fileAckReqMsg.size());
     if (retCode != PLDM_REQUESTER_SUCCESS)
     {
         auto errorNumber = errno;
@@ -48,11 +48,6 @@ namespace pldm
 
 void requestOffload(uint32_t id);
 
-/**
- * @brief Reads the MCTP endpoint ID out of a file
- */
-mctp_eid_t readEID();
-
 /**
  * @brief Request to delete dump
  *
@@ -3,1003 +3,316 @@
  * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
  */
 
-#include <fcntl.h>
+#include "nsm_device_dump.hpp"
+#include "report.hpp"
+
+#include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
+#include <systemd/sd-event.h>
 #include <unistd.h>
 
 #include <chrono>
 #include <ctime>
-#include <fstream>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/lg2.hpp>
 #include <sdbusplus/bus.hpp>
+#include <sdeventplus/event.hpp>
+#include <vector>
 
 #define VERSION "1.0"
-#define MAX_IN_PROGRESS_COUNT 1000
-#define MAX_ERROR_COUNT 3
-#define SLEEP_DURING_WAIT 20
+/* Devices collected at the same time when several targets are given */
+#define DEFAULT_DEVICES_IN_FLIGHT 4
 
 using namespace std;
 using namespace phosphor::logging;
 
 std::string dumpPath;
-std::string targetDevice;
-std::string outputFileName;
-uint32_t outputFileSize;
-
-enum OperationStatus
-{
-    Success,
-    InProgress,
-    Error,
-};
 
-enum class DeviceTypeData
+/**
+ * @brief A target device given on the command line and the collections it
+ *        is made of, run one after the other.
+ */
+struct Target
 {
-    NVSwitch,
-    NVLinkMgmtNIC_Dump,
-    NVLinkMgmtNIC_Log,
-    GPU_SXM,
+    std::string name;
+    std::vector<std::unique_ptr<DeviceDump>> dumps;
+    size_t next = 0;
+    /** result of the first collection, the one the target is judged by */
+    std::optional<uint8_t> result;
+    /** all the collections succeeded, their checkpoints can go */
+    bool complete = true;
 };
 
-void log_msg(std::string msg)
-{
-    fstream log_file;
-    log_file.open(dumpPath + "/Execution_Report.txt", ios::app);
-    if (log_file)
-    {
-        log_file << msg << std::endl;
-    }
-    log_file.close();
-}
-
-uint8_t sendRequestRecordCommand(uint8_t index, uint64_t nextRecord,
-                                 DeviceTypeData dataType)
+/**
+ * @brief Runs the targets on the shared bus, at most maxInFlight of them at
+ *        a time.
+ */
+class Scheduler
 {
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    std::string objectPath, interf, method;
+  public:
+    Scheduler(const sdeventplus::Event& event, size_t maxInFlight) :
+        event(event), maxInFlight(std::max<size_t>(maxInFlight, 1))
+    {}
 
-    switch (dataType)
+    void add(std::unique_ptr<Target>&& target)
     {
-        case DeviceTypeData::NVSwitch:
-            objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                         "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                         std::to_string(index);
-            interf = "com.nvidia.Dump.DebugInfo";
-            method = "GetDebugInfo";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "com.nvidia.Dump.DebugInfo";
-            method = "GetDebugInfo";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "com.nvidia.Dump.LogInfo";
-            method = "GetLogInfo";
-            break;
-        case DeviceTypeData::GPU_SXM:
-            objectPath = "/xyz/openbmc_project/inventory/system/"
-                         "processors/GPU_SXM_" +
-                         std::to_string(index);
-            interf = "com.nvidia.Dump.DebugInfo";
-            method = "GetDebugInfo";
-            break;
-        default:
-            std::string errorStr(
-                "Invalid data type in sendRequestRecordCommand");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
+        pending.push_back(targets.size());
+        targets.push_back(std::move(target));
     }
 
-    auto sendCommandMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            interf.c_str(), method.c_str());
-
-    switch (dataType)
+    /** @brief Run all the targets to completion */
+    void run()
     {
-        case DeviceTypeData::NVSwitch:
-            sendCommandMethod.append("com.nvidia.Dump.DebugInfo."
-                                     "DebugInformationType.DeviceInformation",
-                                     nextRecord);
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            sendCommandMethod.append("com.nvidia.Dump.DebugInfo."
-                                     "DebugInformationType.DeviceInformation",
-                                     nextRecord);
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            sendCommandMethod.append(nextRecord);
-            break;
-        case DeviceTypeData::GPU_SXM:
-            sendCommandMethod.append("com.nvidia.Dump.DebugInfo."
-                                     "DebugInformationType.DeviceInformation",
-                                     nextRecord);
-            break;
-        default:
-            std::string errorStr(
-                "Invalid data type in sendRequestRecordCommand");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    try
-    {
-        auto reply = bus.call(sendCommandMethod);
-        reply.read();
+        startNext();
+        if (inFlight > 0)
+        {
+            event.loop();
+        }
     }
 
-    catch (const sdbusplus::exception::SdBusError& e)
+    const std::vector<std::unique_ptr<Target>>& getTargets() const
     {
-        std::string errorStr("Function sendRequestRecordCommand failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
-        return Error;
+        return targets;
     }
 
-    return Success;
-}
-
-uint8_t getRequestRecordCommandStatus(uint8_t index, DeviceTypeData dataType)
-{
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    std::string objectPath, interf, method;
-    switch (dataType)
+  private:
+    void startNext()
     {
-        case DeviceTypeData::NVSwitch:
-            objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                         "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::GPU_SXM:
-            objectPath = "/xyz/openbmc_project/inventory/system/"
-                         "processors/GPU_SXM_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        default:
-            std::string errorStr(
-                "Invalid data type in getRequestRecordCommandStatus");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    auto commandStatusMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            interf.c_str(), method.c_str());
-
-    switch (dataType)
-    {
-        case DeviceTypeData::NVSwitch:
-            commandStatusMethod.append("com.nvidia.Dump.DebugInfo", "Status");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            commandStatusMethod.append("com.nvidia.Dump.DebugInfo", "Status");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            commandStatusMethod.append("com.nvidia.Dump.LogInfo", "Status");
-            break;
-        case DeviceTypeData::GPU_SXM:
-            commandStatusMethod.append("com.nvidia.Dump.DebugInfo", "Status");
-            break;
-        default:
-            std::string errorStr(
-                "Invalid data type in getRequestRecordCommandStatus");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    try
-    {
-        auto statusReply = bus.call(commandStatusMethod);
-        std::variant<std::string> status;
-        statusReply.read(status);
-        std::string response(std::get<std::string>(status));
-        if (DeviceTypeData::NVLinkMgmtNIC_Log == dataType)
+        while (inFlight < maxInFlight && !pending.empty())
         {
-            if (response == "com.nvidia.Dump.LogInfo.OperationStatus.Success")
-            {
-                return Success;
-            }
-            else if (response ==
-                     "com.nvidia.Dump.LogInfo.OperationStatus.InProgress")
+            auto& target = *targets[pending.front()];
+            pending.pop_front();
+            if (target.dumps.empty())
             {
-                return InProgress;
-            }
-            else
-            {
-                log<level::ERR>(response.c_str());
-                return Error;
+                target.result = Error;
+                continue;
             }
+            inFlight++;
+            startDump(target);
         }
-        else
+        if (inFlight == 0 && pending.empty())
         {
-            if (response == "com.nvidia.Dump.DebugInfo.OperationStatus.Success")
+            event.exit(0);
+        }
+    }
+
+    void startDump(Target& target)
+    {
+        auto& dump = *target.dumps[target.next++];
+        dump.start([this, &target](uint8_t res) {
+            if (!target.result)
             {
-                return Success;
+                target.result = res;
             }
-            else if (response ==
-                     "com.nvidia.Dump.DebugInfo.OperationStatus.InProgress")
+            target.complete = target.complete && Success == res;
+            if (target.next < target.dumps.size())
             {
-                return InProgress;
+                startDump(target);
+                return;
             }
-            else
+            if (target.complete)
             {
-                log<level::ERR>(response.c_str());
-                return Error;
+                for (const auto& dump : target.dumps)
+                {
+                    dump->removeCheckpoint();
+                }
             }
-        }
-    }
-
-    catch (const sdbusplus::exception::SdBusError& e)
-    {
-        std::string errorStr("Function getRequestRecordCommandStatus failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
+            inFlight--;
+            startNext();
+        });
     }
 
-    return Error;
-}
-
-uint64_t getNextRecord(uint8_t index, DeviceTypeData dataType)
-{
-    uint64_t nextRecord = 0;
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    std::string objectPath, interf, method;
-    switch (dataType)
-    {
-        case DeviceTypeData::NVSwitch:
-            objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                         "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::GPU_SXM:
-            objectPath = "/xyz/openbmc_project/inventory/system/"
-                         "processors/GPU_SXM_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        default:
-            std::string errorStr("Invalid data type in getNextRecord");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    auto getNextRecord = bus.new_method_call("xyz.openbmc_project.NSM",
-                                             objectPath.c_str(), interf.c_str(),
-                                             method.c_str());
-
-    switch (dataType)
-    {
-        case DeviceTypeData::NVSwitch:
-            getNextRecord.append("com.nvidia.Dump.DebugInfo",
-                                 "NextRecordHandle");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            getNextRecord.append("com.nvidia.Dump.DebugInfo",
-                                 "NextRecordHandle");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            getNextRecord.append("com.nvidia.Dump.LogInfo", "NextRecordHandle");
-            break;
-        case DeviceTypeData::GPU_SXM:
-            getNextRecord.append("com.nvidia.Dump.DebugInfo",
-                                 "NextRecordHandle");
-            break;
-        default:
-            std::string errorStr("Invalid data type in getNextRecord");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    try
-    {
-        auto reply = bus.call(getNextRecord);
-        std::variant<uint64_t> NextRecordHandle;
-        reply.read(NextRecordHandle);
-        nextRecord = std::get<uint64_t>(NextRecordHandle);
-    }
-
-    catch (const sdbusplus::exception::SdBusError& e)
-    {
-        std::string errorStr("Function getNextRecord failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
-        return 0;
-    }
-
-    return nextRecord;
-}
+    const sdeventplus::Event& event;
+    size_t maxInFlight;
+    size_t inFlight = 0;
+    std::vector<std::unique_ptr<Target>> targets;
+    std::deque<size_t> pending;
+};
 
-uint8_t saveRecord(uint8_t index, DeviceTypeData dataType)
+/** @brief Build the collections of a target device name */
+std::unique_ptr<Target> makeTarget(sdbusplus::bus_t& bus,
+                                   const sdeventplus::Event& event,
+                                   const std::string& name, bool prefixReport,
+                                   bool pipeline, const std::string& compressor,
+                                   bool resume)
 {
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    std::string objectPath, interf, method;
-    switch (dataType)
-    {
-        case DeviceTypeData::NVSwitch:
-            objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                         "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
-                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
-                         "NVLinkManagementNIC_0";
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        case DeviceTypeData::GPU_SXM:
-            objectPath = "/xyz/openbmc_project/inventory/system/"
-                         "processors/GPU_SXM_" +
-                         std::to_string(index);
-            interf = "org.freedesktop.DBus.Properties";
-            method = "Get";
-            break;
-        default:
-            std::string errorStr("Invalid data type in saveRecord");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
-
-    auto getFdHandleMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            interf.c_str(), method.c_str());
-
-    switch (dataType)
-    {
-        case DeviceTypeData::NVSwitch:
-            getFdHandleMethod.append("com.nvidia.Dump.DebugInfo", "Fd");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Dump:
-            getFdHandleMethod.append("com.nvidia.Dump.DebugInfo", "Fd");
-            break;
-        case DeviceTypeData::NVLinkMgmtNIC_Log:
-            getFdHandleMethod.append("com.nvidia.Dump.LogInfo", "Fd");
-            break;
-        case DeviceTypeData::GPU_SXM:
-            getFdHandleMethod.append("com.nvidia.Dump.DebugInfo", "Fd");
-            break;
-        default:
-            std::string errorStr("Invalid data type in saveRecord");
-            log<level::ERR>(errorStr.c_str());
-            return Error;
-            break;
-    }
+    auto target = std::make_unique<Target>();
+    target->name = name;
+    auto add = [&](uint8_t index, DeviceTypeData dataType) {
+        target->dumps.emplace_back(std::make_unique<DeviceDump>(
+            bus, event, dumpPath, index, dataType, prefixReport, pipeline,
+            compressor, resume));
+    };
 
-    try
+    std::string switchStr("Net_NVSwitch_");
+    std::string gpuStr("Net_GPU_SXM_");
+    if (name.find(switchStr) != std::string::npos)
     {
-        auto reply = bus.call(getFdHandleMethod);
-        std::variant<sdbusplus::message::unix_fd> response;
-        reply.read(response);
-        sdbusplus::message::unix_fd responseFd(
-            std::get<sdbusplus::message::unix_fd>(response));
-
-        char buffer[4096];
-        ssize_t bytesRead;
-        int fd = static_cast<int>(responseFd);
-
-        fstream outputStream;
-        outputStream.open(outputFileName, ios::app | ios::binary);
-
-        while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
-        {
-            outputFileSize += bytesRead;
-            outputStream.write(buffer, bytesRead);
-        }
-        outputStream.close();
+        add(atoi(name.substr(switchStr.length()).c_str()),
+            DeviceTypeData::NVSwitch);
     }
-
-    catch (const sdbusplus::exception::SdBusError& e)
+    else if ("Net_NVLinkManagementNIC_0" == name)
     {
-        std::string errorStr("Function saveRecord failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
-        return Error;
+        add(0, DeviceTypeData::NVLinkMgmtNIC_Dump);
+        add(0, DeviceTypeData::NVLinkMgmtNIC_Log);
     }
-
-    return Success;
-}
-
-uint8_t sendSwitchResetCommand(uint8_t switchIndex)
-{
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    auto objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                      "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                      std::to_string(switchIndex);
-    auto sendCommandMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            "xyz.openbmc_project.Control.ResetAsync", "Reset");
-    try
+    else if (name.find(gpuStr) != std::string::npos)
     {
-        auto reply = bus.call(sendCommandMethod);
-        reply.read();
+        add(atoi(name.substr(gpuStr.length()).c_str()),
+            DeviceTypeData::GPU_SXM);
     }
-    catch (const sdbusplus::exception::SdBusError& e)
+    else
     {
-        std::string errorStr("Function sendSwitchResetCommand failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
-        return Error;
+        log_msg("Unsupported target device: " + name);
     }
-    return Success;
+    return target;
 }
 
-uint8_t sendSwitchEraseCommand(uint8_t switchIndex)
+void usage()
 {
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    auto objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                      "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                      std::to_string(switchIndex);
-    auto sendCommandMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            "com.nvidia.Dump.Erase", "EraseDebugInfo");
-    sendCommandMethod.append(
-        "com.nvidia.Dump.Erase.EraseInfoType.FWSavedDumpInfo");
-    try
-    {
-        auto reply = bus.call(sendCommandMethod);
-        reply.read();
-    }
-    catch (const sdbusplus::exception::SdBusError& e)
-    {
-        std::string errorStr("Function sendSwitchEraseCommand failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
-        return Error;
-    }
-    return Success;
+    printf("nsm-net-dump-tool version " VERSION "\n");
+    printf("Usage: nsm-net-dump-tool [-j <devices in flight>] [-p] [-r] "
+           "[-z <compressor>] <temp folder> <target device> "
+           "[<target device>...]\n");
+    printf("  -j, --jobs    number of target devices collected at the same "
+           "time, default: %d\n",
+           DEFAULT_DEVICES_IN_FLIGHT);
+    printf("  -p, --pipeline    request the next record before saving the "
+           "current one, only for devices which keep each record file "
+           "until it is erased\n");
+    printf("  -r, --resume    continue the collections of a failed run from "
+           "the checkpoints left in the temp folder, the default, not with "
+           "-z\n");
+    printf("  -z, --compress    stream the output files through zstd, xz or "
+           "gzip\n");
 }
 
-uint8_t getSwitchEraseStatus(uint8_t switchIndex)
+int main(int argc, char** argv)
 {
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
-    auto objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
-                      "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
-                      std::to_string(switchIndex);
-    auto eraseStatusMethod =
-        bus.new_method_call("xyz.openbmc_project.NSM", objectPath.c_str(),
-                            "org.freedesktop.DBus.Properties", "Get");
-    eraseStatusMethod.append("com.nvidia.Dump.Erase", "EraseDebugInfoStatus");
-    try
-    {
-        auto reply = bus.call(eraseStatusMethod);
-        std::variant<std::tuple<std::string, std::string>> response;
-        reply.read(response);
-        std::tuple<std::string, std::string> eraseResponse(
-            std::get<std::tuple<std::string, std::string>>(response));
-        std::string eraseReason(std::get<0>(eraseResponse));
-        std::string eraseStatus(std::get<1>(eraseResponse));
-        if (eraseReason != "com.nvidia.Dump.Erase.OperationStatus.Success")
-        {
-            log<level::ERR>(eraseReason.c_str());
-            return Error;
-        }
-        else
-        {
-            if (eraseStatus ==
-                "com.nvidia.Dump.Erase.EraseStatus.DataEraseInProgress")
-            {
-                return InProgress;
-            }
-            else
-            {
-                if (eraseStatus ==
-                    "com.nvidia.Dump.Erase.EraseStatus.DataErased")
-                {
-                    return Success;
-                }
-                else
-                {
-                    log<level::ERR>(eraseStatus.c_str());
-                    return Error;
-                }
-            }
+    struct option opts[] = {{"help", no_argument, NULL, 'h'},
+                            {"jobs", required_argument, NULL, 'j'},
+                            {"pipeline", no_argument, NULL, 'p'},
+                            {"resume", no_argument, NULL, 'r'},
+                            {"compress", required_argument, NULL, 'z'},
+                            {0, 0, 0, 0}};
+
+    int c, option_index = 0;
+    size_t maxInFlight = DEFAULT_DEVICES_IN_FLIGHT;
+    bool pipeline = false;
+    std::string compressor;
+    // A checkpoint is only left by a failed run, it is picked up without
+    // the caller asking for it
+    bool resume = true;
+    while ((c = getopt_long(argc, argv, "hj:prz:", opts, &option_index)) !=
+           -1)
+    {
+        switch (c)
+        {
+            case 'j':
+                maxInFlight = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'p':
+                pipeline = true;
+                break;
+            case 'r':
+                resume = true;
+                break;
+            case 'z':
+                compressor = optarg;
+                break;
+            default:
+                usage();
+                return Error;
         }
     }
 
-    catch (const sdbusplus::exception::SdBusError& e)
+    if (argc - optind < 2)
     {
-        std::string errorStr("Function getSwitchEraseStatus failed");
-        log<level::ERR>(errorStr.c_str());
-        log<level::ERR>(e.what());
+        usage();
         return Error;
     }
 
-    return Success;
-}
+    dumpPath = argv[optind];
+    open_report(dumpPath);
+    log_msg(dumpPath);
 
-uint8_t getSwitchDump(uint8_t switchIndex)
-{
-    uint64_t currentRecord = 0;
-    uint64_t segmentsCounter = 0;
-    uint8_t errorCounter = 0;
-    uint16_t busyCounter = 0;
-    uint8_t res;
-    outputFileSize = 0;
-    outputFileName = dumpPath + "/NVSwitch_" + std::to_string(switchIndex) +
-                     "_dump.bin";
-    std::string statusStr = "Started to get the Net_NVSwitch_" +
-                            std::to_string(switchIndex) + " dump";
-    log_msg(statusStr);
-    do
+    if (!compressor.empty())
     {
-        res = InProgress;
-        errorCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT && res != Success)
-        {
-            res = sendRequestRecordCommand(switchIndex, currentRecord,
-                                           DeviceTypeData::NVSwitch);
-            if (res != Success)
-            {
-                sleep(SLEEP_DURING_WAIT);
-                errorCounter++;
-            }
-        }
-        if (res != Success)
-        {
-            break;
-        }
-        res = InProgress;
-        errorCounter = 0;
-        busyCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT &&
-               busyCounter < MAX_IN_PROGRESS_COUNT && res != Success)
-        {
-            res = getRequestRecordCommandStatus(switchIndex,
-                                                DeviceTypeData::NVSwitch);
-            errorCounter += (res == Error);
-            busyCounter += (res == InProgress);
-        }
-        res = InProgress;
-        statusStr = "Getting the Net_NVSwitch_" + std::to_string(switchIndex);
-        if (MAX_ERROR_COUNT == errorCounter)
-        {
-            statusStr += " dump reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        if (MAX_IN_PROGRESS_COUNT == busyCounter)
-        {
-            statusStr += " dump timeout";
-            log_msg(statusStr);
-            break;
-        }
-        if (saveRecord(switchIndex, DeviceTypeData::NVSwitch))
-        {
-            statusStr = "Saving the Net_NVSwitch_" +
-                        std::to_string(switchIndex) + " dump reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        res = Success;
-        segmentsCounter++;
-        currentRecord = getNextRecord(switchIndex, DeviceTypeData::NVSwitch);
-    } while (currentRecord != 0);
-    statusStr = "Total number of segments: " + std::to_string(segmentsCounter);
-    log_msg(statusStr);
-    statusStr = "Output file size: " + std::to_string(outputFileSize);
-    log_msg(statusStr);
-    if (res != Success)
-    {
-        statusStr = "Getting the Net_NVSwitch_" + std::to_string(switchIndex) +
-                    " dump completed with errors";
-        log_msg(statusStr);
-    }
-    else
-    {
-        statusStr = "Getting the Net_NVSwitch_" + std::to_string(switchIndex) +
-                    " dump completed successfully";
-        log_msg(statusStr);
-        statusStr = "Started to erase the Net_NVSwitch_" +
-                    std::to_string(switchIndex) + " dump contents";
-        log_msg(statusStr);
-        res = InProgress;
-        errorCounter = 0;
-        busyCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT &&
-               busyCounter < MAX_IN_PROGRESS_COUNT && res != Success)
-        {
-            res = sendSwitchEraseCommand(switchIndex);
-            errorCounter += (Error == res);
-            if (Success == res)
-            {
-                res = getSwitchEraseStatus(switchIndex);
-                errorCounter += (Error == res);
-                busyCounter += (InProgress == res);
-            }
-        }
-        if (res != Success)
-        {
-            statusStr = "Erasing the Net_NVSwitch_" +
-                        std::to_string(switchIndex) +
-                        " dump completed with errors";
-            log_msg(statusStr);
-        }
-        else
-        {
-            log_msg("Done.");
-        }
+        // A compressor exiting early is reported by the failed writes
+        signal(SIGPIPE, SIG_IGN);
     }
-    return res;
-}
 
-uint8_t getLinkMgmtNICDump()
-{
-    uint64_t currentRecord = 0;
-    uint64_t segmentsCounter = 0;
-    uint8_t errorCounter = 0;
-    uint16_t busyCounter = 0;
-    uint8_t res;
-    outputFileSize = 0;
-    outputFileName = dumpPath + "/NVLinkMgmtNIC_0_dump.bin";
-    std::string statusStr = "Started to get the Net_NVLinkManagementNIC_0 dump";
-    log_msg(statusStr);
-
-    do
-    {
-        res = InProgress;
-        errorCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT && res != Success)
-        {
-            res = sendRequestRecordCommand(0, currentRecord,
-                                           DeviceTypeData::NVLinkMgmtNIC_Dump);
-            if (res != Success)
-            {
-                sleep(SLEEP_DURING_WAIT);
-                errorCounter++;
-            }
-        }
-        if (res != Success)
-        {
-            break;
-        }
-        res = InProgress;
-        errorCounter = 0;
-        busyCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT &&
-               busyCounter < MAX_IN_PROGRESS_COUNT && res != Success)
-        {
-            res = getRequestRecordCommandStatus(
-                0, DeviceTypeData::NVLinkMgmtNIC_Dump);
-            errorCounter += (res == Error);
-            busyCounter += (res == InProgress);
-        }
-        res = InProgress;
-        statusStr = "Getting the Net_NVLinkManagementNIC_0";
-        if (MAX_ERROR_COUNT == errorCounter)
-        {
-            statusStr += " dump reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        if (MAX_IN_PROGRESS_COUNT == busyCounter)
-        {
-            statusStr += " dump timeout";
-            log_msg(statusStr);
-            break;
-        }
-        if (saveRecord(0, DeviceTypeData::NVLinkMgmtNIC_Dump))
-        {
-            statusStr =
-                "Saving the Net_NVLinkManagementNIC_0 dump reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        res = Success;
-        segmentsCounter++;
-        currentRecord = getNextRecord(0, DeviceTypeData::NVLinkMgmtNIC_Dump);
-    } while (currentRecord != 0);
-    statusStr = "Total number of segments: " + std::to_string(segmentsCounter);
-    log_msg(statusStr);
-    statusStr = "Output file size: " + std::to_string(outputFileSize);
-    log_msg(statusStr);
-    if (res != Success)
-    {
-        statusStr =
-            "Getting the Net_NVLinkManagementNIC_0 dump completed with errors";
-        log_msg(statusStr);
-    }
-    else
-    {
-        statusStr =
-            "Getting the Net_NVLinkManagementNIC_0 dump completed successfully";
-        log_msg(statusStr);
-    }
-    return res;
-}
+    auto event = sdeventplus::Event::get_default();
+    auto bus = sdbusplus::bus::new_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
-uint8_t getLinkMgmtNICLog()
-{
-    uint64_t currentRecord = 0;
-    uint64_t segmentsCounter = 0;
-    uint8_t errorCounter = 0;
-    uint16_t busyCounter = 0;
-    uint8_t res;
-    outputFileSize = 0;
-    outputFileName = dumpPath + "/NVLinkMgmtNIC_0_Log.bin";
-    std::string statusStr = "Started to get the Net_NVLinkManagementNIC_0 Log";
-    log_msg(statusStr);
-    do
-    {
-        res = InProgress;
-        errorCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT && res != Success)
-        {
-            res = sendRequestRecordCommand(0, currentRecord,
-                                           DeviceTypeData::NVLinkMgmtNIC_Log);
-            if (res != Success)
-            {
-                sleep(SLEEP_DURING_WAIT);
-                errorCounter++;
-            }
-        }
-        if (res != Success)
-        {
-            break;
-        }
-        res = InProgress;
-        errorCounter = 0;
-        busyCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT &&
-               busyCounter < MAX_IN_PROGRESS_COUNT && res != Success)
-        {
-            res = getRequestRecordCommandStatus(
-                0, DeviceTypeData::NVLinkMgmtNIC_Log);
-            errorCounter += (res == Error);
-            busyCounter += (res == InProgress);
-        }
-        res = InProgress;
-        statusStr = "Getting the Net_NVLinkManagementNIC_0";
-        if (MAX_ERROR_COUNT == errorCounter)
-        {
-            statusStr += " Log reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        if (MAX_IN_PROGRESS_COUNT == busyCounter)
-        {
-            statusStr += " Log timeout";
-            log_msg(statusStr);
-            break;
-        }
-        if (saveRecord(0, DeviceTypeData::NVLinkMgmtNIC_Log))
-        {
-            statusStr =
-                "Saving the Net_NVLinkManagementNIC_0 Log reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        res = Success;
-        segmentsCounter++;
-        currentRecord = getNextRecord(0, DeviceTypeData::NVLinkMgmtNIC_Log);
-    } while (currentRecord != 0);
-    statusStr = "Total number of segments: " + std::to_string(segmentsCounter);
-    log_msg(statusStr);
-    statusStr = "Output file size: " + std::to_string(outputFileSize);
-    log_msg(statusStr);
-    if (res != Success)
-    {
-        statusStr =
-            "Getting the Net_NVLinkManagementNIC_0 Log completed with errors";
-        log_msg(statusStr);
-    }
-    else
+    bool multiple = (argc - optind) > 2;
+    Scheduler scheduler(event, maxInFlight);
+    for (int i = optind + 1; i < argc; i++)
     {
-        statusStr =
-            "Getting the Net_NVLinkManagementNIC_0 Log completed successfully";
-        log_msg(statusStr);
+        log_msg(argv[i]);
+        scheduler.add(makeTarget(bus, event, argv[i], multiple, pipeline,
+                                 compressor, resume));
     }
-    return res;
-}
 
-uint8_t getGPUDump(uint8_t GPUIndex)
-{
-    uint64_t currentRecord = 0;
-    uint64_t segmentsCounter = 0;
-    uint8_t errorCounter = 0;
-    uint16_t busyCounter = 0;
-    uint8_t res;
-    outputFileSize = 0;
-    outputFileName = dumpPath + "/GPU_SXM_" + std::to_string(GPUIndex) +
-                     "_dump.bin";
-    std::string statusStr = "Started to get the Net_GPU_SXM_" +
-                            std::to_string(GPUIndex) + " dump";
-    log_msg(statusStr);
-
-    do
+    using std::chrono::duration_cast;
+    using std::chrono::high_resolution_clock;
+    using std::chrono::milliseconds;
+
+    auto t1 = high_resolution_clock::now();
+
+    scheduler.run();
+
+    uint8_t res_dump = Success;
+    for (const auto& target : scheduler.getTargets())
     {
-        res = InProgress;
-        errorCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT && res != Success)
-        {
-            res = sendRequestRecordCommand(GPUIndex, currentRecord,
-                                           DeviceTypeData::GPU_SXM);
-            if (res != Success)
-            {
-                sleep(SLEEP_DURING_WAIT);
-                errorCounter++;
-            }
-        }
-        if (res != Success)
-        {
-            break;
-        }
-        res = InProgress;
-        errorCounter = 0;
-        busyCounter = 0;
-        while (errorCounter < MAX_ERROR_COUNT &&
-               busyCounter < MAX_IN_PROGRESS_COUNT && res != Success)
-        {
-            res = getRequestRecordCommandStatus(GPUIndex,
-                                                DeviceTypeData::GPU_SXM);
-            errorCounter += (res == Error);
-            busyCounter += (res == InProgress);
-        }
-        res = InProgress;
-        statusStr = "Getting the Net_GPU_SXM_" + std::to_string(GPUIndex);
-        if (MAX_ERROR_COUNT == errorCounter)
+        auto res = target->result.value_or(Error);
+        if (multiple)
         {
-            statusStr += " dump reported errors";
-            log_msg(statusStr);
-            break;
+            log_msg(target->name + ": " +
+                    (Success == res ? "completed successfully"
+                                    : "completed with errors"));
+            log_record({{"event", "target"},
+                        {"target", target->name},
+                        {"result", res}});
         }
-        if (MAX_IN_PROGRESS_COUNT == busyCounter)
+        if (Success != res)
         {
-            statusStr += " dump timeout";
-            log_msg(statusStr);
-            break;
+            res_dump = multiple ? static_cast<uint8_t>(Error) : res;
         }
-        if (saveRecord(GPUIndex, DeviceTypeData::GPU_SXM))
-        {
-            statusStr = "Saving the Net_GPU_SXM_" + std::to_string(GPUIndex) +
-                        " dump reported errors";
-            log_msg(statusStr);
-            break;
-        }
-        res = Success;
-        segmentsCounter++;
-        currentRecord = getNextRecord(GPUIndex, DeviceTypeData::GPU_SXM);
-    } while (currentRecord != 0);
-    statusStr = "Total number of segments: " + std::to_string(segmentsCounter);
-    log_msg(statusStr);
-    statusStr = "Output file size: " + std::to_string(outputFileSize);
-    log_msg(statusStr);
-    if (res != Success)
-    {
-        statusStr = "Getting the Net_GPU_SXM_" + std::to_string(GPUIndex) +
-                    " dump completed with errors";
-        log_msg(statusStr);
     }
-    else
-    {
-        statusStr = "Getting the Net_GPU_SXM_" + std::to_string(GPUIndex) +
-                    " dump completed successfully";
-        log_msg(statusStr);
-    }
-    return res;
-}
-
-int main(int argc, char** argv)
-{
-    uint8_t res_dump = Error;
-
-    if (argc > 2)
-    {
-        dumpPath = argv[1];
-        targetDevice = argv[2];
-        log_msg(dumpPath);
-        log_msg(targetDevice);
-
-        std::string switchStr("Net_NVSwitch_");
 
-        using std::chrono::duration_cast;
-        using std::chrono::high_resolution_clock;
-        using std::chrono::milliseconds;
+    auto t2 = high_resolution_clock::now();
+    auto ms_int = duration_cast<milliseconds>(t2 - t1);
+    int msecs = ms_int.count();
+    int hours = msecs / (60 * 60 * 1000);
+    msecs -= hours * (60 * 60 * 1000);
+    int mins = msecs / (60 * 1000);
+    msecs -= mins * (60 * 1000);
+    int seconds = msecs / 1000;
+    msecs -= (seconds * 1000);
 
-        auto t1 = high_resolution_clock::now();
+    std::string executionTime =
+        "Execution time: " + std::to_string(hours) + " hours, " +
+        std::to_string(mins) + " minutes, " + std::to_string(seconds) +
+        " seconds, " + std::to_string(msecs) + " milliseconds";
+    log_msg(executionTime);
 
-        if (targetDevice.find(switchStr) != std::string::npos)
-        {
-            uint16_t switchIndex =
-                atoi(targetDevice.substr(switchStr.length(), std::string::npos)
-                         .c_str());
-            res_dump = getSwitchDump(switchIndex);
-        }
-        else if ("Net_NVLinkManagementNIC_0" == targetDevice)
-        {
-            res_dump = getLinkMgmtNICDump();
-            getLinkMgmtNICLog();
-        }
-        else
-        {
-            switchStr = "Net_GPU_SXM_";
-            if (targetDevice.find(switchStr) != std::string::npos)
-            {
-                uint16_t GPUIndex = atoi(
-                    targetDevice.substr(switchStr.length(), std::string::npos)
-                        .c_str());
-                res_dump = getGPUDump(GPUIndex);
-            }
-        }
-
-        auto t2 = high_resolution_clock::now();
-        auto ms_int = duration_cast<milliseconds>(t2 - t1);
-        int msecs = ms_int.count();
-        int hours = msecs / (60 * 60 * 1000);
-        msecs -= hours * (60 * 60 * 1000);
-        int mins = msecs / (60 * 1000);
-        msecs -= mins * (60 * 1000);
-        int seconds = msecs / 1000;
-        msecs -= (seconds * 1000);
-
-        std::string executionTime =
-            "Execution time: " + std::to_string(hours) + " hours, " +
-            std::to_string(mins) + " minutes, " + std::to_string(seconds) +
-            " seconds, " + std::to_string(msecs) + " milliseconds";
-        log_msg(executionTime);
-    }
-    else
-    {
-        printf("nsm-net-dump-tool version " VERSION "\n");
-        printf("Usage: nsm-net-dump-tool <temp folder> <target device>\n");
-    }
+    timespec cpuTime{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime);
+    auto cpuMs = cpuTime.tv_sec * 1000 + cpuTime.tv_nsec / 1000000;
+    log_msg("CPU time: " + std::to_string(cpuMs) + " milliseconds");
+    log_record({{"event", "run"},
+                {"result", res_dump},
+                {"targets", scheduler.getTargets().size()},
+                {"duration_ms", ms_int.count()},
+                {"cpu_ms", cpuMs}});
+    flush_report();
 
     return res_dump;
 }
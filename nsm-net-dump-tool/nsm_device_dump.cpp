@@ -0,0 +1,691 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nsm_device_dump.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <system_error>
+#include <variant>
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+constexpr auto NSM_SERVICE = "xyz.openbmc_project.NSM";
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto ERASE_INTERFACE = "com.nvidia.Dump.Erase";
+
+/** @brief Log the failure of a D-Bus step */
+void logFailure(const std::string& step, const char* error)
+{
+    std::string errorStr("Function " + step + " failed");
+    log<level::ERR>(errorStr.c_str());
+    log<level::ERR>(error);
+}
+
+} // namespace
+
+DeviceDump::DeviceDump(sdbusplus::bus_t& bus, const sdeventplus::Event& event,
+                       const std::string& dumpPath, uint8_t index,
+                       DeviceTypeData dataType, bool prefixReport,
+                       bool pipeline, const std::string& compressor,
+                       bool resume) :
+    bus(bus), dumpPath(dumpPath), index(index), dataType(dataType),
+    prefixReport(prefixReport), pipeline(pipeline), compressor(compressor),
+    resume(resume), timer(event, [this](Timer&) {
+    if (timerAction)
+    {
+        timerAction();
+    }
+})
+{
+    noun = "dump";
+    interface = "com.nvidia.Dump.DebugInfo";
+    switch (dataType)
+    {
+        case DeviceTypeData::NVSwitch:
+            target = "Net_NVSwitch_" + std::to_string(index);
+            objectPath = "/xyz/openbmc_project/inventory/system/fabrics/"
+                         "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
+                         std::to_string(index);
+            outputFileName = "/NVSwitch_" + std::to_string(index) +
+                             "_dump.bin";
+            break;
+        case DeviceTypeData::NVLinkMgmtNIC_Dump:
+            target = "Net_NVLinkManagementNIC_0";
+            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
+                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
+                         "NVLinkManagementNIC_0";
+            outputFileName = "/NVLinkMgmtNIC_0_dump.bin";
+            break;
+        case DeviceTypeData::NVLinkMgmtNIC_Log:
+            target = "Net_NVLinkManagementNIC_0";
+            noun = "Log";
+            objectPath = "/xyz/openbmc_project/inventory/system/chassis/"
+                         "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
+                         "NVLinkManagementNIC_0";
+            interface = "com.nvidia.Dump.LogInfo";
+            outputFileName = "/NVLinkMgmtNIC_0_Log.bin";
+            break;
+        case DeviceTypeData::GPU_SXM:
+            target = "Net_GPU_SXM_" + std::to_string(index);
+            objectPath = "/xyz/openbmc_project/inventory/system/"
+                         "processors/GPU_SXM_" +
+                         std::to_string(index);
+            outputFileName = "/GPU_SXM_" + std::to_string(index) +
+                             "_dump.bin";
+            break;
+    }
+    outputFileName = dumpPath + outputFileName;
+    if (compressor.empty())
+    {
+        checkpointFileName = outputFileName + ".ckpt";
+    }
+}
+
+void DeviceDump::report(const std::string& msg) const
+{
+    if (prefixReport)
+    {
+        log_msg("[" + target + "] " + msg);
+    }
+    else
+    {
+        log_msg(msg);
+    }
+}
+
+void DeviceDump::reportRecord(const std::string& event,
+                              nlohmann::json record) const
+{
+    record["event"] = event;
+    record["target"] = target;
+    record["data"] = noun;
+    log_record(std::move(record));
+}
+
+sdbusplus::message_t DeviceDump::newMethodCall(const char* interface,
+                                               const char* method) const
+{
+    return bus.new_method_call(NSM_SERVICE, objectPath.c_str(), interface,
+                               method);
+}
+
+void DeviceDump::start(Callback&& callback)
+{
+    this->callback = std::move(callback);
+    startTime = std::chrono::steady_clock::now();
+    report("Started to get the " + target + " " + noun);
+
+    // Created before the first request, so a Status change racing with the
+    // request reply is not lost.
+    statusMatch = std::make_unique<sdbusplus::bus::match_t>(
+        bus,
+        sdbusplus::bus::match::rules::propertiesChanged(objectPath, interface),
+        [this](sdbusplus::message_t& msg) {
+        if (!waitingStatus)
+        {
+            return;
+        }
+        std::map<std::string, std::variant<std::string, uint64_t>> properties;
+        try
+        {
+            std::string changedInterface;
+            msg.read(changedInterface, properties);
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            logFailure("statusChanged", e.what());
+            return;
+        }
+        auto it = properties.find("Status");
+        if (it != properties.end() &&
+            std::holds_alternative<std::string>(it->second))
+        {
+            handleStatus(std::get<std::string>(it->second), false);
+        }
+    });
+
+    errorCounter = 0;
+    if (loadCheckpoint() && currentRecord == 0)
+    {
+        // Collected by the previous run, only the erase may be left to do
+        finish(Success);
+        return;
+    }
+    sendRequest();
+}
+
+void DeviceDump::sendRequest()
+{
+    auto method = newMethodCall(interface.c_str(),
+                                DeviceTypeData::NVLinkMgmtNIC_Log == dataType
+                                    ? "GetLogInfo"
+                                    : "GetDebugInfo");
+    if (DeviceTypeData::NVLinkMgmtNIC_Log == dataType)
+    {
+        method.append(currentRecord);
+    }
+    else
+    {
+        method.append("com.nvidia.Dump.DebugInfo."
+                      "DebugInformationType.DeviceInformation",
+                      currentRecord);
+    }
+
+    // Armed before the request so the signal of a device answering faster
+    // than the method reply is handled.
+    waitingStatus = true;
+    backoff = std::chrono::milliseconds(POLL_BACKOFF_MIN);
+    requestTime = std::chrono::steady_clock::now();
+    pendingCall.emplace(bus.call_async(
+        method, [this](sdbusplus::message_t reply) { requestDone(reply); }));
+}
+
+void DeviceDump::requestDone(sdbusplus::message_t& reply)
+{
+    if (!reply.is_method_error())
+    {
+        errorCounter = 0;
+        waitStatus();
+        return;
+    }
+
+    logFailure("sendRequestRecordCommand", "method error reply");
+    waitingStatus = false;
+    if (++errorCounter >= MAX_ERROR_COUNT)
+    {
+        finish(Error);
+        return;
+    }
+    timerAction = [this]() { sendRequest(); };
+    timer.restartOnce(std::chrono::seconds(SLEEP_DURING_WAIT));
+}
+
+void DeviceDump::waitStatus()
+{
+    if (!waitingStatus)
+    {
+        // The signal already reported the record ready
+        return;
+    }
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::seconds(STATUS_WAIT_TIMEOUT);
+    timerAction = [this]() { pollStatus(); };
+    timer.restartOnce(backoff);
+}
+
+void DeviceDump::pollStatus()
+{
+    if (std::chrono::steady_clock::now() >= deadline)
+    {
+        waitingStatus = false;
+        report("Getting the " + target + " " + noun + " timeout");
+        finish(InProgress);
+        return;
+    }
+
+    auto method = newMethodCall(PROPERTIES_INTERFACE, "Get");
+    method.append(interface, "Status");
+    pendingPoll.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        if (!waitingStatus)
+        {
+            return;
+        }
+        std::string status;
+        try
+        {
+            if (reply.is_method_error())
+            {
+                throw sdbusplus::exception::SdBusError(
+                    EIO, "Status read failed");
+            }
+            std::variant<std::string> value;
+            reply.read(value);
+            status = std::get<std::string>(value);
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            logFailure("getRequestRecordCommandStatus", e.what());
+        }
+        handleStatus(status, true);
+    }));
+}
+
+void DeviceDump::handleStatus(const std::string& status, bool polled)
+{
+    auto prefix = interface + ".OperationStatus.";
+    if (status == prefix + "Success")
+    {
+        waitingStatus = false;
+        timer.setEnabled(false);
+        pendingPoll.reset();
+        readyTime = std::chrono::steady_clock::now();
+        getRecordFd();
+        return;
+    }
+
+    if (status != prefix + "InProgress")
+    {
+        if (!status.empty())
+        {
+            log<level::ERR>(status.c_str());
+        }
+        if (++errorCounter >= MAX_ERROR_COUNT)
+        {
+            waitingStatus = false;
+            timer.setEnabled(false);
+            pendingPoll.reset();
+            report("Getting the " + target + " " + noun + " reported errors");
+            finish(InProgress);
+            return;
+        }
+    }
+
+    if (polled)
+    {
+        backoff = std::min(backoff * 2,
+                           std::chrono::milliseconds(POLL_BACKOFF_MAX));
+        timer.restartOnce(backoff);
+    }
+}
+
+void DeviceDump::getRecordFd()
+{
+    auto method = newMethodCall(PROPERTIES_INTERFACE, "Get");
+    method.append(interface, "Fd");
+    pendingCall.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        try
+        {
+            if (reply.is_method_error())
+            {
+                throw sdbusplus::exception::SdBusError(EIO,
+                                                       "Fd read failed");
+            }
+            std::variant<sdbusplus::message::unix_fd> response;
+            reply.read(response);
+
+            // The fd is owned by the reply, keep a copy of it so the record
+            // can be saved after the next one is requested.
+            recordFd = dup(std::get<sdbusplus::message::unix_fd>(response));
+            if (recordFd < 0)
+            {
+                throw sdbusplus::exception::SdBusError(errno, "dup");
+            }
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            logFailure("saveRecord", e.what());
+            report("Saving the " + target + " " + noun + " reported errors");
+            finish(InProgress);
+            return;
+        }
+        getNextRecord();
+    }));
+}
+
+void DeviceDump::getNextRecord()
+{
+    auto method = newMethodCall(PROPERTIES_INTERFACE, "Get");
+    method.append(interface, "NextRecordHandle");
+    pendingCall.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        auto record = currentRecord;
+        currentRecord = 0;
+        try
+        {
+            if (reply.is_method_error())
+            {
+                throw sdbusplus::exception::SdBusError(
+                    EIO, "NextRecordHandle read failed");
+            }
+            std::variant<uint64_t> nextRecordHandle;
+            reply.read(nextRecordHandle);
+            currentRecord = std::get<uint64_t>(nextRecordHandle);
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            logFailure("getNextRecord", e.what());
+        }
+
+        // The device prepares the next record while this one is saved. The
+        // next request only takes the record handle, the fd of the current
+        // record stays valid as we hold our own reference to it.
+        auto waitTime = readyTime - requestTime;
+        if (pipeline && currentRecord != 0)
+        {
+            errorCounter = 0;
+            sendRequest();
+        }
+
+        if (!saveRecord(record, waitTime))
+        {
+            report("Saving the " + target + " " + noun + " reported errors");
+            finish(InProgress);
+            return;
+        }
+
+        if (currentRecord == 0)
+        {
+            finish(Success);
+        }
+        else if (!pipeline)
+        {
+            errorCounter = 0;
+            sendRequest();
+        }
+    }));
+}
+
+bool DeviceDump::saveRecord(uint64_t record,
+                            std::chrono::steady_clock::duration waitTime)
+{
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    uint64_t size = 0;
+    bool saved = false;
+    try
+    {
+        // One output for the whole dump, the record data is moved to it in
+        // kernel.
+        if (!output)
+        {
+            output = std::make_unique<OutputSink>(outputFileName, compressor,
+                                                  outputFileSize);
+        }
+        size = output->append(recordFd);
+        saved = true;
+    }
+    catch (const std::system_error& e)
+    {
+        logFailure("saveRecord", e.what());
+    }
+    close(recordFd);
+    recordFd = -1;
+    if (!saved)
+    {
+        return false;
+    }
+
+    outputFileSize += size;
+    segmentsCounter++;
+    writeCheckpoint(record);
+
+    auto waitMs = duration_cast<milliseconds>(waitTime).count();
+    auto saveMs = duration_cast<milliseconds>(steady_clock::now() - start)
+                      .count();
+    report("Segment " + std::to_string(segmentsCounter) + ": record " +
+           std::to_string(record) + ", " + std::to_string(size) +
+           " bytes, wait " + std::to_string(waitMs) + " ms, save " +
+           std::to_string(saveMs) + " ms");
+    reportRecord("segment", {{"segment", segmentsCounter},
+                             {"record", record},
+                             {"bytes", size},
+                             {"wait_ms", waitMs},
+                             {"save_ms", saveMs}});
+    // The manager may kill the run on a timeout, the last segments show
+    // where it stopped
+    flush_report();
+    return true;
+}
+
+bool DeviceDump::loadCheckpoint()
+{
+    if (!resume || checkpointFileName.empty())
+    {
+        return false;
+    }
+
+    std::ifstream checkpoint(checkpointFileName);
+    std::map<std::string, uint64_t> values;
+    std::string line;
+    while (std::getline(checkpoint, line))
+    {
+        auto pos = line.find('=');
+        if (pos != std::string::npos)
+        {
+            values[line.substr(0, pos)] =
+                std::strtoull(line.c_str() + pos + 1, nullptr, 10);
+        }
+    }
+    if (!values.contains("next") || !values.contains("offset") ||
+        !values.contains("segments"))
+    {
+        return false;
+    }
+
+    // The output may have been removed or cut short since
+    std::error_code ec;
+    auto size = std::filesystem::file_size(outputFileName, ec);
+    if (ec || size < values["offset"])
+    {
+        report("Ignoring the checkpoint of the " + target + " " + noun);
+        return false;
+    }
+
+    currentRecord = values["next"];
+    outputFileSize = values["offset"];
+    segmentsCounter = values["segments"];
+    report("Resuming the " + target + " " + noun + " at record " +
+           std::to_string(currentRecord) + ", segment " +
+           std::to_string(segmentsCounter + 1) + ", offset " +
+           std::to_string(outputFileSize));
+    reportRecord("resume", {{"record", currentRecord},
+                            {"segments", segmentsCounter},
+                            {"bytes", outputFileSize}});
+    return true;
+}
+
+void DeviceDump::writeCheckpoint(uint64_t record) const
+{
+    if (checkpointFileName.empty())
+    {
+        return;
+    }
+
+    // Replaced in one go, a run killed while writing it leaves the previous
+    // checkpoint behind.
+    auto tmpFileName = checkpointFileName + ".tmp";
+    {
+        std::ofstream checkpoint(tmpFileName, std::ios::trunc);
+        checkpoint << "record=" << record << "\n"
+                   << "next=" << currentRecord << "\n"
+                   << "offset=" << outputFileSize << "\n"
+                   << "segments=" << segmentsCounter << "\n";
+        if (!checkpoint.flush())
+        {
+            log<level::ERR>("Failed to write the checkpoint");
+            return;
+        }
+    }
+    if (std::rename(tmpFileName.c_str(), checkpointFileName.c_str()) < 0)
+    {
+        logFailure("writeCheckpoint", strerror(errno));
+    }
+}
+
+void DeviceDump::removeCheckpoint() const
+{
+    if (!checkpointFileName.empty())
+    {
+        std::remove(checkpointFileName.c_str());
+    }
+}
+
+void DeviceDump::sendErase()
+{
+    auto method = newMethodCall(ERASE_INTERFACE, "EraseDebugInfo");
+    method.append("com.nvidia.Dump.Erase.EraseInfoType.FWSavedDumpInfo");
+    pendingCall.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        if (reply.is_method_error())
+        {
+            logFailure("sendSwitchEraseCommand", "method error reply");
+            errorCounter++;
+        }
+        else
+        {
+            getEraseStatus();
+            return;
+        }
+        if (errorCounter < MAX_ERROR_COUNT)
+        {
+            sendErase();
+            return;
+        }
+        report("Erasing the " + target + " dump completed with errors");
+        reportRecord("erase", {{"result", Error}});
+        flush_report();
+        callback(Error);
+    }));
+}
+
+void DeviceDump::getEraseStatus()
+{
+    auto method = newMethodCall(PROPERTIES_INTERFACE, "Get");
+    method.append(ERASE_INTERFACE, "EraseDebugInfoStatus");
+    pendingCall.emplace(
+        bus.call_async(method, [this](sdbusplus::message_t reply) {
+        uint8_t res = Error;
+        try
+        {
+            if (reply.is_method_error())
+            {
+                throw sdbusplus::exception::SdBusError(
+                    EIO, "EraseDebugInfoStatus read failed");
+            }
+            std::variant<std::tuple<std::string, std::string>> response;
+            reply.read(response);
+            auto& [eraseReason, eraseStatus] =
+                std::get<std::tuple<std::string, std::string>>(response);
+            if (eraseReason != "com.nvidia.Dump.Erase.OperationStatus.Success")
+            {
+                log<level::ERR>(eraseReason.c_str());
+            }
+            else if (eraseStatus ==
+                     "com.nvidia.Dump.Erase.EraseStatus.DataEraseInProgress")
+            {
+                res = InProgress;
+            }
+            else if (eraseStatus ==
+                     "com.nvidia.Dump.Erase.EraseStatus.DataErased")
+            {
+                res = Success;
+            }
+            else
+            {
+                log<level::ERR>(eraseStatus.c_str());
+            }
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            logFailure("getSwitchEraseStatus", e.what());
+        }
+
+        if (Success == res)
+        {
+            report("Done.");
+            reportRecord("erase", {{"result", Success}});
+            flush_report();
+            callback(Success);
+            return;
+        }
+        errorCounter += (Error == res);
+        busyCounter += (InProgress == res);
+        if (errorCounter >= MAX_ERROR_COUNT ||
+            busyCounter >= MAX_IN_PROGRESS_COUNT)
+        {
+            report("Erasing the " + target + " dump completed with errors");
+            reportRecord("erase", {{"result", res}});
+            flush_report();
+            callback(res);
+            return;
+        }
+        if (InProgress == res)
+        {
+            timerAction = [this]() { sendErase(); };
+            timer.restartOnce(backoff);
+            backoff = std::min(backoff * 2,
+                               std::chrono::milliseconds(POLL_BACKOFF_MAX));
+            return;
+        }
+        sendErase();
+    }));
+}
+
+void DeviceDump::finish(uint8_t res)
+{
+    // Drop whatever is still outstanding, e.g. a pipelined request
+    waitingStatus = false;
+    timer.setEnabled(false);
+    pendingCall.reset();
+    pendingPoll.reset();
+    if (recordFd >= 0)
+    {
+        close(recordFd);
+        recordFd = -1;
+    }
+    statusMatch.reset();
+    nlohmann::json record;
+    if (output)
+    {
+        if (!output->close())
+        {
+            log<level::ERR>("Output compressor failed");
+            res = Error;
+        }
+        if (!compressor.empty())
+        {
+            report("Compressed file size: " +
+                   std::to_string(output->getFileSize()));
+            record["compressed_bytes"] = output->getFileSize();
+        }
+    }
+    report("Total number of segments: " + std::to_string(segmentsCounter));
+    report("Output file size: " + std::to_string(outputFileSize));
+    record["result"] = res;
+    record["segments"] = segmentsCounter;
+    record["bytes"] = outputFileSize;
+    record["duration_ms"] =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count();
+    reportRecord("collection", std::move(record));
+    if (res != Success)
+    {
+        report("Getting the " + target + " " + noun +
+               " completed with errors");
+        flush_report();
+        callback(res);
+        return;
+    }
+
+    report("Getting the " + target + " " + noun + " completed successfully");
+    if (DeviceTypeData::NVSwitch != dataType)
+    {
+        flush_report();
+        callback(Success);
+        return;
+    }
+
+    report("Started to erase the " + target + " dump contents");
+    errorCounter = 0;
+    busyCounter = 0;
+    backoff = std::chrono::milliseconds(POLL_BACKOFF_MIN);
+    sendErase();
+}
@@ -0,0 +1,246 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "output_sink.hpp"
+#include "report.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/slot.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+#include <string>
+
+#define MAX_IN_PROGRESS_COUNT 1000
+#define MAX_ERROR_COUNT 3
+#define SLEEP_DURING_WAIT 20
+/* Deadline for a record to be prepared by the device, in seconds */
+#define STATUS_WAIT_TIMEOUT 300
+/* Status polling backoff used when no PropertiesChanged signal arrives,
+ * in milliseconds */
+#define POLL_BACKOFF_MIN 10
+#define POLL_BACKOFF_MAX 1000
+
+enum OperationStatus
+{
+    Success,
+    InProgress,
+    Error,
+};
+
+enum class DeviceTypeData
+{
+    NVSwitch,
+    NVLinkMgmtNIC_Dump,
+    NVLinkMgmtNIC_Log,
+    GPU_SXM,
+};
+
+/**
+ * @class DeviceDump
+ * @brief Collects the records of one device through the NSM service.
+ *
+ * @details The collection is a state machine driven by the event loop the
+ *  shared bus is attached to, so several devices can be collected
+ *  concurrently by one process:
+ *  request record -> wait for Status -> get Fd -> read NextRecordHandle ->
+ *  save, repeated until the next record handle is 0, followed by the erase
+ *  of the device copy for NVSwitches. When pipelining, the next record is
+ *  requested before the current one is saved so the device and the BMC
+ *  work at the same time. The saved descriptor shares the file of the
+ *  device service, so pipelining is only safe when the service does not
+ *  rewrite a record file for the next request, it is off by default.
+ *
+ *  Status changes are received through a PropertiesChanged match. The
+ *  property is also polled with an exponential backoff in case the signal
+ *  is not emitted.
+ */
+class DeviceDump
+{
+  public:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+    using Callback = std::function<void(uint8_t)>;
+
+    DeviceDump() = delete;
+    DeviceDump(const DeviceDump&) = delete;
+    DeviceDump& operator=(const DeviceDump&) = delete;
+    DeviceDump(DeviceDump&&) = delete;
+    DeviceDump& operator=(DeviceDump&&) = delete;
+    ~DeviceDump()
+    {
+        if (recordFd >= 0)
+        {
+            close(recordFd);
+        }
+    }
+
+    /** @brief Constructor
+     *  @param[in] bus - bus connection shared by all the devices.
+     *  @param[in] event - event loop the bus is attached to.
+     *  @param[in] dumpPath - directory the output file is written to.
+     *  @param[in] index - device index.
+     *  @param[in] dataType - kind of record collected from the device.
+     *  @param[in] prefixReport - prefix the report lines with the device
+     *                            name, used when devices run concurrently.
+     *  @param[in] pipeline - request the next record before saving the
+     *                        current one.
+     *  @param[in] compressor - compressor the output is streamed through,
+     *                          empty for none.
+     *  @param[in] resume - continue from the checkpoint of a previous run.
+     */
+    DeviceDump(sdbusplus::bus_t& bus, const sdeventplus::Event& event,
+               const std::string& dumpPath, uint8_t index,
+               DeviceTypeData dataType, bool prefixReport, bool pipeline,
+               const std::string& compressor, bool resume);
+
+    /** @brief Start the collection
+     *  @param[in] callback - called with the result once done.
+     */
+    void start(Callback&& callback);
+
+    /** @brief Target device name, e.g. Net_NVSwitch_0 */
+    const std::string& getTarget() const
+    {
+        return target;
+    }
+
+    /** @brief Remove the checkpoint, once the whole target is collected */
+    void removeCheckpoint() const;
+
+  private:
+    /** @brief Add a line to the execution report */
+    void report(const std::string& msg) const;
+
+    /** @brief Add a record about this collection to the execution report
+     *  @param[in] event - kind of record, e.g. segment.
+     *  @param[in] record - fields of the record.
+     */
+    void reportRecord(const std::string& event, nlohmann::json record) const;
+
+    /** @brief Create a method call on the device object */
+    sdbusplus::message_t newMethodCall(const char* interface,
+                                       const char* method) const;
+
+    /** @brief Request the current record */
+    void sendRequest();
+
+    /** @brief Handle the reply to the record request */
+    void requestDone(sdbusplus::message_t& reply);
+
+    /** @brief Start waiting for the requested record */
+    void waitStatus();
+
+    /** @brief Read the Status property, used when no signal was seen */
+    void pollStatus();
+
+    /** @brief Handle a Status value, from a signal or a poll */
+    void handleStatus(const std::string& status, bool polled);
+
+    /** @brief Get the fd holding the data of the ready record */
+    void getRecordFd();
+
+    /** @brief Read the handle of the next record, request it and save the
+     *         current one.
+     */
+    void getNextRecord();
+
+    /** @brief Append the data of the current record to the output file
+     *  @param[in] record - handle of the record.
+     *  @param[in] waitTime - time the device took to prepare the record.
+     *  @return false on failure.
+     */
+    bool saveRecord(uint64_t record,
+                    std::chrono::steady_clock::duration waitTime);
+
+    /** @brief Restore the progress saved by a previous run
+     *  @return true if there is something to resume from.
+     */
+    bool loadCheckpoint();
+
+    /** @brief Save the progress after a segment is saved */
+    void writeCheckpoint(uint64_t record) const;
+
+    /** @brief Erase the dump stored on the device, NVSwitch only */
+    void sendErase();
+
+    /** @brief Read the erase status */
+    void getEraseStatus();
+
+    /** @brief Report the final result and call the completion callback */
+    void finish(uint8_t res);
+
+    sdbusplus::bus_t& bus;
+    std::string dumpPath;
+    uint8_t index;
+    DeviceTypeData dataType;
+    bool prefixReport;
+    bool pipeline;
+    std::string compressor;
+    bool resume;
+
+    /** @brief Target device name */
+    std::string target;
+
+    /** @brief "dump" or "Log" */
+    std::string noun;
+
+    std::string objectPath;
+    std::string interface;
+    std::string outputFileName;
+    uint64_t outputFileSize = 0;
+
+    /** @brief Output of the dump, opened on the first segment */
+    std::unique_ptr<OutputSink> output;
+
+    /** @brief Progress of the collection, beside the output file. Not kept
+     *         when compressing, a compressed stream cannot be resumed. */
+    std::string checkpointFileName;
+
+    uint64_t currentRecord = 0;
+    uint64_t segmentsCounter = 0;
+    uint8_t errorCounter = 0;
+    uint16_t busyCounter = 0;
+
+    /** @brief Set while waiting for the Status of a requested record */
+    bool waitingStatus = false;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::milliseconds backoff{POLL_BACKOFF_MIN};
+
+    /** @brief Collection timing */
+    std::chrono::steady_clock::time_point startTime;
+
+    /** @brief Segment timing, from request to ready */
+    std::chrono::steady_clock::time_point requestTime;
+    std::chrono::steady_clock::time_point readyTime;
+
+    /** @brief Our reference to the fd of the ready record */
+    int recordFd = -1;
+
+    Callback callback;
+
+    /** @brief Pending method call of the current step */
+    std::optional<sdbusplus::slot_t> pendingCall;
+
+    /** @brief Pending Status poll */
+    std::optional<sdbusplus::slot_t> pendingPoll;
+
+    /** @brief Retry, polling and backoff timer */
+    Timer timer;
+
+    /** @brief Timer action */
+    std::function<void()> timerAction;
+
+    std::unique_ptr<sdbusplus::bus::match_t> statusMatch;
+};
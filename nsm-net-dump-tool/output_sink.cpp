@@ -0,0 +1,248 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "output_sink.hpp"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+#include <vector>
+
+extern char** environ;
+
+namespace
+{
+
+/* Bytes moved per copy call, bounds the time spent in the kernel */
+constexpr size_t chunkSize = 1024 * 1024;
+
+/* Size of the compressor stdin pipe */
+constexpr int pipeSize = 1024 * 1024;
+
+struct Compressor
+{
+    std::vector<const char*> argv;
+    const char* extension;
+};
+
+/** @brief Command line and file extension of a supported compressor */
+Compressor getCompressor(const std::string& name)
+{
+    if (name == "zstd")
+    {
+        return {{"zstd", "-q", "-c", "-3", nullptr}, ".zst"};
+    }
+    if (name == "xz")
+    {
+        return {{"xz", "-c", "-1", nullptr}, ".xz"};
+    }
+    if (name == "gzip")
+    {
+        return {{"gzip", "-c", "-1", nullptr}, ".gz"};
+    }
+    throw std::system_error(EINVAL, std::generic_category(),
+                            "Unsupported compressor " + name);
+}
+
+/** @brief errno values telling a copy method does not apply to the fds */
+bool unsupported(int error)
+{
+    return error == EINVAL || error == EXDEV || error == ENOSYS ||
+           error == EOPNOTSUPP || error == EBADF || error == ESPIPE;
+}
+
+} // namespace
+
+OutputSink::OutputSink(const std::string& path, const std::string& compressor,
+                       uint64_t offset) :
+    path(path)
+{
+    std::vector<const char*> argv;
+    if (!compressor.empty())
+    {
+        auto [args, extension] = getCompressor(compressor);
+        argv = std::move(args);
+        this->path += extension;
+    }
+
+    if (!argv.empty())
+    {
+        offset = 0;
+    }
+
+    // No O_APPEND, copy_file_range() rejects it. We are the only writer and
+    // the file offset follows the data.
+    fileFd = open(this->path.c_str(),
+                  O_WRONLY | O_CREAT | O_CLOEXEC | (offset ? 0 : O_TRUNC),
+                  0644);
+    if (fileFd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), this->path);
+    }
+    if (offset &&
+        (ftruncate(fileFd, offset) < 0 || lseek(fileFd, offset, SEEK_SET) < 0))
+    {
+        auto error = errno;
+        ::close(fileFd);
+        throw std::system_error(error, std::generic_category(), this->path);
+    }
+    writeFd = fileFd;
+    if (argv.empty())
+    {
+        return;
+    }
+
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) < 0)
+    {
+        auto error = errno;
+        ::close(fileFd);
+        throw std::system_error(error, std::generic_category(), "pipe2");
+    }
+    // Best effort, a bigger pipe means fewer wake ups of the compressor
+    fcntl(pipeFds[1], F_SETPIPE_SZ, pipeSize);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipeFds[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fileFd, STDOUT_FILENO);
+    auto error = posix_spawnp(&compressorPid, argv[0], &actions, nullptr,
+                              const_cast<char* const*>(argv.data()), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(pipeFds[0]);
+    if (error != 0)
+    {
+        ::close(pipeFds[1]);
+        ::close(fileFd);
+        unlink(this->path.c_str());
+        compressorPid = -1;
+        throw std::system_error(error, std::generic_category(), argv[0]);
+    }
+    writeFd = pipeFds[1];
+}
+
+OutputSink::~OutputSink()
+{
+    close();
+}
+
+ssize_t OutputSink::transfer(int fd)
+{
+    while (true)
+    {
+        ssize_t n;
+        if (!noCopyFileRange && writeFd == fileFd)
+        {
+            n = copy_file_range(fd, nullptr, fileFd, nullptr, chunkSize, 0);
+            if (n < 0 && unsupported(errno))
+            {
+                noCopyFileRange = true;
+                continue;
+            }
+        }
+        else if (!noSendfile)
+        {
+            // Any fd the data can be mapped from, to a file or a pipe
+            n = sendfile(writeFd, fd, nullptr, chunkSize);
+            if (n < 0 && unsupported(errno))
+            {
+                noSendfile = true;
+                continue;
+            }
+        }
+        else
+        {
+            // Works when either end is a pipe, else copy through user space
+            n = splice(fd, nullptr, writeFd, nullptr, chunkSize, 0);
+            if (n < 0 && unsupported(errno))
+            {
+                char buffer[64 * 1024];
+                n = read(fd, buffer, sizeof(buffer));
+                for (ssize_t done = 0; done < n;)
+                {
+                    auto written = write(writeFd, buffer + done, n - done);
+                    if (written < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+                        return -1;
+                    }
+                    done += written;
+                }
+            }
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return n;
+    }
+}
+
+uint64_t OutputSink::append(int fd)
+{
+    if (writeFd < 0)
+    {
+        throw std::system_error(EBADF, std::generic_category(), path);
+    }
+
+    // The source may be of another kind than the previous one
+    noCopyFileRange = false;
+    noSendfile = false;
+
+    uint64_t size = 0;
+    ssize_t n;
+    while ((n = transfer(fd)) > 0)
+    {
+        size += n;
+    }
+    if (n < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    return size;
+}
+
+bool OutputSink::close()
+{
+    bool ok = true;
+    if (writeFd >= 0 && writeFd != fileFd)
+    {
+        ::close(writeFd);
+    }
+    writeFd = -1;
+    if (compressorPid > 0)
+    {
+        int status = 0;
+        while (waitpid(compressorPid, &status, 0) < 0 && errno == EINTR)
+        {}
+        ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        compressorPid = -1;
+    }
+    if (fileFd >= 0)
+    {
+        ::close(fileFd);
+        fileFd = -1;
+    }
+    return ok;
+}
+
+uint64_t OutputSink::getFileSize() const
+{
+    struct stat st{};
+    if (stat(path.c_str(), &st) < 0)
+    {
+        return 0;
+    }
+    return st.st_size;
+}
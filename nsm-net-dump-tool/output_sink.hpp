@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @class OutputSink
+ * @brief Output file of one device dump, kept open for the whole dump.
+ *
+ * @details Record data is moved from the fd handed out by the NSM service
+ *  to the output with copy_file_range(), sendfile() or splice(), so it does
+ *  not go through a user space buffer. When a compressor is configured the
+ *  data is streamed through it, the compressor writing the output file, so
+ *  the uncompressed dump never hits the flash.
+ */
+class OutputSink
+{
+  public:
+    OutputSink() = delete;
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    OutputSink(OutputSink&&) = delete;
+    OutputSink& operator=(OutputSink&&) = delete;
+
+    /** @brief Constructor, creates the output file
+     *  @param[in] path - output file path, without compressor extension.
+     *  @param[in] compressor - compressor command (zstd, xz or gzip), empty
+     *                          to store the data as is.
+     *  @param[in] offset - size of the data kept from an interrupted run,
+     *                      anything after it is dropped. Only used without
+     *                      compressor.
+     *  @throws std::system_error on failure.
+     */
+    OutputSink(const std::string& path, const std::string& compressor,
+               uint64_t offset = 0);
+
+    ~OutputSink();
+
+    /** @brief Append everything readable from fd to the output
+     *  @param[in] fd - file descriptor to read from, from its current
+     *                  offset up to end of file.
+     *  @return number of bytes appended.
+     *  @throws std::system_error on failure.
+     */
+    uint64_t append(int fd);
+
+    /** @brief Flush the compressor and close the output
+     *  @return false if the compressor failed.
+     */
+    bool close();
+
+    /** @brief Path of the output file, with compressor extension */
+    const std::string& getPath() const
+    {
+        return path;
+    }
+
+    /** @brief Size of the output file, compressed size if compressing */
+    uint64_t getFileSize() const;
+
+  private:
+    /** @brief Move bytes from fd to the output, in kernel if possible */
+    ssize_t transfer(int fd);
+
+    std::string path;
+
+    /** @brief Output file */
+    int fileFd = -1;
+
+    /** @brief Where the data is written: the output file or the
+     *         compressor stdin pipe */
+    int writeFd = -1;
+
+    /** @brief Compressor process */
+    pid_t compressorPid = -1;
+
+    /** @brief Kernel copy methods found unusable for the current fd pair */
+    bool noCopyFileRange = false;
+    bool noSendfile = false;
+};
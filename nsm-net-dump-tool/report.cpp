@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "report.hpp"
+
+#include <chrono>
+#include <fstream>
+
+namespace
+{
+
+/* Enough for the lines written between two segments of a collection */
+constexpr size_t bufferSize = 64 * 1024;
+
+struct Report
+{
+    char textBuffer[bufferSize];
+    char jsonBuffer[bufferSize];
+    std::ofstream text;
+    std::ofstream json;
+};
+
+Report report;
+
+} // namespace
+
+void open_report(const std::string& dir)
+{
+    // The buffer must be set before the file is opened to be used
+    report.text.rdbuf()->pubsetbuf(report.textBuffer, bufferSize);
+    report.text.open(dir + "/Execution_Report.txt", std::ios::app);
+    report.json.rdbuf()->pubsetbuf(report.jsonBuffer, bufferSize);
+    report.json.open(dir + "/Execution_Report.jsonl", std::ios::app);
+}
+
+void log_msg(std::string msg)
+{
+    if (report.text.is_open())
+    {
+        report.text << msg << '\n';
+    }
+}
+
+void log_record(nlohmann::json record)
+{
+    if (!report.json.is_open())
+    {
+        return;
+    }
+    using namespace std::chrono;
+    record["time_ms"] =
+        duration_cast<milliseconds>(system_clock::now().time_since_epoch())
+            .count();
+    report.json << record.dump(-1, ' ', false,
+                               nlohmann::json::error_handler_t::replace)
+                << '\n';
+}
+
+void flush_report()
+{
+    report.text.flush();
+    report.json.flush();
+}
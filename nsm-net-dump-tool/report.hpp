@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+/**
+ * The execution report of a run is made of Execution_Report.txt, the lines
+ * meant to be read, and Execution_Report.jsonl, one JSON record per line
+ * with a timestamp, for the segments, collections and the run itself.
+ * Both files are kept open and buffered for the whole run, and are flushed
+ * after each segment, whenever a collection ends and when the run ends, so
+ * a run killed on a timeout still shows where it stopped.
+ */
+
+/** @brief Open the execution report files of the run
+ *  @param[in] dir - directory the reports are written to.
+ */
+void open_report(const std::string& dir);
+
+/** @brief Appends a line to the execution report of the run */
+void log_msg(std::string msg);
+
+/** @brief Appends a structured record to the execution report of the run,
+ *         the time is added to it.
+ */
+void log_record(nlohmann::json record);
+
+/** @brief Write the buffered report to the files */
+void flush_report();
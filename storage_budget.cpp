@@ -0,0 +1,236 @@
+#include "config.h"
+
+#include "storage_budget.hpp"
+
+#include <linux/magic.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+
+#include <algorithm>
+#include <phosphor-logging/lg2.hpp>
+
+namespace phosphor
+{
+namespace dump
+{
+
+namespace
+{
+
+// Not in linux/magic.h
+constexpr auto UBIFS_SUPER_MAGIC = 0x24051905;
+
+// jffs2 writes the data in nodes of a page at most, each with a
+// struct jffs2_raw_inode header
+constexpr uint64_t JFFS2_NODE_DATA = 4096;
+constexpr uint64_t JFFS2_NODE_HEADER = 68;
+
+} // namespace
+
+size_t directorySize(const std::filesystem::path& dir)
+{
+    size_t size = 0;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator();
+         it.increment(ec))
+    {
+        std::error_code fileEc;
+        if (it->is_regular_file(fileEc))
+        {
+            auto fileSize = it->file_size(fileEc);
+            if (!fileEc)
+            {
+                size += (fileSize + 1023) / 1024;
+            }
+        }
+    }
+    return size;
+}
+
+size_t filesystemFree(const std::filesystem::path& path)
+{
+    struct statfs st{};
+    if (statfs(path.c_str(), &st) != 0)
+    {
+        lg2::error("Failed to check available space, PATH: {PATH}, "
+                   "ERRNO: {ERRNO}",
+                   "PATH", path, "ERRNO", errno);
+        return 0;
+    }
+
+    uint64_t available = static_cast<uint64_t>(st.f_bavail) * st.f_bsize;
+    switch (st.f_type)
+    {
+        case JFFS2_SUPER_MAGIC:
+        {
+            // jffs2 counts the obsoleted nodes as available while the
+            // garbage collector can not reclaim all of them on a partition
+            // close to full, keep a share of the capacity for it
+            uint64_t capacity = static_cast<uint64_t>(st.f_blocks) *
+                                st.f_bsize;
+            uint64_t offset =
+                capacity *
+                JFFS_SPACE_CALC_INACCURACY_OFFSET_WORKAROUND_PERCENT / 100;
+            available = available > offset ? available - offset : 0;
+            available = available / (JFFS2_NODE_DATA + JFFS2_NODE_HEADER) *
+                        JFFS2_NODE_DATA;
+            break;
+        }
+        case UBIFS_SUPER_MAGIC:
+            // ubifs already leaves out the space its index and garbage
+            // collector may need
+            break;
+        case EXT4_SUPER_MAGIC:
+            // f_bavail leaves out the blocks reserved to root, but ext4 has
+            // a fixed number of inodes
+            if (st.f_ffree == 0)
+            {
+                available = 0;
+            }
+            break;
+        default:
+            break;
+    }
+    return available / 1024;
+}
+
+std::vector<uint32_t>
+    selectEvictions(const std::vector<std::pair<uint32_t, size_t>>& sizes,
+                    size_t neededKb)
+{
+    std::vector<uint32_t> victims;
+    size_t freed = 0;
+    for (const auto& [entryId, size] : sizes)
+    {
+        if (freed >= neededKb)
+        {
+            break;
+        }
+        victims.push_back(entryId);
+        freed += size;
+    }
+    return victims;
+}
+
+StoragePool::StoragePool(StorageBudget& budget, const std::string& name,
+                         const std::filesystem::path& dir, size_t totalKb,
+                         size_t maxKb) :
+    budget(budget), name(name), dir(dir), totalKb(totalKb), predictedKb(maxKb)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    struct stat st{};
+    if (stat(dir.c_str(), &st) == 0)
+    {
+        device = st.st_dev;
+    }
+}
+
+size_t StoragePool::usage() const
+{
+    return directorySize(dir);
+}
+
+size_t StoragePool::outstanding() const
+{
+    size_t size = 0;
+    for (const auto& [entryId, reserved] : reservations)
+    {
+        auto written = directorySize(dir / std::to_string(entryId));
+        if (reserved > written)
+        {
+            size += reserved - written;
+        }
+    }
+    return size;
+}
+
+size_t StoragePool::available() const
+{
+    auto committed = usage() + outstanding();
+    size_t quota = totalKb > committed ? totalKb - committed : 0;
+
+    auto free = filesystemFree(dir);
+    auto reserved = budget.outstanding(device);
+    free = free > reserved ? free - reserved : 0;
+
+    return std::min(quota, free);
+}
+
+size_t StoragePool::shortfall(size_t neededKb) const
+{
+    auto committed = usage() + outstanding() + neededKb;
+    size_t quota = committed > totalKb ? committed - totalKb : 0;
+
+    // The reservations of the other pools on the filesystem are left out,
+    // the dumps of this pool are not the ones to free space for them
+    auto reserved = outstanding() + neededKb;
+    auto free = filesystemFree(dir);
+    size_t full = reserved > free ? reserved - free : 0;
+
+    return std::max(quota, full);
+}
+
+size_t StoragePool::reserve(uint32_t entryId, size_t allowedKb)
+{
+    auto size = std::min(predictedKb, allowedKb);
+    reservations[entryId] = size;
+    return size;
+}
+
+void StoragePool::settle(uint32_t entryId)
+{
+    auto it = reservations.find(entryId);
+    if (it == reservations.end())
+    {
+        return;
+    }
+    reservations.erase(it);
+
+    // Lean towards the larger dumps, a reservation too small is what
+    // overcommits the partition
+    auto written = directorySize(dir / std::to_string(entryId));
+    if (written > 0)
+    {
+        predictedKb = std::max(written, (predictedKb * 3 + written) / 4);
+    }
+    lg2::debug("Dump storage settled, POOL: {POOL}, ID: {ID}, SIZE: {SIZE}, "
+               "PREDICTED: {PREDICTED}",
+               "POOL", name, "ID", entryId, "SIZE", written, "PREDICTED",
+               predictedKb);
+}
+
+StorageBudget& StorageBudget::instance()
+{
+    static StorageBudget budget;
+    return budget;
+}
+
+StoragePool& StorageBudget::addPool(const std::string& name,
+                                    const std::filesystem::path& dir,
+                                    size_t totalKb, size_t maxKb)
+{
+    auto& pool = pools[name];
+    if (!pool)
+    {
+        pool = std::make_unique<StoragePool>(*this, name, dir, totalKb, maxKb);
+    }
+    return *pool;
+}
+
+size_t StorageBudget::outstanding(dev_t device) const
+{
+    size_t size = 0;
+    for (const auto& [name, pool] : pools)
+    {
+        if (pool->device == device)
+        {
+            size += pool->outstanding();
+        }
+    }
+    return size;
+}
+
+} // namespace dump
+} // namespace phosphor
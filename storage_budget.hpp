@@ -0,0 +1,169 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace dump
+{
+
+class StorageBudget;
+
+/** @brief Size of the files under a directory, in kilobytes, 0 if it can not
+ *         be read.
+ */
+size_t directorySize(const std::filesystem::path& dir);
+
+/** @brief Space a new file can use on the filesystem of a path, in
+ *         kilobytes.
+ *  @details Accounts for the overhead of jffs2, ubifs and ext4 on top of what
+ *           statfs() reports as available.
+ */
+size_t filesystemFree(const std::filesystem::path& path);
+
+/** @brief Oldest dumps to delete to free some space
+ *  @param[in] sizes - Entry ids and sizes in kilobytes of the dumps, the
+ *                     oldest first.
+ *  @param[in] neededKb - Space to free in kilobytes.
+ *
+ *  @returns ids of the dumps to delete, all of them if they do not free
+ *           enough
+ */
+std::vector<uint32_t>
+    selectEvictions(const std::vector<std::pair<uint32_t, size_t>>& sizes,
+                    size_t neededKb);
+
+/** @class StoragePool
+ *
+ *  @brief Dump directory of a manager in the storage budget.
+ *
+ *  The manager reserves space for a dump when it is requested and settles
+ *  the reservation once the collector exited, so that dumps in flight are
+ *  accounted for by the other requests, of this manager and of the managers
+ *  writing to the same filesystem.
+ */
+class StoragePool
+{
+  public:
+    StoragePool() = delete;
+    StoragePool(const StoragePool&) = delete;
+    StoragePool& operator=(const StoragePool&) = delete;
+    StoragePool(StoragePool&&) = delete;
+    StoragePool& operator=(StoragePool&&) = delete;
+    ~StoragePool() = default;
+
+    /** @brief Constructor
+     *  @param[in] budget - Budget the pool is part of.
+     *  @param[in] name - Name of the pool in the logs.
+     *  @param[in] dir - Dump directory, one subdirectory per entry id.
+     *  @param[in] totalKb - Space all the dumps of the pool may use.
+     *  @param[in] maxKb - Size of a dump before any was settled.
+     */
+    StoragePool(StorageBudget& budget, const std::string& name,
+                const std::filesystem::path& dir, size_t totalKb,
+                size_t maxKb);
+
+    /** @brief Space left for a new dump in kilobytes, within the pool total
+     *         and the filesystem free space, less the reservations.
+     */
+    size_t available() const;
+
+    /** @brief Space to free for available() to reach a size, in kilobytes
+     *  @details Unlike available(), tells how far the pool is past its total
+     *           or the filesystem past full, counting only the reservations
+     *           of this pool, so that a dump in flight in another pool does
+     *           not evict the dumps of this one.
+     *
+     *  @param[in] neededKb - Size to make available.
+     */
+    size_t shortfall(size_t neededKb) const;
+
+    /** @brief Space used by the pool, dumps in flight included, in
+     *         kilobytes.
+     */
+    size_t usage() const;
+
+    /** @brief Reserve space for a dump in flight
+     *  @details The reservation is the dump size predicted from the settled
+     *           dumps, capped to the size the dump is allowed.
+     *
+     *  @param[in] entryId - Id of the dump entry.
+     *  @param[in] allowedKb - Size the dump is allowed.
+     *
+     *  @returns the reserved size in kilobytes
+     */
+    size_t reserve(uint32_t entryId, size_t allowedKb);
+
+    /** @brief Release the reservation of a dump which ended
+     *  @param[in] entryId - Id of the dump entry.
+     */
+    void settle(uint32_t entryId);
+
+  private:
+    friend class StorageBudget;
+
+    /** @brief Reserved space the dumps in flight did not write yet */
+    size_t outstanding() const;
+
+    StorageBudget& budget;
+    std::string name;
+    std::filesystem::path dir;
+    /** @brief Filesystem of the dump directory */
+    dev_t device = 0;
+    size_t totalKb;
+    /** @brief Predicted size of the next dump */
+    size_t predictedKb;
+    /** @brief Reservations of the dumps in flight, by entry id */
+    std::map<uint32_t, size_t> reservations;
+};
+
+/** @class StorageBudget
+ *
+ *  @brief Storage shared by the dump managers of the process.
+ */
+class StorageBudget
+{
+  public:
+    StorageBudget(const StorageBudget&) = delete;
+    StorageBudget& operator=(const StorageBudget&) = delete;
+    StorageBudget(StorageBudget&&) = delete;
+    StorageBudget& operator=(StorageBudget&&) = delete;
+    ~StorageBudget() = default;
+
+    /** @brief Budget of the dump manager process */
+    static StorageBudget& instance();
+
+    /** @brief Add the dump directory of a manager
+     *  @param[in] name - Name of the pool in the logs.
+     *  @param[in] dir - Dump directory, one subdirectory per entry id.
+     *  @param[in] totalKb - Space all the dumps of the pool may use.
+     *  @param[in] maxKb - Maximum size of a dump.
+     *
+     *  @returns the pool, valid for the life of the process
+     */
+    StoragePool& addPool(const std::string& name,
+                         const std::filesystem::path& dir, size_t totalKb,
+                         size_t maxKb);
+
+    /** @brief Reserved space not written yet by the dumps in flight on a
+     *         filesystem, in kilobytes.
+     */
+    size_t outstanding(dev_t device) const;
+
+  private:
+    StorageBudget() = default;
+
+    /** @brief Pools by name */
+    std::map<std::string, std::unique_ptr<StoragePool>> pools;
+};
+
+} // namespace dump
+} // namespace phosphor
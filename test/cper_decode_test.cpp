@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+#include "dump-extensions/faultlog-dump/cper_decode.hpp"
+#include "dump-extensions/faultlog-dump/cper_metadata.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using phosphor::dump::faultLog::decodeCper;
+using phosphor::dump::faultLog::parseCperMetadata;
+
+namespace
+{
+
+constexpr size_t headerSize = 128;
+constexpr size_t descriptorSize = 72;
+constexpr size_t nvidiaBodySize = 32 + 16;
+
+/** @brief GUIDs as laid out in a record */
+constexpr uint8_t cmcNotification[16] = {0xb1, 0x8b, 0xce, 0x2d, 0xd7, 0xbd,
+                                         0x0e, 0x45, 0xb9, 0xad, 0x9c, 0xf4,
+                                         0xeb, 0xd4, 0xf8, 0x90};
+constexpr uint8_t nvidiaSection[16] = {0xf2, 0x44, 0x52, 0x6d, 0x12, 0x27,
+                                       0xec, 0x11, 0xbe, 0xa7, 0xcb, 0x3f,
+                                       0xdb, 0x95, 0xc7, 0x86};
+
+template <typename T>
+void put(std::vector<uint8_t>& data, size_t offset, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        data[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+/** @brief Fatal CMC record with one NVIDIA section of one register */
+std::vector<uint8_t> nvidiaRecord()
+{
+    auto sectionOffset = headerSize + descriptorSize;
+    std::vector<uint8_t> record(sectionOffset + nvidiaBodySize);
+
+    std::memcpy(record.data(), "CPER", 4);
+    put<uint16_t>(record, 10, 1);
+    put<uint32_t>(record, 12, 1);
+    put<uint32_t>(record, 20, record.size());
+    std::memcpy(record.data() + 80, cmcNotification, 16);
+
+    auto descriptor = headerSize;
+    put<uint32_t>(record, descriptor, sectionOffset);
+    put<uint32_t>(record, descriptor + 4, nvidiaBodySize);
+    std::memcpy(record.data() + descriptor + 16, nvidiaSection, 16);
+    put<uint32_t>(record, descriptor + 48, 1);
+    std::memcpy(record.data() + descriptor + 52, "GPU0", 4);
+
+    auto body = sectionOffset;
+    std::memcpy(record.data() + body, "DCC-ECC", 7);
+    record[body + 20] = 1;
+    record[body + 21] = 1;
+    record[body + 22] = 1;
+    put<uint64_t>(record, body + 32, 0x1000);
+    put<uint64_t>(record, body + 40, 0xdead);
+    return record;
+}
+
+} // namespace
+
+TEST(CperDecode, RoundTrip)
+{
+    auto decoded = decodeCper(nvidiaRecord());
+    ASSERT_TRUE(decoded.has_value());
+
+    const auto& section = (*decoded)["Sections"][0];
+    EXPECT_EQ(section["SectionDescriptor"]["FRUText"], "GPU0");
+    EXPECT_EQ(section["Section"]["Registers"][0]["Value"], 0xdead);
+
+    std::istringstream stream(decoded->dump(4));
+    auto metadata = parseCperMetadata(stream);
+    EXPECT_EQ(metadata.notificationType, "CMC");
+    EXPECT_EQ(metadata.sectionType, "NVIDIA");
+    EXPECT_EQ(metadata.severity, "Fatal");
+    EXPECT_EQ(metadata.nvipSignature, "DCC-ECC");
+    EXPECT_EQ(metadata.nvSocketNumber, "1");
+    EXPECT_EQ(metadata.pcieVendorID, "NA");
+}
+
+TEST(CperDecode, TruncatedHeader)
+{
+    auto record = nvidiaRecord();
+    record.resize(headerSize - 1);
+    EXPECT_FALSE(decodeCper(record).has_value());
+}
+
+TEST(CperDecode, NotACper)
+{
+    auto record = nvidiaRecord();
+    record[0] = 'X';
+    EXPECT_FALSE(decodeCper(record).has_value());
+}
+
+TEST(CperDecode, SectionCountOverflowsRecord)
+{
+    auto record = nvidiaRecord();
+    put<uint16_t>(record, 10, 0xffff);
+    EXPECT_FALSE(decodeCper(record).has_value());
+}
+
+TEST(CperDecode, SectionOffsetOutOfRange)
+{
+    auto record = nvidiaRecord();
+    put<uint32_t>(record, headerSize, record.size() + 1);
+    EXPECT_FALSE(decodeCper(record).has_value());
+}
+
+TEST(CperDecode, SectionLengthOutOfRange)
+{
+    auto record = nvidiaRecord();
+    put<uint32_t>(record, headerSize + 4, 0xffffffff);
+    EXPECT_FALSE(decodeCper(record).has_value());
+}
+
+TEST(CperDecode, NonAsciiFruText)
+{
+    auto record = nvidiaRecord();
+    const uint8_t fruText[] = {'G', 0xc3, 'P', 0xff, 'U', 0x01};
+    std::memcpy(record.data() + headerSize + 52, fruText, sizeof(fruText));
+
+    auto decoded = decodeCper(record);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ((*decoded)["Sections"][0]["SectionDescriptor"]["FRUText"],
+              "GPU");
+    EXPECT_NO_THROW(decoded->dump(4));
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Compares the faultlog metadata extraction building the decoded.json
+// document with the streaming parser, on the CPER samples given as arguments
+// (test/cper/*.json by default) and on a large generated CPER.
+
+#include "cper_metadata_dom.hpp"
+#include "dump-extensions/faultlog-dump/cper_metadata.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using phosphor::dump::faultLog::parseCperMetadata;
+
+namespace
+{
+
+/** @brief Decoded CPER with a large register dump in each of its sections */
+std::string largeCper(const std::string& sample)
+{
+    auto doc = nlohmann::json::parse(sample);
+    auto section = doc["Sections"][0];
+    auto& registers = section["Section"]["Registers"];
+    for (uint64_t i = 0; i < 20000; ++i)
+    {
+        registers.push_back({{"Address", 0x5c0000000 + i * 8}, {"Value", i}});
+    }
+    doc["Sections"] = nlohmann::json::array({section, section, section});
+    doc["Header"]["SectionCount"] = 3;
+    return doc.dump(4);
+}
+
+template <typename Parse>
+double measure(const std::string& content, size_t iterations, Parse parse)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        std::istringstream stream(content);
+        auto metadata = parse(stream);
+        if (metadata.notificationType.empty())
+        {
+            std::fprintf(stderr, "empty notification type\n");
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void run(const std::string& name, const std::string& content,
+         size_t iterations)
+{
+    auto dom = measure(content, iterations, parseCperMetadataDom);
+    auto sax = measure(content, iterations, parseCperMetadata);
+    std::printf("%-24s %9zu bytes  document %10.1f us  stream %10.1f us\n",
+                name.c_str(), content.size(), dom, sax);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> samples(argv + 1, argv + argc);
+    if (samples.empty())
+    {
+        samples = {"cper/nvidia.json", "cper/pcie.json",
+                   "cper/multi_section.json"};
+    }
+
+    for (const auto& sample : samples)
+    {
+        std::ifstream file(sample);
+        if (!file.is_open())
+        {
+            std::fprintf(stderr, "can not open %s\n", sample.c_str());
+            return 1;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        run(sample, content.str(), 2000);
+
+        if (&sample == &samples.front())
+        {
+            run("large (" + sample + ")", largeCper(content.str()), 20);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+// Metadata extraction of the faultlog entries before the streaming parser,
+// building the decoded.json document. Reference of the tests and benchmark.
+#pragma once
+
+#include "dump-extensions/faultlog-dump/cper_metadata.hpp"
+
+#include <istream>
+#include <nlohmann/json.hpp>
+
+inline phosphor::dump::faultLog::CperMetadata
+    parseCperMetadataDom(std::istream& decoded)
+{
+    using json = nlohmann::json;
+    phosphor::dump::faultLog::CperMetadata m;
+
+    json jsonData = json::parse(decoded, nullptr, false);
+    if (jsonData.is_discarded() || !jsonData.contains("Header"))
+    {
+        return m;
+    }
+    const json& hdr = jsonData["Header"];
+    if (hdr.contains("NotificationType"))
+        m.notificationType = hdr["NotificationType"];
+    if (!hdr.contains("SectionCount") || !jsonData.contains("Sections") ||
+        !jsonData["Sections"].is_array() || jsonData["Sections"].empty())
+    {
+        return m;
+    }
+
+    const json& toLog = jsonData["Sections"][0];
+    if (!toLog.contains("SectionDescriptor"))
+    {
+        return m;
+    }
+    const json& descToLog = toLog["SectionDescriptor"];
+    if (descToLog.contains("SectionType"))
+        m.sectionType = descToLog["SectionType"];
+    if (descToLog.contains("FRUId"))
+        m.fruid = descToLog["FRUId"];
+    if (descToLog.contains("SectionSeverity"))
+        m.severity = descToLog["SectionSeverity"];
+    if (!toLog.contains("Section"))
+    {
+        return m;
+    }
+
+    const json& sectionToLog = toLog["Section"];
+    if (sectionToLog.contains("IPSignature"))
+        m.nvipSignature = sectionToLog["IPSignature"];
+    if (sectionToLog.contains("Severity"))
+        m.nvSeverity = sectionToLog["Severity"];
+    if (sectionToLog.contains("SocketNumber"))
+        m.nvSocketNumber = sectionToLog["SocketNumber"].dump();
+    if (!sectionToLog.contains("DeviceID"))
+    {
+        return m;
+    }
+
+    const json& devID = sectionToLog["DeviceID"];
+    if (devID.contains("VendorID"))
+        m.pcieVendorID = devID["VendorID"];
+    if (devID.contains("DeviceID"))
+        m.pcieDeviceID = devID["DeviceID"];
+    if (devID.contains("ClassCode"))
+        m.pcieClassCode = devID["ClassCode"];
+    if (devID.contains("FunctionNumber"))
+        m.pcieFunctionNumber = devID["FunctionNumber"];
+    if (devID.contains("DeviceNumber"))
+        m.pcieDeviceNumber = devID["DeviceNumber"];
+    if (devID.contains("SegmentNumber"))
+        m.pcieSegmentNumber = devID["SegmentNumber"];
+    if (devID.contains("DeviceBusNumber"))
+        m.pcieDeviceBusNumber = devID["DeviceBusNumber"];
+    if (devID.contains("SecondaryBusNumber"))
+        m.pcieSecondaryBusNumber = devID["SecondaryBusNumber"];
+    if (devID.contains("SlotNumber"))
+        m.pcieSlotNumber = devID["SlotNumber"].dump();
+    return m;
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+#include "cper_metadata_dom.hpp"
+#include "dump-extensions/faultlog-dump/cper_metadata.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using phosphor::dump::faultLog::CperMetadata;
+using phosphor::dump::faultLog::parseCperMetadata;
+using phosphor::dump::faultLog::readCperMetadata;
+
+namespace
+{
+
+CperMetadata parse(const std::string& decoded)
+{
+    std::istringstream stream(decoded);
+    return parseCperMetadata(stream);
+}
+
+void expectEqual(const CperMetadata& l, const CperMetadata& r)
+{
+    EXPECT_EQ(l.notificationType, r.notificationType);
+    EXPECT_EQ(l.sectionType, r.sectionType);
+    EXPECT_EQ(l.fruid, r.fruid);
+    EXPECT_EQ(l.severity, r.severity);
+    EXPECT_EQ(l.nvipSignature, r.nvipSignature);
+    EXPECT_EQ(l.nvSeverity, r.nvSeverity);
+    EXPECT_EQ(l.nvSocketNumber, r.nvSocketNumber);
+    EXPECT_EQ(l.pcieVendorID, r.pcieVendorID);
+    EXPECT_EQ(l.pcieDeviceID, r.pcieDeviceID);
+    EXPECT_EQ(l.pcieClassCode, r.pcieClassCode);
+    EXPECT_EQ(l.pcieFunctionNumber, r.pcieFunctionNumber);
+    EXPECT_EQ(l.pcieDeviceNumber, r.pcieDeviceNumber);
+    EXPECT_EQ(l.pcieSegmentNumber, r.pcieSegmentNumber);
+    EXPECT_EQ(l.pcieDeviceBusNumber, r.pcieDeviceBusNumber);
+    EXPECT_EQ(l.pcieSecondaryBusNumber, r.pcieSecondaryBusNumber);
+    EXPECT_EQ(l.pcieSlotNumber, r.pcieSlotNumber);
+}
+
+} // namespace
+
+TEST(CperMetadata, MatchesDocumentParsing)
+{
+    for (const auto* sample :
+         {"cper/nvidia.json", "cper/pcie.json", "cper/multi_section.json"})
+    {
+        SCOPED_TRACE(sample);
+        std::ifstream file(sample);
+        ASSERT_TRUE(file.is_open());
+        std::stringstream content;
+        content << file.rdbuf();
+
+        std::istringstream stream(content.str());
+        expectEqual(parse(content.str()), parseCperMetadataDom(stream));
+    }
+}
+
+TEST(CperMetadata, NvidiaSection)
+{
+    auto metadata = readCperMetadata("cper/nvidia.json");
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->notificationType, "CMC");
+    EXPECT_EQ(metadata->sectionType, "NVIDIA");
+    EXPECT_EQ(metadata->severity, "Fatal");
+    EXPECT_EQ(metadata->nvipSignature, "DCC-ECC");
+    EXPECT_EQ(metadata->nvSocketNumber, "1");
+    EXPECT_EQ(metadata->pcieVendorID, "NA");
+}
+
+TEST(CperMetadata, PcieSection)
+{
+    auto metadata = readCperMetadata("cper/pcie.json");
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->sectionType, "PCIe");
+    EXPECT_EQ(metadata->pcieVendorID, "0x10de");
+    EXPECT_EQ(metadata->pcieSlotNumber, "3");
+    EXPECT_EQ(metadata->nvipSignature, "NA");
+}
+
+TEST(CperMetadata, OnlyFirstSection)
+{
+    auto metadata = readCperMetadata("cper/multi_section.json");
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->notificationType, "MCE");
+    EXPECT_EQ(metadata->sectionType, "NVIDIA");
+    EXPECT_EQ(metadata->pcieVendorID, "NA");
+}
+
+TEST(CperMetadata, SectionsNeedSectionCount)
+{
+    auto metadata = parse(R"({"Header": {"NotificationType": "CMC"},
+        "Sections": [{"SectionDescriptor": {"SectionType": "NVIDIA"}}]})");
+    EXPECT_EQ(metadata.notificationType, "CMC");
+    EXPECT_EQ(metadata.sectionType, "NA");
+}
+
+TEST(CperMetadata, SectionNeedsDescriptor)
+{
+    auto metadata = parse(R"({"Header": {"SectionCount": 1},
+        "Sections": [{"Section": {"IPSignature": "DCC-ECC"}}]})");
+    EXPECT_EQ(metadata.nvipSignature, "NA");
+}
+
+TEST(CperMetadata, HeaderAfterSections)
+{
+    auto metadata = parse(R"({"Sections": [{"SectionDescriptor":
+        {"SectionType": "PCIe"}}], "Header": {"SectionCount": 1,
+        "NotificationType": "PCIe"}})");
+    EXPECT_EQ(metadata.notificationType, "PCIe");
+    EXPECT_EQ(metadata.sectionType, "PCIe");
+}
+
+TEST(CperMetadata, InvalidDocument)
+{
+    auto metadata = parse(R"({"Header": {"NotificationType": "CMC", )");
+    EXPECT_EQ(metadata.notificationType, "NA");
+}
+
+TEST(CperMetadata, StopsAfterFirstSection)
+{
+    // Garbage past the first section is not read
+    auto metadata = parse(R"({"Header": {"SectionCount": 2,
+        "NotificationType": "CMC"}, "Sections": [{"SectionDescriptor":
+        {"SectionType": "NVIDIA"}}, {not json)");
+    EXPECT_EQ(metadata.sectionType, "NVIDIA");
+}
+
+TEST(CperMetadata, MissingFile)
+{
+    EXPECT_FALSE(readCperMetadata("cper/missing.json").has_value());
+}
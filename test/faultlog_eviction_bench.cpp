@@ -0,0 +1,107 @@
+// Compares the faultlog dump rotation deleting one dump and walking the dump
+// directory after each deletion with the batch eviction from entry sizes.
+
+#include "storage_budget.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using phosphor::dump::selectEvictions;
+using phosphor::dump::StorageBudget;
+using phosphor::dump::StoragePool;
+
+namespace
+{
+
+constexpr size_t ENTRIES = 5000;
+constexpr size_t DUMP_SIZE = 4096;
+// Total the dumps may use, the rotation has to delete a fifth of them
+constexpr size_t TOTAL_KB = ENTRIES * DUMP_SIZE / 1024 * 4 / 5;
+constexpr size_t MIN_SPACE_KB = 4;
+
+/** @brief Create the dump directories, one CPER file each */
+std::vector<std::pair<uint32_t, size_t>> populate(const fs::path& root)
+{
+    fs::remove_all(root);
+    std::vector<std::pair<uint32_t, size_t>> sizes;
+    std::string data(DUMP_SIZE, 'c');
+    for (uint32_t id = 1; id <= ENTRIES; ++id)
+    {
+        auto dir = root / std::to_string(id);
+        fs::create_directories(dir);
+        std::ofstream(dir / "faultlog.cper") << data;
+        sizes.emplace_back(id, DUMP_SIZE / 1024);
+    }
+    return sizes;
+}
+
+/** @brief Rotation before the batch eviction */
+size_t evictOneByOne(const fs::path& root, StoragePool& pool,
+                     const std::vector<std::pair<uint32_t, size_t>>& sizes)
+{
+    size_t deleted = 0;
+    for (const auto& [id, size] : sizes)
+    {
+        if (pool.available() >= MIN_SPACE_KB)
+        {
+            break;
+        }
+        fs::remove_all(root / std::to_string(id));
+        ++deleted;
+    }
+    return deleted;
+}
+
+/** @brief Rotation of limitTotalDumpSize() */
+size_t evictBatch(const fs::path& root, StoragePool& pool,
+                  const std::vector<std::pair<uint32_t, size_t>>& sizes)
+{
+    auto victims = selectEvictions(sizes, pool.shortfall(MIN_SPACE_KB));
+    for (auto id : victims)
+    {
+        fs::remove_all(root / std::to_string(id));
+    }
+    if (pool.available() < MIN_SPACE_KB)
+    {
+        std::fprintf(stderr, "batch eviction did not free enough space\n");
+    }
+    return victims.size();
+}
+
+template <typename Evict>
+void run(const char* name, const fs::path& root, StoragePool& pool,
+         Evict evict)
+{
+    auto sizes = populate(root);
+    auto start = std::chrono::steady_clock::now();
+    auto deleted = evict(root, pool, sizes);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::printf("%-12s %zu entries, %zu deleted in %lld ms\n", name, ENTRIES,
+                deleted, static_cast<long long>(elapsed.count()));
+}
+
+} // namespace
+
+int main()
+{
+    auto root = fs::temp_directory_path() /
+                ("faultlog_eviction_bench." + std::to_string(getpid()));
+
+    auto& pool = StorageBudget::instance().addPool("faultlog", root, TOTAL_KB,
+                                                   DUMP_SIZE / 1024);
+
+    run("one-by-one", root, pool, evictOneByOne);
+    run("batch", root, pool, evictBatch);
+
+    fs::remove_all(root);
+    return 0;
+}
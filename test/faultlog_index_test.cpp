@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: Apache-2.0
+#include "dump-extensions/faultlog-dump/faultlog_index.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using phosphor::dump::faultLog::CperMetadata;
+using phosphor::dump::faultLog::FaultLogIndex;
+using phosphor::dump::faultLog::FaultLogQuery;
+using phosphor::dump::faultLog::QuerySort;
+
+namespace
+{
+
+CperMetadata metadata(const std::string& sectionType,
+                      const std::string& severity)
+{
+    CperMetadata cper;
+    cper.sectionType = sectionType;
+    cper.severity = severity;
+    return cper;
+}
+
+/** @brief Entries 1 to 6, their timestamps not in the id order */
+FaultLogIndex sampleIndex()
+{
+    FaultLogIndex index;
+    index.insert(1, 500, metadata("NVIDIA", "Fatal"));
+    index.insert(2, 100, metadata("PCIe", "Fatal"));
+    index.insert(3, 400, metadata("NVIDIA", "Corrected"));
+    index.insert(4, 200, metadata("NVIDIA", "Fatal"));
+    index.insert(5, 600, metadata("PCIe", "Corrected"));
+    index.insert(6, 300, metadata("NVIDIA", "Fatal"));
+    return index;
+}
+
+std::vector<uint32_t> ids(const FaultLogIndex& index,
+                          const FaultLogQuery& query)
+{
+    std::vector<uint32_t> found;
+    for (const auto* record : index.query(query).second)
+    {
+        found.push_back(record->id);
+    }
+    return found;
+}
+
+} // namespace
+
+TEST(FaultLogIndex, AllEntriesById)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(index.query(query).first, 6u);
+}
+
+TEST(FaultLogIndex, FilterIntersection)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.filters = {{"SectionType", "NVIDIA"}, {"Severity", "Fatal"}};
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{1, 4, 6}));
+
+    query.filters["SectionType"] = "PCIe";
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{2}));
+}
+
+TEST(FaultLogIndex, UnknownValueMatchesNothing)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.filters = {{"SectionType", "ARM"}};
+    auto [total, page] = index.query(query);
+    EXPECT_EQ(total, 0u);
+    EXPECT_TRUE(page.empty());
+}
+
+TEST(FaultLogIndex, TimeRange)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.since = 200;
+    query.until = 400;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{3, 4, 6}));
+
+    query.filters = {{"Severity", "Fatal"}};
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{4, 6}));
+}
+
+TEST(FaultLogIndex, SortByTimestamp)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.sort = QuerySort::Timestamp;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{2, 4, 6, 3, 1, 5}));
+
+    query.filters = {{"SectionType", "NVIDIA"}};
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{4, 6, 3, 1}));
+}
+
+TEST(FaultLogIndex, Descending)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.descending = true;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{6, 5, 4, 3, 2, 1}));
+
+    query.sort = QuerySort::Timestamp;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{5, 1, 3, 6, 4, 2}));
+}
+
+TEST(FaultLogIndex, Paging)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.offset = 2;
+    query.limit = 3;
+    auto [total, page] = index.query(query);
+    EXPECT_EQ(total, 6u);
+    ASSERT_EQ(page.size(), 3u);
+    EXPECT_EQ(page[0]->id, 3u);
+    EXPECT_EQ(page[2]->id, 5u);
+
+    query.offset = 5;
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{6}));
+
+    query.offset = 10;
+    EXPECT_EQ(index.query(query).first, 6u);
+    EXPECT_TRUE(ids(index, query).empty());
+}
+
+TEST(FaultLogIndex, UnknownProperty)
+{
+    auto index = sampleIndex();
+    FaultLogQuery query;
+    query.filters = {{"Color", "Red"}};
+    EXPECT_THROW(index.query(query), std::invalid_argument);
+}
+
+TEST(FaultLogIndex, InsertReplacesAndEraseRemoves)
+{
+    auto index = sampleIndex();
+    index.insert(1, 700, metadata("PCIe", "Fatal"));
+    index.erase(2);
+
+    FaultLogQuery query;
+    query.filters = {{"SectionType", "PCIe"}};
+    EXPECT_EQ(ids(index, query), (std::vector<uint32_t>{1, 5}));
+    ASSERT_NE(index.find(1), nullptr);
+    EXPECT_EQ(index.find(1)->timestamp, 700u);
+    EXPECT_EQ(index.find(2), nullptr);
+}
@@ -0,0 +1,509 @@
+// SPDX-License-Identifier: Apache-2.0
+/**
+ * @file nsm_mock_service.cpp
+ * @brief Stand-in for the dump interfaces of xyz.openbmc_project.NSM, used to
+ *        run and benchmark nsm-net-dump-tool without devices.
+ *
+ * Every device serves `segments` records of `size` bytes, each one being
+ * ready `latency` ms after it is requested. Errors can be injected in the
+ * record preparation and in the method calls. The calls received are
+ * counted and returned by the GetStats method of the mock interface.
+ */
+#include <getopt.h>
+#include <sys/mman.h>
+#include <systemd/sd-bus.h>
+#include <systemd/sd-event.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+constexpr auto NSM_SERVICE = "xyz.openbmc_project.NSM";
+constexpr auto DEBUG_INFO_INTERFACE = "com.nvidia.Dump.DebugInfo";
+constexpr auto LOG_INFO_INTERFACE = "com.nvidia.Dump.LogInfo";
+constexpr auto ERASE_INTERFACE = "com.nvidia.Dump.Erase";
+constexpr auto MOCK_PATH = "/xyz/openbmc_project/nsm_mock";
+constexpr auto MOCK_INTERFACE = "com.nvidia.Dump.Mock";
+
+struct Config
+{
+    uint64_t segmentSize = 1024 * 1024;
+    uint64_t segments = 16;
+    uint64_t latencyMs = 50;
+    unsigned recordErrorPercent = 0;
+    unsigned callErrorPercent = 0;
+    bool signals = true;
+    unsigned devices = 4;
+};
+
+Config config;
+sd_bus* bus = nullptr;
+sd_event* event = nullptr;
+std::mt19937 rng(1);
+
+/* Counters returned by GetStats */
+std::map<std::string, uint64_t> stats;
+std::set<std::string> senders;
+
+/* Content of the records, repeated to the segment size */
+std::vector<char> pattern(64 * 1024);
+
+bool inject(unsigned percent)
+{
+    return percent && (rng() % 100) < percent;
+}
+
+/** @brief Replace a pending timer */
+void setTimer(sd_event_source*& source, sd_event_time_handler_t handler,
+              void* userdata)
+{
+    sd_event_source_unref(source);
+    source = nullptr;
+    sd_event_add_time_relative(event, &source, CLOCK_MONOTONIC,
+                               config.latencyMs * 1000, 0, handler, userdata);
+}
+
+/**
+ * @brief Records of one interface of a device, DebugInfo or LogInfo
+ */
+struct Collector
+{
+    std::string path;
+    std::string interface;
+    std::string status;
+    uint64_t handle = 0;
+    uint64_t nextRecord = 0;
+    int fd = -1;
+    sd_event_source* timer = nullptr;
+
+    void setStatus(const std::string& value)
+    {
+        status = interface + ".OperationStatus." + value;
+        if (config.signals)
+        {
+            sd_bus_emit_properties_changed(bus, path.c_str(),
+                                           interface.c_str(), "Status",
+                                           nullptr);
+            stats["signals"]++;
+        }
+    }
+
+    void reset()
+    {
+        sd_event_source_unref(timer);
+        timer = nullptr;
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+        nextRecord = 0;
+        status = interface + ".OperationStatus.Success";
+    }
+};
+
+struct Eraser
+{
+    std::string path;
+    std::string status = "com.nvidia.Dump.Erase.EraseStatus.DataErased";
+    sd_event_source* timer = nullptr;
+};
+
+std::list<Collector> collectors;
+std::list<Eraser> erasers;
+
+int recordReady(sd_event_source*, uint64_t, void* userdata)
+{
+    auto& collector = *static_cast<Collector*>(userdata);
+    if (inject(config.recordErrorPercent))
+    {
+        stats["record_errors"]++;
+        collector.setStatus("Error");
+        return 0;
+    }
+
+    if (collector.fd >= 0)
+    {
+        close(collector.fd);
+    }
+    collector.fd = memfd_create("nsm-record", MFD_CLOEXEC);
+    for (uint64_t done = 0; collector.fd >= 0 && done < config.segmentSize;)
+    {
+        auto n = write(collector.fd, pattern.data(),
+                       std::min<uint64_t>(pattern.size(),
+                                          config.segmentSize - done));
+        if (n <= 0)
+        {
+            break;
+        }
+        done += n;
+    }
+    if (collector.fd < 0 || lseek(collector.fd, 0, SEEK_SET) < 0)
+    {
+        collector.setStatus("Error");
+        return 0;
+    }
+
+    collector.nextRecord = collector.handle + 1 < config.segments
+                               ? collector.handle + 1
+                               : 0;
+    stats["records"]++;
+    collector.setStatus("Success");
+    return 0;
+}
+
+int requestRecord(sd_bus_message* msg, void* userdata, sd_bus_error*)
+{
+    auto& collector = *static_cast<Collector*>(userdata);
+    int r;
+    if (collector.interface == LOG_INFO_INTERFACE)
+    {
+        r = sd_bus_message_read(msg, "t", &collector.handle);
+    }
+    else
+    {
+        const char* type = nullptr;
+        r = sd_bus_message_read(msg, "st", &type, &collector.handle);
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+    if (inject(config.callErrorPercent))
+    {
+        stats["call_errors"]++;
+        return sd_bus_reply_method_errorf(msg, SD_BUS_ERROR_FAILED,
+                                          "Injected error");
+    }
+
+    collector.setStatus("InProgress");
+    setTimer(collector.timer, recordReady, &collector);
+    return sd_bus_reply_method_return(msg, nullptr);
+}
+
+int getStatus(sd_bus*, const char*, const char*, const char*,
+              sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(
+        reply, "s", static_cast<Collector*>(userdata)->status.c_str());
+}
+
+int getFd(sd_bus*, const char*, const char*, const char*,
+          sd_bus_message* reply, void* userdata, sd_bus_error* error)
+{
+    auto& collector = *static_cast<Collector*>(userdata);
+    if (collector.fd < 0)
+    {
+        return sd_bus_error_set_errno(error, ENODATA);
+    }
+    return sd_bus_message_append(reply, "h", collector.fd);
+}
+
+int getNextRecordHandle(sd_bus*, const char*, const char*, const char*,
+                        sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(
+        reply, "t", static_cast<Collector*>(userdata)->nextRecord);
+}
+
+int eraseDone(sd_event_source*, uint64_t, void* userdata)
+{
+    static_cast<Eraser*>(userdata)->status =
+        "com.nvidia.Dump.Erase.EraseStatus.DataErased";
+    return 0;
+}
+
+int erase(sd_bus_message* msg, void* userdata, sd_bus_error*)
+{
+    auto& eraser = *static_cast<Eraser*>(userdata);
+    const char* type = nullptr;
+    auto r = sd_bus_message_read(msg, "s", &type);
+    if (r < 0)
+    {
+        return r;
+    }
+    if (inject(config.callErrorPercent))
+    {
+        stats["call_errors"]++;
+        return sd_bus_reply_method_errorf(msg, SD_BUS_ERROR_FAILED,
+                                          "Injected error");
+    }
+    eraser.status = "com.nvidia.Dump.Erase.EraseStatus.DataEraseInProgress";
+    setTimer(eraser.timer, eraseDone, &eraser);
+    return sd_bus_reply_method_return(msg, nullptr);
+}
+
+int getEraseStatus(sd_bus*, const char*, const char*, const char*,
+                   sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(
+        reply, "(ss)", "com.nvidia.Dump.Erase.OperationStatus.Success",
+        static_cast<Eraser*>(userdata)->status.c_str());
+}
+
+int getStats(sd_bus_message* msg, void*, sd_bus_error*)
+{
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_message_new_method_return(msg, &reply);
+    if (r >= 0)
+    {
+        stats["connections"] = senders.size();
+        r = sd_bus_message_open_container(reply, 'a', "{st}");
+        for (auto it = stats.begin(); r >= 0 && it != stats.end(); ++it)
+        {
+            r = sd_bus_message_append(reply, "{st}", it->first.c_str(),
+                                      it->second);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(reply);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_send(nullptr, reply, nullptr);
+        }
+    }
+    sd_bus_message_unref(reply);
+    return r;
+}
+
+int reset(sd_bus_message* msg, void*, sd_bus_error*)
+{
+    for (auto& collector : collectors)
+    {
+        collector.reset();
+    }
+    for (auto& eraser : erasers)
+    {
+        sd_event_source_unref(eraser.timer);
+        eraser.timer = nullptr;
+        eraser.status = "com.nvidia.Dump.Erase.EraseStatus.DataErased";
+    }
+    stats.clear();
+    senders.clear();
+    return sd_bus_reply_method_return(msg, nullptr);
+}
+
+/** @brief Count the calls received, whoever handles them */
+int countMessage(sd_bus_message* msg, void*, sd_bus_error*)
+{
+    uint8_t type = 0;
+    sd_bus_message_get_type(msg, &type);
+    auto interface = sd_bus_message_get_interface(msg);
+    if (type != SD_BUS_MESSAGE_METHOD_CALL ||
+        (interface && strcmp(interface, MOCK_INTERFACE) == 0))
+    {
+        return 0;
+    }
+    auto member = sd_bus_message_get_member(msg);
+    stats[std::string("calls.") + (member ? member : "")]++;
+    stats["calls.total"]++;
+    if (auto sender = sd_bus_message_get_sender(msg))
+    {
+        senders.insert(sender);
+    }
+    return 0;
+}
+
+const sd_bus_vtable collectorVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("GetDebugInfo", "st", "", requestRecord,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_PROPERTY("Status", "s", getStatus, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_PROPERTY("Fd", "h", getFd, 0, SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+    SD_BUS_PROPERTY("NextRecordHandle", "t", getNextRecordHandle, 0,
+                    SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+    SD_BUS_VTABLE_END};
+
+const sd_bus_vtable logVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("GetLogInfo", "t", "", requestRecord,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_PROPERTY("Status", "s", getStatus, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_PROPERTY("Fd", "h", getFd, 0, SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+    SD_BUS_PROPERTY("NextRecordHandle", "t", getNextRecordHandle, 0,
+                    SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+    SD_BUS_VTABLE_END};
+
+const sd_bus_vtable eraseVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("EraseDebugInfo", "s", "", erase,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_PROPERTY("EraseDebugInfoStatus", "(ss)", getEraseStatus, 0,
+                    SD_BUS_VTABLE_PROPERTY_EXPLICIT),
+    SD_BUS_VTABLE_END};
+
+const sd_bus_vtable mockVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("GetStats", "", "a{st}", getStats,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_METHOD("Reset", "", "", reset, SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END};
+
+int addCollector(const std::string& path, const char* interface)
+{
+    auto& collector = collectors.emplace_back();
+    collector.path = path;
+    collector.interface = interface;
+    collector.reset();
+    return sd_bus_add_object_vtable(
+        bus, nullptr, path.c_str(), interface,
+        strcmp(interface, LOG_INFO_INTERFACE) == 0 ? logVtable
+                                                   : collectorVtable,
+        &collector);
+}
+
+int addEraser(const std::string& path)
+{
+    auto& eraser = erasers.emplace_back();
+    eraser.path = path;
+    return sd_bus_add_object_vtable(bus, nullptr, path.c_str(),
+                                    ERASE_INTERFACE, eraseVtable, &eraser);
+}
+
+/** @brief Serve the objects nsm-net-dump-tool collects from */
+int addDevices()
+{
+    int r = 0;
+    for (unsigned i = 0; r >= 0 && i < config.devices; i++)
+    {
+        auto switchPath =
+            "/xyz/openbmc_project/inventory/system/fabrics/"
+            "HGX_NVLinkFabric_0/Switches/NVSwitch_" +
+            std::to_string(i);
+        r = addCollector(switchPath, DEBUG_INFO_INTERFACE);
+        if (r >= 0)
+        {
+            r = addEraser(switchPath);
+        }
+        if (r >= 0)
+        {
+            r = addCollector("/xyz/openbmc_project/inventory/system/"
+                             "processors/GPU_SXM_" +
+                                 std::to_string(i),
+                             DEBUG_INFO_INTERFACE);
+        }
+    }
+    std::string nicPath = "/xyz/openbmc_project/inventory/system/chassis/"
+                          "HGX_NVLinkManagementNIC_0/NetworkAdapters/"
+                          "NVLinkManagementNIC_0";
+    if (r >= 0)
+    {
+        r = addCollector(nicPath, DEBUG_INFO_INTERFACE);
+    }
+    if (r >= 0)
+    {
+        r = addCollector(nicPath, LOG_INFO_INTERFACE);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_add_object_vtable(bus, nullptr, MOCK_PATH, MOCK_INTERFACE,
+                                     mockVtable, nullptr);
+    }
+    return r;
+}
+
+void usage()
+{
+    printf("Usage: nsm_mock_service [options]\n");
+    printf("  -s <bytes>      size of a record, default %lu\n",
+           static_cast<unsigned long>(config.segmentSize));
+    printf("  -n <count>      records of a dump, default %lu\n",
+           static_cast<unsigned long>(config.segments));
+    printf("  -l <ms>         time to prepare a record, default %lu\n",
+           static_cast<unsigned long>(config.latencyMs));
+    printf("  -e <percent>    records ending with an error Status\n");
+    printf("  -m <percent>    method calls failing\n");
+    printf("  -q              no PropertiesChanged signals, clients poll\n");
+    printf("  -d <count>      NVSwitches and GPUs, default %u\n",
+           config.devices);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "s:n:l:e:m:qd:h")) != -1)
+    {
+        switch (c)
+        {
+            case 's':
+                config.segmentSize = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'n':
+                config.segments = std::max(std::strtoull(optarg, nullptr, 0),
+                                           1ULL);
+                break;
+            case 'l':
+                config.latencyMs = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'e':
+                config.recordErrorPercent = std::atoi(optarg);
+                break;
+            case 'm':
+                config.callErrorPercent = std::atoi(optarg);
+                break;
+            case 'q':
+                config.signals = false;
+                break;
+            case 'd':
+                config.devices = std::atoi(optarg);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+
+    for (auto& byte : pattern)
+    {
+        byte = static_cast<char>(rng());
+    }
+
+    auto r = sd_event_default(&event);
+    if (r >= 0)
+    {
+        r = sd_bus_default(&bus);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_attach_event(bus, event, SD_EVENT_PRIORITY_NORMAL);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_add_filter(bus, nullptr, countMessage, nullptr);
+    }
+    if (r >= 0)
+    {
+        r = addDevices();
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_request_name(bus, NSM_SERVICE, 0);
+    }
+    if (r < 0)
+    {
+        fprintf(stderr, "nsm_mock_service: %s\n", strerror(-r));
+        return 1;
+    }
+
+    r = sd_event_loop(event);
+    sd_bus_flush_close_unref(bus);
+    sd_event_unref(event);
+    return r < 0 ? 1 : 0;
+}
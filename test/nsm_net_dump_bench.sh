@@ -0,0 +1,113 @@
+#!/bin/bash
+#
+# @brief Run nsm-net-dump-tool against nsm_mock_service on a private bus and
+#        report the segments per second, the CPU time of the tool and the
+#        D-Bus calls it made.
+#
+# Usage: nsm_net_dump_bench.sh <nsm-net-dump-tool> <nsm_mock_service>
+#            [<mock options>] [-- <tool options>]
+#
+# The target devices are taken from NSM_BENCH_TARGETS, all the devices the
+# mock serves by default.
+#
+
+tool=$1
+mock=$2
+if [ -z "$tool" ] || [ -z "$mock" ]; then
+    echo "Usage: $0 <nsm-net-dump-tool> <nsm_mock_service>" \
+        "[<mock options>] [-- <tool options>]"
+    exit 1
+fi
+shift 2
+
+mock_args=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    mock_args+=("$1")
+    shift
+done
+[ "$1" == "--" ] && shift
+tool_args=("$@")
+
+read -r -a targets <<< "${NSM_BENCH_TARGETS:-Net_NVSwitch_0 Net_NVSwitch_1 \
+Net_NVSwitch_2 Net_NVSwitch_3 Net_GPU_SXM_0 Net_GPU_SXM_1 Net_GPU_SXM_2 \
+Net_GPU_SXM_3 Net_NVLinkManagementNIC_0}"
+
+work_dir=$(mktemp -d)
+bus_pid=""
+mock_pid=""
+
+function cleanup()
+{
+    [ -n "$mock_pid" ] && kill "$mock_pid" 2> /dev/null
+    [ -n "$bus_pid" ] && kill "$bus_pid" 2> /dev/null
+    rm -rf "$work_dir"
+}
+trap cleanup EXIT
+
+# Private bus, used by both as their system bus
+dbus-daemon --session --fork --nopidfile \
+    --print-address=3 --print-pid=4 \
+    3> "$work_dir/bus_address" 4> "$work_dir/bus_pid"
+bus_pid=$(cat "$work_dir/bus_pid")
+address=$(head -n 1 "$work_dir/bus_address")
+if [ -z "$address" ]; then
+    echo "Failed to start the private bus"
+    exit 1
+fi
+export DBUS_SYSTEM_BUS_ADDRESS="$address"
+export DBUS_STARTER_BUS_TYPE=system
+
+"$mock" "${mock_args[@]}" &
+mock_pid=$!
+for _ in $(seq 50); do
+    busctl --address="$address" status xyz.openbmc_project.NSM \
+        > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+function mock_call()
+{
+    busctl --address="$address" call xyz.openbmc_project.NSM \
+        /xyz/openbmc_project/nsm_mock com.nvidia.Dump.Mock "$1"
+}
+
+if ! mock_call Reset > /dev/null; then
+    echo "nsm_mock_service is not running"
+    exit 1
+fi
+
+mkdir -p "$work_dir/dump"
+start=$(date +%s%N)
+"$tool" "${tool_args[@]}" "$work_dir/dump" "${targets[@]}" > /dev/null
+rc=$?
+end=$(date +%s%N)
+
+report="$work_dir/dump/Execution_Report.txt"
+segments=$(grep -o "Total number of segments: [0-9]*" "$report" |
+    awk '{ sum += $NF } END { print sum + 0 }')
+bytes=$(grep -o "Output file size: [0-9]*" "$report" |
+    awk '{ sum += $NF } END { print sum + 0 }')
+cpu=$(grep -o "CPU time: [0-9]*" "$report" | awk '{ print $NF }')
+wall=$(((end - start) / 1000000))
+
+echo "Targets: ${targets[*]}"
+echo "Tool exit code: $rc"
+echo "Segments: $segments"
+echo "Bytes: $bytes"
+echo "Wall time: $wall ms"
+echo "Tool CPU time: ${cpu:-unknown} ms"
+awk -v s="$segments" -v b="$bytes" -v t="$wall" 'BEGIN {
+    if (t > 0) {
+        printf "Segments per second: %.1f\n", s * 1000 / t
+        printf "Throughput: %.1f MiB/s\n", b * 1000 / t / 1048576
+    }
+}'
+
+# a{st} N "key" value ..., one counter per line
+echo "NSM D-Bus counters:"
+read -r -a stats <<< "$(mock_call GetStats)"
+for ((i = 2; i + 1 < ${#stats[@]}; i += 2)); do
+    echo "  ${stats[i]//\"/}: ${stats[i + 1]}"
+done
+
+exit $rc